@@ -29,6 +29,7 @@
 #include "wifi_manager.h"
 #include "audio_player.h"
 #include "station_manager.h"
+#include "station_prober.h"
 #include "web_server.h"
 #include "ui_manager.h"
 #include "sd_manager.h"
@@ -56,21 +57,26 @@ void setup() {
   Serial.println("[INIT] Initializing touch screen...");
   Touch.init();
   
-  // Initialize SD card
+  // Load configuration from flash (available without the SD card)
+  Serial.println("[INIT] Loading configuration...");
+  SDManager.loadCachedConfig();
+  
+  // Initialize WiFi manager and start associating in the background
+  Serial.println("[INIT] Initializing WiFi...");
+  WiFiManager.init();
+  WiFiManager.begin();
+  
+  // Initialize SD card (runs while WiFi connects)
   Serial.println("[INIT] Initializing SD card...");
   if (!SDManager.init()) {
     Serial.println("[ERROR] SD card initialization failed!");
-    Display.showError("SD Card Error", "Please insert SD card and restart");
-    while(1) delay(1000); // Halt
+    Display.showError("SD Card Error", "Continuing without SD card");
+    delay(2000);
   }
   
-  // Load configuration from SD
-  Serial.println("[INIT] Loading configuration...");
+  // SD card config is the editable copy and wins over flash
   SDManager.loadConfig();
-  
-  // Initialize WiFi manager
-  Serial.println("[INIT] Initializing WiFi...");
-  WiFiManager.init();
+  WiFiManager.reloadCredentials();
   
   // Check if WiFi credentials are stored
   if (!WiFiManager.hasCredentials()) {
@@ -96,10 +102,14 @@ void setup() {
   Serial.println("[INIT] Initializing station manager...");
   StationManager.init();
   StationManager.loadStations();
+  StationProber.init();
   
   // Initialize audio player
   Serial.println("[INIT] Initializing audio player...");
   AudioPlayer.init();
+  AudioPipeline.setBufferProfile(SDManager.getConfig().bufferProfile);
+  AudioPipeline.setEqualizer(SDManager.getConfig().eqBass, SDManager.getConfig().eqMid,
+                             SDManager.getConfig().eqTreble);
   
   // Initialize web server
   Serial.println("[INIT] Starting web server...");
@@ -140,6 +150,15 @@ void loop() {
       break;
       
     case STATE_PLAYING:
+      // Connection errors arrive asynchronously from the audio task
+      if (!AudioPlayer.isConnected() && AudioPlayer.getError().length() > 0) {
+        Display.showError("Playback Error", AudioPlayer.getError());
+        delay(3000);
+        currentState = previousState;
+        updateScreen();
+        break;
+      }
+      
       // Update player screen with metadata
       if (AudioPlayer.isPlaying()) {
         UIManager.updatePlayerScreen();
@@ -190,6 +209,10 @@ void handleTouch(TouchPoint point) {
       handleSettingsTouch(point);
       break;
       
+    case STATE_AUDIO_SETTINGS:
+      handleAudioSettingsTouch(point);
+      break;
+      
     case STATE_FOLDER_VIEW:
       handleFolderViewTouch(point);
       break;
@@ -339,13 +362,19 @@ void handlePlayerTouch(TouchPoint point) {
       break;
       
     case PLAYER_ACTION_NEXT:
-      // Next track (if supported by stream)
-      AudioPlayer.next();
+      // Next station in the current folder
+      showZappedStation(AudioPlayer.next());
       break;
       
     case PLAYER_ACTION_PREVIOUS:
-      // Previous track (if supported by stream)
-      AudioPlayer.previous();
+      // Previous station in the current folder
+      showZappedStation(AudioPlayer.previous());
+      break;
+      
+    case PLAYER_ACTION_LIVE:
+      // Leave the time-shift backlog and play the station live
+      AudioPlayer.jumpToLive();
+      UIManager.updatePlayerScreen();
       break;
       
     case PLAYER_ACTION_BACK:
@@ -373,6 +402,7 @@ void handleSettingsTouch(TouchPoint point) {
       break;
       
     case SETTINGS_ACTION_AUDIO:
+      currentState = STATE_AUDIO_SETTINGS;
       UIManager.showAudioSettings();
       break;
       
@@ -387,6 +417,60 @@ void handleSettingsTouch(TouchPoint point) {
   }
 }
 
+/**
+ * Handle touch events on audio settings screen
+ */
+void handleAudioSettingsTouch(TouchPoint point) {
+  int action = UIManager.checkAudioSettingsTouch(point);
+  AppConfig& config = SDManager.getConfig();
+  
+  switch (action) {
+    case AUDIO_ACTION_BASS_DOWN:
+      config.eqBass = max(config.eqBass - EQ_GAIN_STEP_DB, EQ_GAIN_MIN_DB);
+      break;
+      
+    case AUDIO_ACTION_BASS_UP:
+      config.eqBass = min(config.eqBass + EQ_GAIN_STEP_DB, EQ_GAIN_MAX_DB);
+      break;
+      
+    case AUDIO_ACTION_MID_DOWN:
+      config.eqMid = max(config.eqMid - EQ_GAIN_STEP_DB, EQ_GAIN_MIN_DB);
+      break;
+      
+    case AUDIO_ACTION_MID_UP:
+      config.eqMid = min(config.eqMid + EQ_GAIN_STEP_DB, EQ_GAIN_MAX_DB);
+      break;
+      
+    case AUDIO_ACTION_TREBLE_DOWN:
+      config.eqTreble = max(config.eqTreble - EQ_GAIN_STEP_DB, EQ_GAIN_MIN_DB);
+      break;
+      
+    case AUDIO_ACTION_TREBLE_UP:
+      config.eqTreble = min(config.eqTreble + EQ_GAIN_STEP_DB, EQ_GAIN_MAX_DB);
+      break;
+      
+    case AUDIO_ACTION_FLAT:
+      config.eqBass = 0;
+      config.eqMid = 0;
+      config.eqTreble = 0;
+      break;
+      
+    case AUDIO_ACTION_BACK:
+      // Tone changes are written once, on leaving the screen
+      SDManager.saveConfig();
+      currentState = STATE_SETTINGS;
+      UIManager.showSettingsScreen();
+      return;
+      
+    default:
+      return;
+  }
+  
+  // Heard right away; redraw shows the new values
+  AudioPipeline.setEqualizer(config.eqBass, config.eqMid, config.eqTreble);
+  UIManager.showAudioSettings();
+}
+
 /**
  * Handle touch events on folder view screen
  */
@@ -495,7 +579,7 @@ void playStation(Station* station) {
   
   Display.showMessage("Loading " + station->name + "...");
   
-  if (AudioPlayer.playStation(station->url)) {
+  if (AudioPlayer.playStation(*station)) {
     previousState = currentState;
     currentState = STATE_PLAYING;
     UIManager.showPlayerScreen(station);
@@ -509,6 +593,16 @@ void playStation(Station* station) {
   }
 }
 
+/**
+ * Show the station reached with next/previous
+ */
+void showZappedStation(Station* station) {
+  if (station == nullptr) return;
+  
+  UIManager.showPlayerScreen(station);
+  SDManager.saveLastStation(station->name);
+}
+
 /**
  * Update screen based on current state
  */
@@ -534,6 +628,10 @@ void updateScreen() {
       UIManager.showSettingsScreen();
       break;
       
+    case STATE_AUDIO_SETTINGS:
+      UIManager.showAudioSettings();
+      break;
+      
     case STATE_FOLDER_VIEW:
       UIManager.showFolderView();
       break;
@@ -0,0 +1,41 @@
+/**
+ * Audio Pipeline Endpoints for Jam Wysteria
+ *
+ * The fetch stage pulls compressed bytes from an AudioSource and the
+ * output stage pushes PCM frames into a PcmSink. On the device these
+ * are the HTTP stream and the I2S port (AudioPipeline.init() takes
+ * another sink); on a host, test/test_pipeline_stages.cpp drives the
+ * stage steps in audio_stages.h with a file source and a PCM file sink.
+ */
+
+#ifndef AUDIO_IO_H
+#define AUDIO_IO_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Compressed stream input
+class AudioSource {
+public:
+  virtual ~AudioSource() {}
+  
+  // Returns bytes read, 0 if nothing is ready yet, -1 at end of stream
+  virtual int read(uint8_t* buffer, size_t length) = 0;
+  virtual void close() = 0;
+};
+
+// Interleaved 16-bit stereo output
+class PcmSink {
+public:
+  virtual ~PcmSink() {}
+  
+  virtual bool setSampleRate(uint32_t rate) = 0;
+  
+  // Blocks until the frames are accepted; returns frames written
+  virtual size_t write(const int16_t* frames, size_t count) = 0;
+  
+  // Drop anything queued in the sink (station change)
+  virtual void clear() = 0;
+};
+
+#endif // AUDIO_IO_H
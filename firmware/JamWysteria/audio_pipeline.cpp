@@ -0,0 +1,1562 @@
+/**
+ * Audio Pipeline Implementation
+ */
+
+#include "audio_pipeline.h"
+#include "audio_player.h"
+#include "codec_sniffer.h"
+#include "playlist_resolver.h"
+#include "sd_manager.h"
+#include "stream_recorder.h"
+#include <SD.h>
+#include <esp_heap_caps.h>
+
+// Live streams have no size; report one that keeps File::available()
+// positive and wrap the position well below it (local files report
+// their real size, so the decoder sees the end of the track)
+#define STREAM_VIRTUAL_SIZE     0x7FFFFFFF
+#define STREAM_POSITION_MASK    0x3FFFFFFF
+
+#define PCM_CHUNK_FRAMES        256
+
+// Fetch request (queued to the fetch task)
+struct FetchRequest {
+  uint32_t session;
+  char url[STREAM_URL_MAX_LENGTH];
+};
+
+// Jitter buffer profiles (depths in ms of stream audio)
+struct JitterProfile {
+  const char* name;
+  uint32_t startMs;   // Prebuffer before decoding starts
+  uint32_t minMs;     // Floor the target decays back to
+  uint32_t maxMs;     // Ceiling underruns can push it to
+};
+
+static const JitterProfile jitterProfiles[BUFFER_PROFILE_COUNT] = {
+  { "fast",     500,  300,  4000  },
+  { "balanced", 1500, 800,  8000  },
+  { "robust",   4000, 2000, 15000 }
+};
+
+// Global instance
+AudioPipelineClass AudioPipeline;
+
+// ICY metadata arrives on the fetch task in stream order: the recorder
+// marks its track split there, at the exact byte
+static void fetchMetadata(const IcyMetadataParser& block) {
+  IcySpan title = block.find("StreamTitle");
+  if (title.length > 0) {
+    StreamRecorder.markTitle(title);
+    Serial.printf("[AUDIO STREAM] %.*s\n", (int)title.length, title.data);
+  }
+  AudioPlayer.publishStreamMetadata(block);
+}
+
+// ============================================================================
+// Stream File System (decoder side of the stream ring)
+// ============================================================================
+
+class StreamFileImpl : public fs::FileImpl {
+public:
+  StreamFileImpl(const char* path) : bytesRead(0), isOpen(true) {
+    strlcpy(filePath, path, sizeof(filePath));
+  }
+  
+  size_t read(uint8_t* buf, size_t size) override {
+    size_t received = AudioPipeline.readStream(buf, size);
+    bytesRead += received;
+    return received;
+  }
+  
+  bool seek(uint32_t pos, fs::SeekMode mode) override {
+    // A live stream can only "seek" to where it already is
+    return (mode == fs::SeekCur && pos == 0) ||
+           (mode == fs::SeekSet && pos == position());
+  }
+  
+  size_t position() const override { return bytesRead & STREAM_POSITION_MASK; }
+  size_t size() const override { return AudioPipeline.getStreamSize(); }
+  void close() override { isOpen = false; }
+  operator bool() override { return isOpen; }
+  const char* path() const override { return filePath; }
+  const char* name() const override { return filePath + 1; }
+  
+  // Not meaningful for a stream
+  size_t write(const uint8_t* buf, size_t size) override { return 0; }
+  void flush() override {}
+  bool setBufferSize(size_t size) override { return true; }
+  time_t getLastWrite() override { return 0; }
+  boolean isDirectory(void) override { return false; }
+  fs::FileImplPtr openNextFile(const char* mode) override { return fs::FileImplPtr(); }
+  boolean seekDir(long position) override { return false; }
+  String getNextFileName(void) override { return ""; }
+  String getNextFileName(bool* isDir) override { return ""; }
+  void rewindDirectory(void) override {}
+  
+private:
+  char filePath[16];
+  size_t bytesRead;
+  bool isOpen;
+};
+
+class StreamFSImpl : public fs::FSImpl {
+public:
+  fs::FileImplPtr open(const char* path, const char* mode, const bool create) override {
+    return std::make_shared<StreamFileImpl>(path);
+  }
+  
+  bool exists(const char* path) override { return strncmp(path, "/stream.", 8) == 0; }
+  bool rename(const char* from, const char* to) override { return false; }
+  bool remove(const char* path) override { return false; }
+  bool mkdir(const char* path) override { return false; }
+  bool rmdir(const char* path) override { return false; }
+};
+
+static fs::FS streamFS(std::make_shared<StreamFSImpl>());
+
+// ============================================================================
+// I2S Output
+// ============================================================================
+
+I2SOutput::I2SOutput(i2s_port_t port) : port(port), sampleRate(AUDIO_SAMPLE_RATE) {
+}
+
+bool I2SOutput::begin() {
+  i2s_config_t config = {
+    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
+    .sample_rate = sampleRate,
+    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+    .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+    .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+    .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+    .dma_buf_count = AUDIO_OUTPUT_DMA_BUFFERS,
+    .dma_buf_len = AUDIO_OUTPUT_DMA_LENGTH,
+    .use_apll = false,
+    .tx_desc_auto_clear = true,   // Underruns play silence, not stale DMA data
+    .fixed_mclk = 0
+  };
+  
+  i2s_pin_config_t pins = {
+    .mck_io_num = I2S_PIN_NO_CHANGE,
+    .bck_io_num = I2S_BCLK,
+    .ws_io_num = I2S_LRC,
+    .data_out_num = I2S_DOUT,
+    .data_in_num = I2S_PIN_NO_CHANGE
+  };
+  
+  if (i2s_driver_install(port, &config, 0, nullptr) != ESP_OK) {
+    return false;
+  }
+  if (i2s_set_pin(port, &pins) != ESP_OK) {
+    i2s_driver_uninstall(port);
+    return false;
+  }
+  
+  i2s_zero_dma_buffer(port);
+  return true;
+}
+
+bool I2SOutput::setSampleRate(uint32_t rate) {
+  if (rate == 0 || rate == sampleRate) {
+    return true;
+  }
+  
+  if (i2s_set_sample_rates(port, rate) != ESP_OK) {
+    return false;
+  }
+  
+  sampleRate = rate;
+  return true;
+}
+
+size_t I2SOutput::write(const int16_t* frames, size_t count) {
+  size_t written = 0;
+  i2s_write(port, frames, count * PCM_FRAME_BYTES, &written, portMAX_DELAY);
+  return written / PCM_FRAME_BYTES;
+}
+
+void I2SOutput::clear() {
+  i2s_zero_dma_buffer(port);
+}
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+AudioPipelineClass::AudioPipelineClass() :
+  ready(false),
+  http(&streams[0]),
+  fetchTask(nullptr),
+  fetchQueue(nullptr),
+  fetchSession(0),
+  fetchBusy(false),
+  fetchState(FETCH_IDLE),
+  codecSniffed(false),
+  localSize(0),
+  bytesFetched(0),
+  advertisedKbps(0),
+  decoderKbps(0),
+  timeShifted(false),
+  bufferProfile(BUFFER_PROFILE_DEFAULT),
+  byteRate(JITTER_DEFAULT_BYTE_RATE),
+  jitterMs(0),
+  targetMs(jitterProfiles[BUFFER_PROFILE_DEFAULT].startMs),
+  rebuffering(false),
+  streamUnderruns(0),
+  lastUnderrun(0),
+  lastShrink(0),
+  streamingSince(0),
+  warm(&streams[1]),
+  warmTask(nullptr),
+  warmQueue(nullptr),
+  warmLock(nullptr),
+  warmBuffer(nullptr),
+  warmWritten(0),
+  warmFailed(false),
+  warmRetryAt(0),
+  warmPromotions(0),
+  output(I2S_NUM_0),
+  sink(&output),
+  outputTask(nullptr),
+  sampleRate(AUDIO_SAMPLE_RATE),
+  outputRate(AUDIO_SAMPLE_RATE),
+  outputActive(false),
+  flushRequested(false),
+  outputUnderruns(0),
+  driftPpm(0),
+  resampleLoad(0),
+  driftLocked(false),
+  driftSetpointMs(0),
+  driftDepthMs(0),
+  gainTarget(PCM_GAIN_UNITY),
+  eqBass(0),
+  eqMid(0),
+  eqTreble(0),
+  eqVersion(1),
+  eqStages(0),
+  eqLoad(0),
+  loudnessStartDb(0),
+  loudnessKnown(false),
+  loudnessVersion(1),
+  loudnessApplied(0),
+  loudnessDb(0),
+  loudnessLufs(LOUDNESS_SILENCE_LUFS),
+  loudnessMeasuredMs(0),
+  telemetrySince(0),
+  telemetryBytes(0),
+  pcmFrames(0),
+  pcmWaitUs(0),
+  telemetryI2sUnderruns(0),
+  telemetryStreamUnderruns(0),
+  fillHistoryNext(0),
+  fillHistoryCount(0),
+  rateNext(0),
+  rateCount(0),
+  measuredKbps(0) {
+  fetchError[0] = '\0';
+  codec[0] = '\0';
+  resolvedURL[0] = '\0';
+  warmURL[0] = '\0';
+  warmCodec[0] = '\0';
+  fillHistogram.clear();
+}
+
+bool AudioPipelineClass::init(PcmSink* pcmSink) {
+  // Stream ring is the jitter buffer: deep in PSRAM, shallow without it
+  bool streamAllocated = streamRing.init(AUDIO_STREAM_RING_SIZE, true);
+  if (!streamRing.isPsram()) {
+    streamAllocated = streamRing.init(AUDIO_STREAM_RING_FALLBACK, false);
+  }
+  
+  if (!streamAllocated || !pcmRing.init(AUDIO_PCM_RING_SIZE, false)) {
+    Serial.println("[PIPELINE] ✗ Not enough memory for audio rings");
+    streamRing.release();
+    pcmRing.release();
+    return false;
+  }
+  
+  // I2S unless a sink was handed in
+  sink = pcmSink != nullptr ? pcmSink : &output;
+  if (sink == &output && !output.begin()) {
+    Serial.println("[PIPELINE] ✗ I2S output initialization failed");
+    streamRing.release();
+    pcmRing.release();
+    return false;
+  }
+  
+  http->onMetadata(fetchMetadata);
+  
+  fetchQueue = xQueueCreate(2, sizeof(FetchRequest));
+  xTaskCreatePinnedToCore(fetchTaskEntry, "fetch", AUDIO_FETCH_TASK_STACK, this,
+                          AUDIO_FETCH_TASK_PRIORITY, &fetchTask, AUDIO_FETCH_TASK_CORE);
+  xTaskCreatePinnedToCore(outputTaskEntry, "i2s-out", AUDIO_OUTPUT_TASK_STACK, this,
+                          AUDIO_OUTPUT_TASK_PRIORITY, &outputTask, AUDIO_OUTPUT_TASK_CORE);
+  
+  // Warm neighbour is optional and needs its buffer in PSRAM
+  warmBuffer = (uint8_t*)heap_caps_malloc(WARM_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (warmBuffer != nullptr) {
+    warmLock = xSemaphoreCreateMutex();
+    warmQueue = xQueueCreate(1, STREAM_URL_MAX_LENGTH);
+    xTaskCreatePinnedToCore(warmTaskEntry, "warm", WARM_TASK_STACK, this,
+                            WARM_TASK_PRIORITY, &warmTask, WARM_TASK_CORE);
+  } else {
+    Serial.println("[PIPELINE] No PSRAM for a warm neighbour, station changes connect cold");
+  }
+  
+  // Time-shift backlog is optional too
+  if (!timeShift.init(TIMESHIFT_RAM_SIZE)) {
+    Serial.println("[PIPELINE] No PSRAM for time-shift, pausing a live stream drops it");
+  }
+  
+  ready = true;
+  
+  Serial.printf("[PIPELINE] ✓ Stream ring: %u KB (%s), PCM ring: %u KB\n",
+                streamRing.capacity() / 1024,
+                streamRing.isPsram() ? "PSRAM" : "internal",
+                pcmRing.capacity() / 1024);
+  return true;
+}
+
+bool AudioPipelineClass::isReady() {
+  return ready;
+}
+
+bool AudioPipelineClass::isLocalURL(const char* url) {
+  return strncmp(url, LOCAL_URL_PREFIX, strlen(LOCAL_URL_PREFIX)) == 0;
+}
+
+void AudioPipelineClass::startFetch(const String& url) {
+  FetchRequest request;
+  request.session = fetchSession + 1;
+  fetchSession = request.session;
+  strlcpy(request.url, url.c_str(), sizeof(request.url));
+  
+  fetchError[0] = '\0';
+  codec[0] = '\0';
+  resolvedURL[0] = '\0';
+  fetchState = FETCH_CONNECTING;
+  localSize = 0;
+  timeShifted = false;
+  advertisedKbps = 0;
+  decoderKbps = 0;
+  
+  // Every station starts from the profile's tune-in depth
+  targetMs = jitterProfiles[bufferProfile].startMs;
+  rebuffering = false;
+  streamUnderruns = 0;
+  lastUnderrun = millis();
+  lastShrink = lastUnderrun;
+  
+  if (xQueueSend(fetchQueue, &request, 0) != pdTRUE) {
+    strlcpy(fetchError, "Fetch queue full", sizeof(fetchError));
+    fetchState = FETCH_ERROR;
+  }
+}
+
+void AudioPipelineClass::stopFetch() {
+  // The running session sees the new number and winds down
+  fetchSession = fetchSession + 1;
+  
+  unsigned long start = millis();
+  while (fetchBusy && millis() - start < STREAM_CONNECT_TIMEOUT + 1000) {
+    vTaskDelay(1);
+  }
+  
+  fetchState = FETCH_IDLE;
+  
+  // Called from the decoder, which is the stream ring's consumer
+  streamRing.skip(streamRing.available());
+}
+
+FetchState AudioPipelineClass::getFetchState() {
+  return fetchState;
+}
+
+String AudioPipelineClass::getFetchError() {
+  return String(fetchError);
+}
+
+const char* AudioPipelineClass::getCodecExtension() {
+  return codec;
+}
+
+const char* AudioPipelineClass::getResolvedURL() {
+  return resolvedURL;
+}
+
+size_t AudioPipelineClass::getStreamSize() {
+  size_t size = localSize;
+  return size > 0 ? size : STREAM_VIRTUAL_SIZE;
+}
+
+fs::FS& AudioPipelineClass::getStreamFS() {
+  return streamFS;
+}
+
+size_t AudioPipelineClass::readStream(uint8_t* buffer, size_t length) {
+  adaptTarget();
+  
+  // After an underrun, hold the decoder until the target depth is back
+  if (rebuffering) {
+    if (fetchState == FETCH_STREAMING && streamRing.available() < targetBytes()) {
+      vTaskDelay(pdMS_TO_TICKS(AUDIO_DECODE_READ_WAIT_MS));
+      return 0;
+    }
+    rebuffering = false;
+    Serial.printf("[PIPELINE] Rebuffered %lu ms\n", (unsigned long)bytesToMs(streamRing.available()));
+  }
+  
+  // Short wait keeps the decoder from spinning on an empty ring
+  unsigned long start = millis();
+  while (streamRing.available() == 0) {
+    if (fetchState != FETCH_STREAMING) {
+      return 0;
+    }
+    
+    if (millis() - start >= AUDIO_DECODE_READ_WAIT_MS) {
+      // Jitter buffer ran dry: deepen it and refill before decoding on
+      streamUnderruns++;
+      telemetryStreamUnderruns++;
+      lastUnderrun = millis();
+      targetMs = min(targetMs + JITTER_UNDERRUN_STEP_MS, jitterProfiles[bufferProfile].maxMs);
+      rebuffering = true;
+      Serial.printf("[PIPELINE] Stream underrun, target now %lu ms\n", (unsigned long)targetMs);
+      return 0;
+    }
+    vTaskDelay(1);
+  }
+  
+  return streamRing.read(buffer, length);
+}
+
+size_t AudioPipelineClass::writePcm(const int16_t* samples, size_t frames, uint8_t channels) {
+  int16_t stereo[PCM_CHUNK_FRAMES * 2];
+  size_t done = 0;
+  
+  while (done < frames) {
+    size_t count = min(frames - done, (size_t)PCM_CHUNK_FRAMES);
+    const int16_t* chunk = samples + done * 2;
+    
+    // Output stage always takes interleaved stereo
+    if (channels == 1) {
+      for (size_t i = 0; i < count; i++) {
+        stereo[i * 2] = samples[done + i];
+        stereo[i * 2 + 1] = samples[done + i];
+      }
+      chunk = stereo;
+    }
+    
+    // Backpressure: the decoder waits here for the I2S stage
+    size_t bytes = count * PCM_FRAME_BYTES;
+    if (pcmRing.space() < bytes) {
+      unsigned long waitStart = micros();
+      while (pcmRing.space() < bytes) {
+        if (flushRequested || !outputActive) {
+          pcmWaitUs += micros() - waitStart;
+          return done;
+        }
+        vTaskDelay(1);
+      }
+      pcmWaitUs += micros() - waitStart;
+    }
+    
+    pcmRing.write((const uint8_t*)chunk, bytes);
+    pcmFrames += count;
+    done += count;
+  }
+  
+  return done;
+}
+
+void AudioPipelineClass::setSampleRate(uint32_t rate) {
+  if (rate > 0) {
+    sampleRate = rate;
+  }
+}
+
+void AudioPipelineClass::setBitrate(uint32_t bitsPerSecond) {
+  // The decoder reports 0 until it has seen a frame header
+  if (bitsPerSecond >= 8000) {
+    byteRate = bitsPerSecond / 8;
+    decoderKbps = bitsPerSecond / 1000;
+  }
+}
+
+void AudioPipelineClass::setBufferProfile(int profile) {
+  if (profile < 0 || profile >= BUFFER_PROFILE_COUNT) {
+    profile = BUFFER_PROFILE_DEFAULT;
+  }
+  
+  bufferProfile = profile;
+  Serial.printf("[PIPELINE] Buffer profile: %s\n", jitterProfiles[profile].name);
+}
+
+const char* AudioPipelineClass::getBufferProfileName(int profile) {
+  if (profile < 0 || profile >= BUFFER_PROFILE_COUNT) {
+    return "unknown";
+  }
+  return jitterProfiles[profile].name;
+}
+
+bool AudioPipelineClass::isBufferReady() {
+  // A file shorter than the target is all there will be
+  return streamRing.available() >= targetBytes() || fetchState == FETCH_ENDED;
+}
+
+void AudioPipelineClass::setWarmURL(const String& url) {
+  if (warmQueue == nullptr) {
+    return;
+  }
+  
+  char request[STREAM_URL_MAX_LENGTH];
+  strlcpy(request, url.c_str(), sizeof(request));
+  xQueueOverwrite(warmQueue, request);
+}
+
+void AudioPipelineClass::setOutputActive(bool active) {
+  outputActive = active;
+}
+
+void AudioPipelineClass::flushOutput() {
+  flushRequested = true;
+  
+  // The output task (PCM consumer) does the actual drop
+  unsigned long start = millis();
+  while (flushRequested && millis() - start < 100) {
+    vTaskDelay(1);
+  }
+}
+
+void AudioPipelineClass::setGain(uint32_t value) {
+  // The output task ramps towards it
+  gainTarget = min(value, (uint32_t)PCM_GAIN_UNITY);
+}
+
+void AudioPipelineClass::setEqualizer(int bassDb, int midDb, int trebleDb) {
+  eqBass = constrain(bassDb, EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+  eqMid = constrain(midDb, EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+  eqTreble = constrain(trebleDb, EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+  
+  // The output task redesigns the chain when it sees the new version
+  eqVersion = eqVersion + 1;
+}
+
+void AudioPipelineClass::startLoudness(float gainDb, bool known) {
+  loudnessStartDb = constrain(gainDb, LOUDNESS_MAX_CUT_DB, LOUDNESS_MAX_BOOST_DB);
+  loudnessKnown = known;
+  
+  // The output task restarts the meter when it sees the new version
+  loudnessVersion = loudnessVersion + 1;
+}
+
+bool AudioPipelineClass::startTimeShift() {
+  if (!timeShift.isReady() || localSize > 0 || fetchState != FETCH_STREAMING) {
+    return false;
+  }
+  
+  timeShifted = true;
+  return true;
+}
+
+bool AudioPipelineClass::isTimeShifted() {
+  return timeShifted;
+}
+
+uint32_t AudioPipelineClass::getTimeShiftMs() {
+  if (!timeShifted) {
+    return 0;
+  }
+  
+  // Whatever is buffered past the usual jitter depth was missed while paused
+  uint32_t held = bytesToMs(streamRing.available() + timeShift.available());
+  return held > targetMs ? held - targetMs : 0;
+}
+
+bool AudioPipelineClass::getLearnedLoudness(float& gainDb) {
+  // Still measuring the previous stream, or not long enough
+  if (loudnessApplied != loudnessVersion ||
+      loudnessMeasuredMs < LOUDNESS_SETTLE_S * 1000) {
+    return false;
+  }
+  gainDb = loudnessDb;
+  return true;
+}
+
+AudioPipelineLevels AudioPipelineClass::getLevels() {
+  AudioPipelineLevels levels;
+  levels.streamFill = streamRing.available();
+  levels.streamSize = streamRing.capacity();
+  levels.pcmFill = pcmRing.available();
+  levels.pcmSize = pcmRing.capacity();
+  levels.bytesFetched = bytesFetched;
+  levels.outputUnderruns = outputUnderruns;
+  levels.sampleRate = sampleRate;
+  levels.outputRate = outputRate;
+  levels.driftPpm = driftPpm;
+  levels.resampleLoad = resampleLoad;
+  levels.bufferProfile = bufferProfile;
+  levels.depthMs = bytesToMs(levels.streamFill);
+  levels.targetMs = targetMs;
+  levels.jitterMs = jitterMs;
+  levels.streamUnderruns = streamUnderruns;
+  levels.rebuffering = rebuffering;
+  levels.warmPromotions = warmPromotions;
+  levels.eqStages = eqStages;
+  levels.eqLoad = eqLoad;
+  levels.loudness = loudnessLufs;
+  levels.loudnessGainDb = loudnessDb;
+  levels.loudnessSettled = loudnessMeasuredMs >= LOUDNESS_SETTLE_S * 1000;
+  levels.timeShifted = timeShifted;
+  levels.timeShiftMs = getTimeShiftMs();
+  levels.timeShiftBytes = timeShift.available();
+  return levels;
+}
+
+void AudioPipelineClass::getTelemetry(AudioTelemetry& telemetry) {
+  telemetry.sinceMs = millis() - telemetrySince;
+  telemetry.bytesReceived = telemetryBytes;
+  telemetry.measuredKbps = measuredKbps;
+  telemetry.advertisedKbps = advertisedKbps;
+  telemetry.decoderKbps = decoderKbps;
+  telemetry.i2sUnderruns = telemetryI2sUnderruns;
+  telemetry.streamUnderruns = telemetryStreamUnderruns;
+  telemetry.fillMs = fillHistogram;
+  
+  // History ring unrolled, oldest first
+  int count = fillHistoryCount;
+  int first = (fillHistoryNext - count + TELEMETRY_HISTORY) % TELEMETRY_HISTORY;
+  for (int i = 0; i < count; i++) {
+    telemetry.fillHistory[i] = fillHistory[(first + i) % TELEMETRY_HISTORY];
+  }
+  telemetry.fillHistoryCount = count;
+}
+
+void AudioPipelineClass::resetTelemetry() {
+  telemetrySince = millis();
+  telemetryBytes = 0;
+  telemetryI2sUnderruns = 0;
+  telemetryStreamUnderruns = 0;
+  fillHistogram.clear();
+  fillHistoryCount = 0;
+}
+
+uint32_t AudioPipelineClass::getPcmFrames() {
+  return pcmFrames;
+}
+
+uint32_t AudioPipelineClass::getPcmWaitUs() {
+  return pcmWaitUs;
+}
+
+// ============================================================================
+// Playlist I/O
+// ============================================================================
+
+// What a resolution in playlist_resolve.h sees of the fetch task; a
+// newer tune-in cancels it
+class HttpResolveIo : public ResolveIo {
+public:
+  HttpResolveIo(HttpStream& http, uint32_t session, const volatile uint32_t& current) :
+    http(http), session(session), current(current) {}
+  
+  bool open(const std::string& url) override { return http.open(url.c_str()); }
+  int read(uint8_t* buffer, size_t length) override { return http.read(buffer, length); }
+  void close() override { http.close(); }
+  std::string contentType() override { return http.getContentType().c_str(); }
+  
+  bool lookupRoute(const std::string& url, std::string& target) override {
+    String streamURL;
+    if (!PlaylistResolver.lookup(url.c_str(), streamURL)) {
+      return false;
+    }
+    target = streamURL.c_str();
+    return true;
+  }
+  
+  void storeRoute(const std::string& url, const std::string& target) override {
+    PlaylistResolver.store(url.c_str(), target.c_str());
+  }
+  
+  void dropRoute(const std::string& url) override { PlaylistResolver.invalidate(url.c_str()); }
+  
+  uint32_t now() override { return millis(); }
+  void wait(uint32_t ms) override { vTaskDelay(pdMS_TO_TICKS(ms)); }
+  bool cancelled() override { return session != current; }
+  
+private:
+  HttpStream& http;
+  uint32_t session;
+  const volatile uint32_t& current;
+};
+
+// ============================================================================
+// Stage Tasks
+// ============================================================================
+
+void AudioPipelineClass::fetchTaskEntry(void* param) {
+  ((AudioPipelineClass*)param)->fetchLoop();
+}
+
+void AudioPipelineClass::outputTaskEntry(void* param) {
+  ((AudioPipelineClass*)param)->outputLoop();
+}
+
+void AudioPipelineClass::warmTaskEntry(void* param) {
+  ((AudioPipelineClass*)param)->warmLoop();
+}
+
+void AudioPipelineClass::fetchLoop() {
+  FetchRequest request;
+  
+  while (true) {
+    if (xQueueReceive(fetchQueue, &request, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    
+    fetchBusy = true;
+    
+    // Skip requests superseded while they were queued
+    if (request.session == fetchSession) {
+      if (isLocalURL(request.url)) {
+        runLocal(request.session, request.url + strlen(LOCAL_URL_PREFIX));
+      } else {
+        runFetch(request.session, request.url);
+      }
+    }
+    
+    // A backlog belongs to the session that recorded it
+    timeShift.clear();
+    
+    fetchBusy = false;
+  }
+}
+
+void AudioPipelineClass::outputLoop() {
+  int16_t frames[AUDIO_OUTPUT_DMA_LENGTH * 2];
+  uint32_t currentRate = 0;
+  uint32_t inputRate = 0;
+  uint32_t resampleRate = 0;
+  unsigned long lastDrift = 0;
+  unsigned long lastTelemetry = 0;
+  uint32_t eqApplied = 0;
+  uint32_t eqRate = 0;
+  uint32_t meterRate = 0;
+  float appliedDb = 0;
+  uint32_t normGain = PCM_GAIN_UNITY;
+  bool starved = true;
+  
+  while (true) {
+    if (flushRequested) {
+      pcmRing.skip(pcmRing.available());
+      sink->clear();
+      starved = true;
+      flushRequested = false;
+      
+      // Whatever plays next fades in
+      gain.reset(0);
+      equalizer.reset();
+      resampler.reset();
+      driftLocked = false;
+    }
+    
+    // The I2S clock either stays put or follows the stream
+    uint32_t streamRate = sampleRate;
+    uint32_t wantedRate = RESAMPLE_FIXED_OUTPUT ? AUDIO_SAMPLE_RATE : streamRate;
+    if (wantedRate != currentRate && sink->setSampleRate(wantedRate)) {
+      currentRate = wantedRate;
+      outputRate = wantedRate;
+    }
+    
+    if (streamRate != inputRate || currentRate != resampleRate) {
+      resampler.configure(streamRate, currentRate);
+      inputRate = streamRate;
+      resampleRate = currentRate;
+    }
+    
+    if (millis() - lastDrift >= DRIFT_UPDATE_MS) {
+      lastDrift = millis();
+      adaptDrift();
+    }
+    
+    if (millis() - lastTelemetry >= TELEMETRY_SAMPLE_MS) {
+      lastTelemetry = millis();
+      sampleTelemetry();
+    }
+    
+    // Coefficients depend on both the tone settings and the rate
+    uint32_t version = eqVersion;
+    if (version != eqApplied || currentRate != eqRate) {
+      designEqualizer(currentRate);
+      eqApplied = version;
+      eqRate = currentRate;
+    }
+    
+    // A new stream starts from its remembered (or neutral) gain
+    uint32_t loudness = loudnessVersion;
+    if (loudness != loudnessApplied || currentRate != meterRate) {
+      if (currentRate != meterRate) {
+        meter.configure(currentRate, LOUDNESS_BLOCK_MS, LOUDNESS_WINDOW_BLOCKS);
+        meterRate = currentRate;
+      }
+      if (loudness != loudnessApplied) {
+        loudnessDb = loudnessStartDb;
+        loudnessMeasuredMs = 0;
+        loudnessApplied = loudness;
+      }
+      meter.reset();
+      loudnessLufs = LOUDNESS_SILENCE_LUFS;
+    }
+    
+    // Whole frames only
+    size_t ready = pcmRing.available() & ~(size_t)(PCM_FRAME_BYTES - 1);
+    if (ready == 0) {
+      if (!starved && outputActive) {
+        outputUnderruns++;
+        telemetryI2sUnderruns++;
+      }
+      starved = true;
+      vTaskDelay(1);
+      continue;
+    }
+    starved = false;
+    
+    unsigned long resampleStart = micros();
+    size_t count = resampleFromRing(pcmRing, resampler, frames, AUDIO_OUTPUT_DMA_LENGTH);
+    if (count == 0) {
+      // Not a filter's length of input yet
+      vTaskDelay(1);
+      continue;
+    }
+    
+    // Share of the block's play time spent resampling (permille)
+    uint32_t blockUs = (uint32_t)((uint64_t)count * 1000000 / currentRate);
+    uint32_t resampleUs = micros() - resampleStart;
+    resampleLoad = (resampleLoad * 15 + (blockUs > 0 ? resampleUs * 1000 / blockUs : 0)) / 16;
+    
+    // Metered before volume and tone, so it learns the station's level
+    if (outputActive && meter.process(frames, count)) {
+      adaptLoudness();
+    }
+    if (loudnessDb != appliedDb) {
+      appliedDb = loudnessDb;
+      normGain = (uint32_t)(PCM_GAIN_UNITY * powf(10.0f, appliedDb / 20.0f) + 0.5f);
+    }
+    
+    // Boost only takes effect while the volume leaves room for it
+    uint32_t target = min((uint32_t)(((uint64_t)gainTarget * normGain) >> 16),
+                          (uint32_t)PCM_GAIN_UNITY);
+    if (target != gain.getTarget()) {
+      gain.setTarget(target, currentRate * VOLUME_RAMP_MS / 1000);
+    }
+    gain.process(frames, count);
+    
+    if (equalizer.getCount() > 0) {
+      unsigned long started = micros();
+      equalizer.process(frames, count);
+      uint32_t busyUs = micros() - started;
+      
+      // Share of the block's play time spent filtering (permille)
+      uint32_t load = blockUs > 0 ? busyUs * 1000 / blockUs : 0;
+      eqLoad = (eqLoad * 15 + load) / 16;
+      
+      // Playback matters more than tone: bypass until the settings change
+      if (eqLoad > EQ_CPU_BUDGET_PCT * 10) {
+        Serial.printf("[PIPELINE] ✗ Tone control over CPU budget (%u.%u%%), bypassed\n",
+                      eqLoad / 10, eqLoad % 10);
+        equalizer.clear();
+        eqStages = 0;
+      }
+    }
+    
+    sink->write(frames, count);
+  }
+}
+
+void AudioPipelineClass::warmLoop() {
+  char request[STREAM_URL_MAX_LENGTH];
+  
+  while (true) {
+    vTaskDelay(pdMS_TO_TICKS(WARM_POLL_MS));
+    
+    // A new neighbour waits until a pending station change has had
+    // its chance to take over the current warm connection
+    if (fetchState != FETCH_CONNECTING && xQueueReceive(warmQueue, request, 0) == pdTRUE) {
+      xSemaphoreTake(warmLock, portMAX_DELAY);
+      if (strcmp(request, warmURL) != 0) {
+        closeWarm();
+        strlcpy(warmURL, request, sizeof(warmURL));
+        warmFailed = false;
+        warmRetryAt = 0;
+      }
+      xSemaphoreGive(warmLock);
+    }
+    
+    xSemaphoreTake(warmLock, portMAX_DELAY);
+    if (warmURL[0] != '\0' && !warmFailed) {
+      if (!warm->isOpen()) {
+        if (warmAllowed() && (long)(millis() - warmRetryAt) >= 0) {
+          openWarm();
+        }
+      } else if (!warmAllowed()) {
+        // Main stream is struggling: give it the bandwidth back
+        Serial.println("[PIPELINE] Dropping warm neighbour");
+        closeWarm();
+        warmRetryAt = millis() + WARM_RETRY_MS;
+      } else {
+        readWarm();
+      }
+    }
+    xSemaphoreGive(warmLock);
+  }
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+void AudioPipelineClass::runFetch(uint32_t session, const char* url) {
+  // What this station looked like the last time it played
+  StreamParams known;
+  bool haveKnown = ConnectionCache.getParams(url, known);
+  
+  // A neighbour kept warm for this station starts with audio in hand
+  if (promoteWarm(url)) {
+    Serial.printf("[PIPELINE] ✓ Warm connection promoted (%u bytes buffered)\n",
+                  streamRing.available());
+  } else if (!openStream(session, url, haveKnown ? &known : nullptr)) {
+    return;
+  }
+  
+  // icy-br is optional; a remembered bitrate sizes the buffer until
+  // the decoder reports the real one
+  int bitrate = http->getBitrate();
+  if (session == fetchSession && bitrate > 0) {
+    advertisedKbps = bitrate;
+  }
+  if (bitrate <= 0 && haveKnown) {
+    bitrate = known.bitrate;
+  }
+  
+  if (http->getStationName().length() > 0) {
+    audio_showstation(http->getStationName().c_str());
+  }
+  if (bitrate > 0) {
+    audio_bitrate(String(bitrate * 1000).c_str());
+  }
+  
+  Serial.printf("[PIPELINE] ✓ Streaming %s (metaint %d)\n", codec, http->getMetaInterval());
+  
+  StreamParams params;
+  strlcpy(params.codec, codec, sizeof(params.codec));
+  params.metaInterval = http->getMetaInterval();
+  params.bitrate = bitrate > 0 ? bitrate : 0;
+  params.sniffed = codecSniffed || (haveKnown && known.sniffed && strcmp(known.codec, codec) == 0);
+  ConnectionCache.storeParams(url, params);
+  
+  if (session == fetchSession) {
+    byteRate = bitrate > 0 ? bitrate * 125 : JITTER_DEFAULT_BYTE_RATE;
+    jitterMs = 0;
+    streamingSince = millis();
+    fetchState = FETCH_STREAMING;
+  }
+  
+  bool stalled = !pumpSource(session, http);
+  http->close();
+  
+  // The listener has not heard the backlog yet
+  while (session == fetchSession && timeShift.available() > 0) {
+    pumpTimeShift();
+    vTaskDelay(1);
+  }
+  
+  if (session == fetchSession) {
+    if (stalled) {
+      Serial.println("[PIPELINE] ✗ No data from server");
+      strlcpy(fetchError, "Stream stalled", sizeof(fetchError));
+      fetchState = FETCH_ERROR;
+    } else {
+      Serial.println("[PIPELINE] Stream closed by server");
+      fetchState = FETCH_ENDED;
+    }
+  }
+}
+
+bool AudioPipelineClass::pumpSource(uint32_t session, AudioSource* source) {
+  uint8_t chunk[AUDIO_FETCH_CHUNK];
+  
+  // Jitter: worst gap between reads in each window, smoothed across windows
+  unsigned long lastArrival = millis();
+  unsigned long windowStart = lastArrival;
+  uint32_t windowGap = 0;
+  
+  while (session == fetchSession) {
+    // Decoder is behind or the buffer is well past its target: stop
+    // reading and let the TCP window close
+    size_t fill = streamRing.available();
+    size_t limit = min(streamRing.capacity(), targetBytes() * 2);
+    size_t room = fill < limit ? min(limit - fill, streamRing.space()) : 0;
+    
+    // Time-shifted: everything read goes to the backlog, which tops the
+    // ring up in arrival order; only a full backlog stops reading
+    bool shifted = timeShifted;
+    if (shifted) {
+      pumpTimeShift();
+      room = timeShift.space();
+    }
+    
+    if (room == 0) {
+      lastArrival = millis();   // Our own stall, not the network's
+      vTaskDelay(1);
+      continue;
+    }
+    
+    int received = shifted ? source->read(chunk, min(room, sizeof(chunk)))
+                           : fetchIntoRing(*source, streamRing, chunk, sizeof(chunk), room);
+    if (received < 0) {
+      break;
+    }
+    if (received == 0) {
+      // Connection open but silent: give up so the player can reconnect
+      if (millis() - lastArrival > STREAM_CONNECT_TIMEOUT) {
+        return false;
+      }
+      vTaskDelay(1);
+      continue;
+    }
+    
+    if (shifted) {
+      timeShift.push(chunk, received);
+    }
+    StreamRecorder.tee(chunk, received);
+    bytesFetched += received;
+    telemetryBytes += received;
+    
+    unsigned long now = millis();
+    windowGap = max(windowGap, (uint32_t)(now - lastArrival));
+    lastArrival = now;
+    
+    if (now - windowStart >= JITTER_WINDOW_MS) {
+      // Rises at once, falls back slowly
+      jitterMs = windowGap > jitterMs ? windowGap : (jitterMs * 7 + windowGap) / 8;
+      windowGap = 0;
+      windowStart = now;
+    }
+  }
+  
+  
+  return true;
+}
+
+void AudioPipelineClass::runLocal(uint32_t session, const char* path) {
+  const char* fileCodec = codecForFileName(path);
+  if (fileCodec == nullptr) {
+    Serial.printf("[PIPELINE] ✗ Unsupported file: %s\n", path);
+    strlcpy(fetchError, "Unsupported file type", sizeof(fetchError));
+    fetchState = FETCH_ERROR;
+    return;
+  }
+  
+  File file;
+  if (SDManager.isInitialized()) {
+    file = SD.open(path, FILE_READ);
+  }
+  if (!file || file.isDirectory() || file.size() == 0) {
+    Serial.printf("[PIPELINE] ✗ Cannot open %s\n", path);
+    strlcpy(fetchError, "File not found", sizeof(fetchError));
+    fetchState = FETCH_ERROR;
+    return;
+  }
+  
+  if (session != fetchSession) {
+    file.close();
+    return;
+  }
+  
+  strlcpy(codec, fileCodec, sizeof(codec));
+  localSize = file.size();
+  byteRate = JITTER_DEFAULT_BYTE_RATE;
+  jitterMs = 0;
+  streamingSince = millis();
+  fetchState = FETCH_STREAMING;
+  
+  Serial.printf("[PIPELINE] ✓ Playing %s from SD (%u KB)\n", path, (unsigned)(localSize / 1024));
+  
+  // The stream ring is the read-ahead: kept full well past any jitter
+  // target, so a slow SD sector never reaches the decoder
+  uint8_t chunk[LOCAL_READ_CHUNK];
+  size_t limit = min((size_t)LOCAL_READ_AHEAD, streamRing.capacity() / 4 * 3);
+  bool failed = false;
+  tags.begin();
+  
+  while (session == fetchSession) {
+    size_t fill = streamRing.available();
+    size_t room = fill < limit ? min(limit - fill, streamRing.space()) : 0;
+    
+    // Whole chunks only (SD reads by the sector), except for the tail
+    if (room < sizeof(chunk) && file.available() > (int)room) {
+      vTaskDelay(1);
+      continue;
+    }
+    
+    int received = file.read(chunk, min(room, sizeof(chunk)));
+    if (received <= 0) {
+      failed = file.available() > 0;
+      break;
+    }
+    
+    // The tag is read from the same chunks on their way to the decoder
+    if (!tags.isDone()) {
+      tags.feed(chunk, received);
+    }
+    
+    streamRing.write(chunk, received);
+    bytesFetched += received;
+    telemetryBytes += received;
+  }
+  
+  tags.end();
+  file.close();
+  
+  if (session == fetchSession) {
+    if (failed) {
+      Serial.printf("[PIPELINE] ✗ Read error in %s\n", path);
+      strlcpy(fetchError, "SD read error", sizeof(fetchError));
+      fetchState = FETCH_ERROR;
+    } else {
+      fetchState = FETCH_ENDED;
+    }
+  }
+}
+
+bool AudioPipelineClass::openStream(uint32_t session, const char* url, const StreamParams* known) {
+  static const ResolveLimits limits = {
+    STREAM_CONNECT_TIMEOUT, PLAYLIST_MAX_SIZE, PLAYLIST_MAX_DEPTH, STREAM_URL_MAX_LENGTH
+  };
+  
+  // A playlist resolved earlier goes straight to its stream
+  HttpResolveIo io(*http, session, fetchSession);
+  ResolveResult route;
+  resolvePlaylist(io, url, limits, route);
+  
+  if (route.staleRoute) {
+    Serial.println("[PIPELINE] Cached stream URL failed, resolved playlist again");
+  }
+  if (route.outcome == RESOLVE_CANCELLED) {
+    return false;
+  }
+  if (route.outcome == RESOLVE_FAILED) {
+    Serial.printf("[PIPELINE] ✗ %s\n", http->getError().c_str());
+    if (session == fetchSession) {
+      strlcpy(fetchError, http->getError().c_str(), sizeof(fetchError));
+      fetchState = FETCH_ERROR;
+    }
+    return false;
+  }
+  if (route.outcome == RESOLVE_PLAYLIST) {
+    // HLS or nothing usable; the decoder's own client may cope
+    Serial.println("[PIPELINE] Playlist not resolved, decoder will fetch directly");
+    if (session == fetchSession) {
+      strlcpy(resolvedURL, route.target.c_str(), sizeof(resolvedURL));
+      fetchState = FETCH_UNSUPPORTED;
+    }
+    return false;
+  }
+  
+  String target = route.target.c_str();
+  if (route.playlists > 0) {
+    Serial.printf("[PIPELINE] Through %d playlist(s) -> %s\n", route.playlists, target.c_str());
+  }
+  
+  // Chunked bodies and unknown codecs go to the decoder's own client
+  const char* declared = http->isChunked() ? nullptr : codecForContentType(http->getContentType());
+  
+  // The first bytes say what the stream really is; they are kept for
+  // the decoder, so the wait costs no more than the prebuffer would
+  size_t peeked = 0;
+  const char* extension = http->isChunked() ? nullptr : sniffStream(session, peeked);
+  codecSniffed = extension != nullptr;
+  
+  if (codecSniffed && declared != nullptr && strcmp(extension, declared) != 0) {
+    Serial.printf("[PIPELINE] Content type '%s' but stream is %s\n",
+                  http->getContentType().c_str(), extension);
+  }
+  
+  if (!codecSniffed && !http->isChunked() && known != nullptr && known->codec[0] != '\0') {
+    if (known->sniffed) {
+      // Bytes did not tell this time (trickling, long tag): last sniff wins
+      extension = known->codec;
+    } else if (http->getContentType().length() == 0 ||
+               http->getContentType().indexOf("octet-stream") >= 0) {
+      // Generic content type: trust the codec that played last time
+      extension = known->codec;
+    }
+  }
+  
+  if (extension == nullptr) {
+    extension = declared;
+  }
+  
+  // MP4 needs its index before the audio; the ring cannot seek back
+  if (extension == nullptr || strcmp(extension, "m4a") == 0) {
+    Serial.printf("[PIPELINE] Codec %s (content type '%s') not handled, decoder will fetch directly\n",
+                  extension != nullptr ? extension : "unknown", http->getContentType().c_str());
+    http->close();
+    if (session == fetchSession) {
+      strlcpy(resolvedURL, target.c_str(), sizeof(resolvedURL));
+      fetchState = FETCH_UNSUPPORTED;
+    }
+    return false;
+  }
+  
+  strlcpy(codec, extension, sizeof(codec));
+  
+  if (peeked > 0 && session == fetchSession) {
+    streamRing.write(sniffBuffer, peeked);
+    StreamRecorder.tee(sniffBuffer, peeked);
+    bytesFetched += peeked;
+    telemetryBytes += peeked;
+  }
+  return true;
+}
+
+const char* AudioPipelineClass::sniffStream(uint32_t session, size_t& length) {
+  const char* sniffed = nullptr;
+  unsigned long start = millis();
+  length = 0;
+  
+  // Containers tell at once; raw MP3/AAC after two frame headers
+  while (session == fetchSession && sniffed == nullptr && length < sizeof(sniffBuffer)) {
+    int received = http->read(sniffBuffer + length, sizeof(sniffBuffer) - length);
+    if (received < 0) {
+      break;
+    }
+    if (received == 0) {
+      if (millis() - start > CODEC_SNIFF_TIMEOUT_MS) {
+        break;
+      }
+      vTaskDelay(1);
+      continue;
+    }
+    
+    length += received;
+    sniffed = sniffCodec(sniffBuffer, length);
+  }
+  
+  if (sniffed != nullptr) {
+    Serial.printf("[PIPELINE] Sniffed %s in %u bytes (%lu ms)\n", sniffed, length, millis() - start);
+  }
+  return sniffed;
+}
+
+bool AudioPipelineClass::promoteWarm(const char* url) {
+  if (warmLock == nullptr) {
+    return false;
+  }
+  
+  xSemaphoreTake(warmLock, portMAX_DELAY);
+  
+  bool promoted = strcmp(url, warmURL) == 0 && warm->isOpen() && warmWritten > 0;
+  if (promoted) {
+    // Retained audio goes to the decoder oldest first
+    size_t length = min(warmWritten, (size_t)WARM_BUFFER_SIZE);
+    size_t start = (warmWritten - length) % WARM_BUFFER_SIZE;
+    size_t first = min(length, (size_t)WARM_BUFFER_SIZE - start);
+    streamRing.write(warmBuffer + start, first);
+    streamRing.write(warmBuffer, length - first);
+    
+    // The neighbour becomes the main stream; the old main is closed
+    HttpStream* previous = http;
+    http = warm;
+    warm = previous;
+    http->onMetadata(fetchMetadata);
+    warm->onMetadata(nullptr);
+    
+    strlcpy(codec, warmCodec, sizeof(codec));
+    codecSniffed = false;
+    warmURL[0] = '\0';     // The player names the next neighbour
+    warmWritten = 0;
+    warmPromotions++;
+  }
+  
+  xSemaphoreGive(warmLock);
+  return promoted;
+}
+
+bool AudioPipelineClass::warmAllowed() {
+  // Only beside a settled main stream with buffer to spare
+  return fetchState == FETCH_STREAMING && !rebuffering &&
+         millis() - streamingSince >= WARM_START_DELAY_MS &&
+         streamRing.available() >= targetBytes() / 2 &&
+         ESP.getFreeHeap() >= WARM_MIN_FREE_HEAP;
+}
+
+void AudioPipelineClass::openWarm() {
+  String target = warmURL;
+  PlaylistResolver.lookup(warmURL, target);
+  
+  if (!warm->open(target)) {
+    warmRetryAt = millis() + WARM_RETRY_MS;
+    return;
+  }
+  
+  // Only codecs with frame sync can start from the middle of the
+  // retained audio; playlists and rich streams are not kept warm
+  const char* extension = nullptr;
+  StreamParams known;
+  if (!warm->isChunked() &&
+      PlaylistResolver.detectFormat(warm->getContentType(), target) == PLAYLIST_NONE) {
+    extension = codecForContentType(warm->getContentType());
+    
+    // A codec sniffed when the station last played beats its header
+    if (ConnectionCache.getParams(warmURL, known) && known.sniffed) {
+      extension = known.codec;
+    }
+  }
+  if (extension == nullptr || (strcmp(extension, "mp3") != 0 && strcmp(extension, "aac") != 0) ||
+      warm->getBitrate() > WARM_MAX_BITRATE) {
+    warm->close();
+    warmFailed = true;
+    return;
+  }
+  
+  strlcpy(warmCodec, extension, sizeof(warmCodec));
+  warmWritten = 0;
+  Serial.printf("[PIPELINE] Warm neighbour: %s\n", target.c_str());
+}
+
+void AudioPipelineClass::readWarm() {
+  uint8_t chunk[AUDIO_FETCH_CHUNK];
+  
+  while (true) {
+    int received = warm->read(chunk, sizeof(chunk));
+    if (received < 0) {
+      closeWarm();
+      warmRetryAt = millis() + WARM_RETRY_MS;
+      return;
+    }
+    if (received == 0) {
+      return;
+    }
+    
+    // Circular: only the latest WARM_BUFFER_SIZE bytes are kept
+    size_t offset = warmWritten % WARM_BUFFER_SIZE;
+    size_t first = min((size_t)received, (size_t)WARM_BUFFER_SIZE - offset);
+    memcpy(warmBuffer + offset, chunk, first);
+    memcpy(warmBuffer, chunk + first, received - first);
+    warmWritten += received;
+  }
+}
+
+void AudioPipelineClass::closeWarm() {
+  if (warm->isOpen()) {
+    warm->close();
+  }
+  warmWritten = 0;
+}
+
+void AudioPipelineClass::pumpTimeShift() {
+  uint8_t chunk[AUDIO_FETCH_CHUNK];
+  size_t limit = min(streamRing.capacity(), targetBytes() * 2);
+  
+  while (streamRing.available() + sizeof(chunk) <= limit) {
+    size_t count = timeShift.pop(chunk, sizeof(chunk));
+    if (count == 0) {
+      break;
+    }
+    streamRing.write(chunk, count);
+  }
+}
+
+const char* AudioPipelineClass::codecForContentType(const String& contentType) {
+  if (contentType.indexOf("mpegurl") >= 0 || contentType.indexOf("scpls") >= 0 ||
+      contentType.indexOf("xspf") >= 0 || contentType.indexOf("text/") >= 0) {
+    return nullptr;
+  }
+  
+  if (contentType.indexOf("mpeg") >= 0 || contentType.indexOf("mp3") >= 0) {
+    return "mp3";
+  }
+  if (contentType.indexOf("aac") >= 0) {
+    return "aac";
+  }
+  if (contentType.indexOf("flac") >= 0) {
+    return "flac";
+  }
+  if (contentType.indexOf("ogg") >= 0 || contentType.indexOf("opus") >= 0) {
+    return "ogg";
+  }
+  
+  return nullptr;
+}
+
+const char* AudioPipelineClass::codecForFileName(const char* path) {
+  const char* dot = strrchr(path, '.');
+  if (dot == nullptr) {
+    return nullptr;
+  }
+  
+  if (strcasecmp(dot, ".mp3") == 0) {
+    return "mp3";
+  }
+  if (strcasecmp(dot, ".aac") == 0) {
+    return "aac";
+  }
+  if (strcasecmp(dot, ".flac") == 0) {
+    return "flac";
+  }
+  if (strcasecmp(dot, ".ogg") == 0 || strcasecmp(dot, ".opus") == 0) {
+    return "ogg";
+  }
+  if (strcasecmp(dot, ".wav") == 0) {
+    return "wav";
+  }
+  
+  // MP4/M4A keep their index at the end and need a seekable source
+  return nullptr;
+}
+
+void AudioPipelineClass::designEqualizer(uint32_t rate) {
+  int bass = eqBass;
+  int mid = eqMid;
+  int treble = eqTreble;
+  
+  equalizer.clear();
+  eqLoad = 0;
+  
+  if (EQ_HIGHPASS_HZ > 0) {
+    equalizer.add(BIQUAD_HIGHPASS, EQ_HIGHPASS_HZ, 0, EQ_SHELF_Q, rate);
+  }
+  if (bass != 0) {
+    equalizer.add(BIQUAD_LOW_SHELF, EQ_BASS_HZ, bass, EQ_SHELF_Q, rate);
+  }
+  if (mid != 0) {
+    equalizer.add(BIQUAD_PEAKING, EQ_MID_HZ, mid, EQ_MID_Q, rate);
+  }
+  if (treble != 0) {
+    equalizer.add(BIQUAD_HIGH_SHELF, EQ_TREBLE_HZ, treble, EQ_SHELF_Q, rate);
+  }
+  
+  // Headroom from the combined response, so a full-scale signal
+  // cannot clip inside the chain
+  equalizer.limitGain(rate);
+  
+  eqStages = equalizer.getCount();
+}
+
+void AudioPipelineClass::adaptLoudness() {
+  // Gaps and silence say nothing about the station's level
+  if (meter.getBlockLoudness() < LOUDNESS_GATE_LUFS) {
+    return;
+  }
+  
+  float lufs = meter.getShortTerm();
+  loudnessLufs = lufs;
+  loudnessMeasuredMs = loudnessMeasuredMs + LOUDNESS_BLOCK_MS;
+  
+  float wanted = constrain(LOUDNESS_TARGET_LUFS - lufs, LOUDNESS_MAX_CUT_DB, LOUDNESS_MAX_BOOST_DB);
+  
+  // A station heard for the first time converges faster until settled
+  bool settling = !loudnessKnown && loudnessMeasuredMs < LOUDNESS_SETTLE_S * 1000;
+  float slew = (settling ? LOUDNESS_FAST_SLEW_DB_PER_S : LOUDNESS_SLEW_DB_PER_S) *
+               LOUDNESS_BLOCK_MS / 1000.0f;
+  
+  float db = loudnessDb;
+  loudnessDb = db + constrain(wanted - db, -slew, slew);
+}
+
+void AudioPipelineClass::adaptDrift() {
+  // Only a live stream in steady state tells the two clocks apart: not
+  // while connecting or rebuffering, and not while a full ring holds
+  // the fetch stage back (a server sending ahead); a file on the card
+  // has no far clock at all. Time-shifted, the backlog keeps the ring
+  // topped up and its depth says nothing about the clocks
+  bool steady = fetchState == FETCH_STREAMING && localSize == 0 && !timeShifted && !rebuffering &&
+                millis() - streamingSince >= DRIFT_SETTLE_MS &&
+                streamRing.space() >= streamRing.capacity() / 4;
+  if (!steady) {
+    driftLocked = false;
+    driftPpm = 0;
+    resampler.setAdjust(0);
+    return;
+  }
+  
+  // Hold the depth where it settled (or at the target, if deeper)
+  uint32_t depth = bytesToMs(streamRing.available());
+  if (!driftLocked) {
+    driftDepthMs = depth;
+    driftSetpointMs = depth;
+    driftLocked = true;
+  }
+  driftDepthMs += (depth - driftDepthMs) / 16;
+  driftSetpointMs = max(driftSetpointMs, (uint32_t)targetMs);
+  
+  // Filling up: the broadcaster's clock is faster, so play faster
+  int32_t ppm = lrintf((driftDepthMs - driftSetpointMs) * DRIFT_PPM_PER_MS);
+  ppm = constrain(ppm, -DRIFT_MAX_PPM, DRIFT_MAX_PPM);
+  driftPpm = ppm;
+  resampler.setAdjust(ppm);
+}
+
+void AudioPipelineClass::sampleTelemetry() {
+  if (fetchState != FETCH_STREAMING) {
+    rateCount = 0;
+    return;
+  }
+  
+  uint32_t depth = bytesToMs(streamRing.available());
+  fillHistogram.add(depth);
+  fillHistory[fillHistoryNext] = (uint16_t)min(depth, (uint32_t)UINT16_MAX);
+  fillHistoryNext = (fillHistoryNext + 1) % TELEMETRY_HISTORY;
+  if (fillHistoryCount < TELEMETRY_HISTORY) {
+    fillHistoryCount++;
+  }
+  
+  // Throughput over the window; the fetch stage reads no faster than
+  // the decoder drains once the buffer is full, so this settles on
+  // the stream's real bitrate
+  const int slots = TELEMETRY_RATE_WINDOW_S + 1;
+  rateSamples[rateNext] = bytesFetched;
+  rateNext = (rateNext + 1) % slots;
+  if (rateCount < slots) {
+    rateCount++;
+  }
+  if (rateCount > 1) {
+    uint32_t oldest = rateSamples[(rateNext - rateCount + slots) % slots];
+    uint32_t newest = rateSamples[(rateNext - 1 + slots) % slots];
+    uint32_t windowMs = (rateCount - 1) * TELEMETRY_SAMPLE_MS;
+    measuredKbps = (uint32_t)((uint64_t)(newest - oldest) * 8 / windowMs);
+  }
+}
+
+void AudioPipelineClass::adaptTarget() {
+  const JitterProfile& profile = jitterProfiles[bufferProfile];
+  unsigned long now = millis();
+  
+  // Enough depth to ride out the worst recent gap
+  uint32_t wanted = max(profile.minMs, (uint32_t)(jitterMs * JITTER_HEADROOM));
+  uint32_t target = targetMs;
+  
+  if (target < wanted) {
+    target = wanted;
+  } else if (target > wanted &&
+             now - lastUnderrun >= JITTER_DECAY_MS &&
+             now - lastShrink >= JITTER_DECAY_MS / 10) {
+    // Long stable stretch: give latency back a tenth at a time
+    target = max(wanted, target - target / 10);
+    lastShrink = now;
+  }
+  
+  targetMs = min(target, profile.maxMs);
+}
+
+size_t AudioPipelineClass::targetBytes() {
+  // Keep a quarter of the ring free so the fetch stage never stalls on it
+  size_t bytes = (size_t)((uint64_t)targetMs * byteRate / 1000);
+  return min(bytes, streamRing.capacity() / 4 * 3);
+}
+
+uint32_t AudioPipelineClass::bytesToMs(size_t bytes) {
+  uint32_t rate = byteRate;
+  return rate > 0 ? (uint32_t)((uint64_t)bytes * 1000 / rate) : 0;
+}
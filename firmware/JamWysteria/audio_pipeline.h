@@ -0,0 +1,320 @@
+/**
+ * Audio Pipeline for Jam Wysteria
+ *
+ * Splits playback into three stages joined by lock-free rings:
+ *
+ *   fetch task  --stream ring-->  decoder  --PCM ring-->  output task
+ *   (HTTP/ICY)     (compressed)   (audio task)  (16-bit)   (I2S)
+ *
+ * A slow network read only drains the stream ring; the decoder and
+ * I2S keep running until it is empty. The decoder reads the stream
+ * ring through a virtual file system and hands PCM over through the
+ * library's audio_process_i2s() hook.
+ *
+ * The stream ring doubles as the jitter buffer: its target depth
+ * follows the measured gaps between network reads and grows after
+ * every underrun, within the bounds of the selected profile.
+ *
+ * The output task resamples to a fixed I2S rate. Once a live stream
+ * has settled it holds the stream ring at that depth by nudging the
+ * resampling ratio, so a broadcaster whose clock runs fast or slow
+ * against ours neither fills the ring nor drains it over hours.
+ *
+ * Pausing a live stream starts a time-shift: the fetch stage keeps
+ * every byte that arrives in a backlog (PSRAM, then SD) behind the
+ * stream ring and tops the ring up from it, so playback resumes from
+ * the pause point and stays behind live until the next station.
+ *
+ * "sd:" URLs are read by the fetch task too, from the card into the
+ * stream ring, which then serves as a read-ahead buffer: SD latency
+ * spikes are absorbed there and never reach the decoder.
+ *
+ * The codec is told by the first bytes of a stream rather than its
+ * Content-Type, which many servers leave generic or get wrong; what
+ * was sniffed is remembered per station in the connection cache.
+ *
+ * A separate low-priority task keeps one neighbouring station
+ * connected, retaining its latest audio. Tuning to it swaps the
+ * connection into the fetch stage instead of dialling out.
+ */
+
+#ifndef AUDIO_PIPELINE_H
+#define AUDIO_PIPELINE_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <driver/i2s.h>
+#include "audio_io.h"
+#include "audio_stages.h"
+#include "http_stream.h"
+#include "connection_cache.h"
+#include "spsc_ring.h"
+#include "pcm_gain.h"
+#include "biquad_eq.h"
+#include "loudness_meter.h"
+#include "polyphase_resampler.h"
+#include "audio_telemetry.h"
+#include "time_shift_buffer.h"
+#include "track_tags.h"
+#include "config.h"
+
+// Fetch stage state
+enum FetchState {
+  FETCH_IDLE,
+  FETCH_CONNECTING,
+  FETCH_STREAMING,
+  FETCH_ENDED,          // Server closed the stream
+  FETCH_ERROR,
+  FETCH_UNSUPPORTED     // Playlist or unknown codec; decoder fetches itself
+};
+
+// Ring fill levels and counters
+struct AudioPipelineLevels {
+  size_t streamFill;
+  size_t streamSize;
+  size_t pcmFill;
+  size_t pcmSize;
+  uint32_t bytesFetched;
+  uint32_t outputUnderruns;
+  uint32_t sampleRate;         // Stream
+  uint32_t outputRate;         // I2S
+  int32_t driftPpm;            // Resampling ratio nudge (+ = playing faster)
+  uint32_t resampleLoad;       // Output task time spent resampling, permille
+  
+  // Jitter buffer
+  int bufferProfile;
+  uint32_t depthMs;           // Buffered stream audio
+  uint32_t targetMs;          // Current target depth
+  uint32_t jitterMs;          // Smoothed worst arrival gap
+  uint32_t streamUnderruns;   // Decoder found the stream ring empty
+  bool rebuffering;
+  
+  // Warm neighbour
+  uint32_t warmPromotions;    // Station changes served by a warm connection
+  
+  // Tone control
+  int eqStages;               // 0 = flat (or bypassed over budget)
+  uint32_t eqLoad;            // Output task time spent filtering, permille
+  
+  // Loudness normalization
+  float loudness;             // Short-term LUFS of the stream (before volume)
+  float loudnessGainDb;       // Normalization gain being applied
+  bool loudnessSettled;
+  
+  // Time-shift
+  bool timeShifted;
+  uint32_t timeShiftMs;       // Behind live
+  size_t timeShiftBytes;      // Backlog beyond the stream ring
+};
+
+// I2S output stage sink
+class I2SOutput : public PcmSink {
+public:
+  I2SOutput(i2s_port_t port);
+  
+  bool begin();
+  bool setSampleRate(uint32_t rate) override;
+  size_t write(const int16_t* frames, size_t count) override;
+  void clear() override;
+  
+private:
+  i2s_port_t port;
+  uint32_t sampleRate;
+};
+
+class AudioPipelineClass {
+public:
+  AudioPipelineClass();
+  
+  // Initialization (allocates rings, starts fetch and output tasks;
+  // PCM goes to I2S unless another sink is given)
+  bool init(PcmSink* pcmSink = nullptr);
+  bool isReady();
+  
+  // Fetch stage (called from the audio task)
+  static bool isLocalURL(const char* url);    // "sd:/..." file on the card
+  static const char* codecForContentType(const String& contentType);  // nullptr = not audio we decode
+  void startFetch(const String& url);
+  void stopFetch();
+  FetchState getFetchState();
+  String getFetchError();
+  const char* getCodecExtension();    // "mp3", "aac", ... for the decoder
+  const char* getResolvedURL();       // Stream behind a playlist, if any
+  size_t getStreamSize();             // Local file length (live streams: no end)
+  
+  // Decode stage glue
+  fs::FS& getStreamFS();              // Virtual "/stream.<ext>" file
+  size_t readStream(uint8_t* buffer, size_t length);
+  size_t writePcm(const int16_t* samples, size_t frames, uint8_t channels);
+  void setSampleRate(uint32_t rate);
+  void setBitrate(uint32_t bitsPerSecond);
+  
+  // Jitter buffer
+  void setBufferProfile(int profile);
+  const char* getBufferProfileName(int profile);
+  bool isBufferReady();               // Target depth reached (prebuffer done)
+  
+  // Warm neighbour ("" = none; applied once a pending station change settles)
+  void setWarmURL(const String& url);
+  
+  // Output stage control
+  void setOutputActive(bool active);  // False while paused or stopped
+  void flushOutput();
+  void setGain(uint32_t gain);        // Q16; ramped over VOLUME_RAMP_MS
+  void setEqualizer(int bassDb, int midDb, int trebleDb);
+  
+  // Loudness normalization (gain to start a stream from; known = learned before)
+  void startLoudness(float gainDb, bool known);
+  bool getLearnedLoudness(float& gainDb);   // False until enough audio was measured
+  
+  // Time-shift (audio task starts it on pause; lasts until the next startFetch)
+  bool startTimeShift();              // False for files or without PSRAM
+  bool isTimeShifted();
+  uint32_t getTimeShiftMs();          // How far behind live playback is
+  
+  // Levels
+  AudioPipelineLevels getLevels();
+  
+  // Telemetry (fills the network and buffering parts)
+  void getTelemetry(AudioTelemetry& telemetry);
+  void resetTelemetry();
+  uint32_t getPcmFrames();            // Written by the decoder so far
+  uint32_t getPcmWaitUs();            // Decoder time spent waiting for the output
+  
+private:
+  bool ready;
+  
+  // Rings
+  SpscRingBuffer streamRing;          // fetch -> decode
+  SpscRingBuffer pcmRing;             // decode -> output
+  
+  // Fetch stage
+  HttpStream streams[2];
+  HttpStream* http;                   // Main stream (fetch task)
+  TaskHandle_t fetchTask;
+  QueueHandle_t fetchQueue;
+  volatile uint32_t fetchSession;
+  volatile bool fetchBusy;
+  volatile FetchState fetchState;
+  char fetchError[64];
+  char codec[8];
+  bool codecSniffed;                  // Codec told by the stream bytes
+  uint8_t sniffBuffer[CODEC_SNIFF_BYTES];  // Stream start, read before the codec is chosen
+  char resolvedURL[STREAM_URL_MAX_LENGTH];
+  volatile size_t localSize;          // 0 = live stream
+  TrackTagReader tags;                // ID3 of the file being read
+  uint32_t bytesFetched;
+  volatile uint32_t advertisedKbps;   // icy-br, 0 = not sent
+  volatile uint32_t decoderKbps;
+  
+  // Time-shift (fetch task moves the backlog into the stream ring)
+  TimeShiftBuffer timeShift;
+  volatile bool timeShifted;
+  
+  // Jitter buffer (fetch task measures, decoder adapts the target)
+  volatile int bufferProfile;
+  volatile uint32_t byteRate;         // Compressed bytes per second
+  volatile uint32_t jitterMs;
+  volatile uint32_t targetMs;
+  volatile bool rebuffering;
+  uint32_t streamUnderruns;
+  unsigned long lastUnderrun;
+  unsigned long lastShrink;
+  volatile unsigned long streamingSince;
+  
+  // Warm neighbour (warm task, under warmLock)
+  HttpStream* warm;
+  TaskHandle_t warmTask;
+  QueueHandle_t warmQueue;
+  SemaphoreHandle_t warmLock;
+  char warmURL[STREAM_URL_MAX_LENGTH];  // Station URL, before playlist resolution
+  char warmCodec[8];
+  uint8_t* warmBuffer;                // Latest neighbour audio (circular)
+  size_t warmWritten;
+  bool warmFailed;                    // Not warmable (playlist, codec, bitrate)
+  unsigned long warmRetryAt;
+  uint32_t warmPromotions;
+  
+  // Output stage
+  I2SOutput output;
+  PcmSink* sink;                      // Output stage target (I2S by default)
+  TaskHandle_t outputTask;
+  volatile uint32_t sampleRate;       // Stream rate, from the decoder
+  volatile uint32_t outputRate;
+  volatile bool outputActive;
+  volatile bool flushRequested;
+  uint32_t outputUnderruns;
+  PolyphaseResampler resampler;       // Output task only
+  volatile int32_t driftPpm;
+  volatile uint32_t resampleLoad;
+  bool driftLocked;                   // Set point taken (output task)
+  uint32_t driftSetpointMs;
+  float driftDepthMs;                 // Smoothed stream ring depth
+  PcmGain gain;                       // Output task only
+  volatile uint32_t gainTarget;
+  BiquadChain equalizer;              // Output task only
+  volatile int eqBass;
+  volatile int eqMid;
+  volatile int eqTreble;
+  volatile uint32_t eqVersion;        // Bumped after the gains change
+  volatile int eqStages;
+  volatile uint32_t eqLoad;
+  LoudnessMeter meter;                // Output task only
+  volatile float loudnessStartDb;
+  volatile bool loudnessKnown;
+  volatile uint32_t loudnessVersion;  // Bumped when a new stream starts
+  volatile uint32_t loudnessApplied;  // Version the output task is measuring
+  volatile float loudnessDb;          // Written by the output task
+  volatile float loudnessLufs;
+  volatile uint32_t loudnessMeasuredMs;
+  
+  // Telemetry (each counter written by one task)
+  unsigned long telemetrySince;
+  uint32_t telemetryBytes;
+  uint32_t pcmFrames;                 // Decoder
+  uint32_t pcmWaitUs;
+  uint32_t telemetryI2sUnderruns;
+  uint32_t telemetryStreamUnderruns;
+  TelemetryHistogram fillHistogram;
+  uint16_t fillHistory[TELEMETRY_HISTORY];
+  int fillHistoryNext;
+  int fillHistoryCount;
+  uint32_t rateSamples[TELEMETRY_RATE_WINDOW_S + 1];   // bytesFetched, once a second
+  int rateNext;
+  int rateCount;
+  volatile uint32_t measuredKbps;
+  
+  // Stage tasks
+  static void fetchTaskEntry(void* param);
+  static void outputTaskEntry(void* param);
+  static void warmTaskEntry(void* param);
+  void fetchLoop();
+  void outputLoop();
+  void warmLoop();
+  
+  // Helper functions
+  void runFetch(uint32_t session, const char* url);
+  void runLocal(uint32_t session, const char* path);
+  bool pumpSource(uint32_t session, AudioSource* source);  // False if the source went silent
+  bool openStream(uint32_t session, const char* url, const StreamParams* known);
+  const char* sniffStream(uint32_t session, size_t& length);
+  bool promoteWarm(const char* url);
+  bool warmAllowed();
+  void openWarm();
+  void readWarm();
+  void closeWarm();
+  void pumpTimeShift();
+  const char* codecForFileName(const char* path);
+  void adaptTarget();
+  void designEqualizer(uint32_t rate);
+  void adaptLoudness();
+  void adaptDrift();
+  void sampleTelemetry();
+  size_t targetBytes();
+  uint32_t bytesToMs(size_t bytes);
+};
+
+// Global instance
+extern AudioPipelineClass AudioPipeline;
+
+#endif // AUDIO_PIPELINE_H
@@ -3,73 +3,174 @@
  */
 
 #include "audio_player.h"
+#include "playlist_resolver.h"
+#include "connection_cache.h"
+#include "loudness_memory.h"
+#include "station_manager.h"
+#include "sd_manager.h"
+#include "stream_recorder.h"
+#include <algorithm>
 
 // Global instance
 AudioPlayerClass AudioPlayer;
 
 AudioPlayerClass::AudioPlayerClass() :
-  audio(),
+  audio(false, 3, I2S_NUM_1),
+  taskHandle(nullptr),
+  commandQueue(nullptr),
+  decodeState(DECODE_IDLE),
+  decodeWaitStart(0),
+  candidateCount(0),
+  candidateIndex(0),
+  retryAttempt(0),
+  retryAt(0),
+  connectedAt(0),
+  decodePaused(false),
+  reconnecting(false),
   playing(false),
   paused(false),
   muted(false),
   currentVolume(VOLUME_DEFAULT),
   volumeBeforeMute(VOLUME_DEFAULT),
   currentURL(""),
-  metadataAvailable(false),
-  lastError(""),
-  hasError(false) {
+  currentStationId(-1),
+  zapDirection(1),
+  trackIndex(0),
+  trackFailures(0),
+  playSession(0),
+  taskSession(0),
+  trackHandled(0),
+  lastStatsLog(0) {
+  streamURL[0] = '\0';
+  candidates[0][0] = '\0';
+  resetTaskStats();
+  memset(&telemetry, 0, sizeof(telemetry));
+  decodeTotalUs = 0;
+  playedUs = 0;
 }
 
 void AudioPlayerClass::init() {
-  // Initialize I2S audio output
-  audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
+  // The library buffer is only the decoder's input window now; the
+  // jitter buffer lives in the pipeline's stream ring
+  if (!audio.setBufsize(AUDIO_BUFFER_SIZE, AUDIO_BUFFER_SIZE)) {
+    Serial.println("[AUDIO] ✗ Could not set decoder buffer size");
+  }
+  
+  // Fetch and I2S output stages; without them the library drives
+  // the amplifier itself on its own I2S port
+  if (!AudioPipeline.init()) {
+    Serial.println("[AUDIO] Pipeline unavailable, using direct decoder output");
+    audio.setPinout(I2S_BCLK, I2S_LRC, I2S_DOUT);
+  } else {
+    // Recording tees the fetch stage, so it needs the pipeline
+    StreamRecorder.init();
+  }
   
-  // Set initial volume
-  audio.setVolume(currentVolume);
+  // Set initial volume (with the pipeline its gain stage does the
+  // work and the decoder stays at full scale)
+  if (AudioPipeline.isReady()) {
+    audio.setVolume(VOLUME_LIBRARY_MAX);
+    applyVolume(currentVolume);
+  } else {
+    audio.setVolume(libraryVolume(currentVolume));
+  }
   
   // Set buffer size
   audio.setConnectionTimeout(STREAM_CONNECT_TIMEOUT, STREAM_RECONNECT_DELAY);
   
+  // Resolved playlist URLs from earlier sessions
+  PlaylistResolver.load();
+  
+  // Normalization gains learned for stations in earlier sessions
+  LoudnessMemory.load();
+  
+  // Start the audio task; from here on only it touches `audio`
+  commandQueue = xQueueCreate(AUDIO_COMMAND_QUEUE_LEN, sizeof(AudioCommand));
+  xTaskCreatePinnedToCore(taskEntry, "audio", AUDIO_TASK_STACK, this,
+                          AUDIO_TASK_PRIORITY, &taskHandle, AUDIO_TASK_CORE);
+  
   Serial.println("[AUDIO] Initialized");
   Serial.printf("[AUDIO] I2S Pins - BCLK:%d, LRC:%d, DOUT:%d\n", 
                 I2S_BCLK, I2S_LRC, I2S_DOUT);
+  Serial.printf("[AUDIO] Task on core %d, priority %d\n",
+                AUDIO_TASK_CORE, AUDIO_TASK_PRIORITY);
   Serial.printf("[AUDIO] Default volume: %d/%d\n", currentVolume, VOLUME_MAX);
 }
 
-bool AudioPlayerClass::playStation(const String& url) {
+bool AudioPlayerClass::playStation(const String& url, const std::vector<String>& mirrors) {
   Serial.printf("[AUDIO] Playing: %s\n", url.c_str());
   
-  // Stop current playback
-  if (playing) {
-    stop();
+  if (url.length() >= STREAM_URL_MAX_LENGTH) {
+    postStatus(playSession, "Stream URL too long", false, false);
+    Serial.println("[AUDIO] ✗ URL too long");
+    return false;
   }
   
   // Clear metadata
-  clearMetadata();
+  metadata.clear();
   
-  // Clear error
-  hasError = false;
-  lastError = "";
+  // A recording belongs to the station it started on
+  StreamRecorder.stop();
   
-  // Start new stream
-  if (audio.connecttohost(url.c_str())) {
-    currentURL = url;
-    playing = true;
-    paused = false;
-    
-    Serial.println("[AUDIO] ✓ Stream connected");
-    return true;
-  } else {
-    hasError = true;
-    lastError = "Failed to connect to stream";
-    Serial.println("[AUDIO] ✗ Connection failed");
+  // A folder on the card plays its audio files in turn
+  tracks.clear();
+  if (AudioPipelineClass::isLocalURL(url.c_str()) && !loadTracks(url)) {
+    postStatus(playSession, "No playable files", false, false);
     return false;
   }
+  
+  // Keep what was learned about the outgoing station, start the new
+  // one from its own level
+  rememberLoudness();
+  float gainDb = 0;
+  bool known = LoudnessMemory.lookup(url, gainDb);
+  AudioPipeline.startLoudness(gainDb, known);
+  
+  // The task stops any current stream before connecting
+  if (!queuePlay(tracks.empty() ? url : tracks[0])) {
+    return false;
+  }
+  
+  // Alternates follow the play command, so the task has them before
+  // its first retry
+  int queued = 0;
+  for (const auto& mirror : mirrors) {
+    if (queued >= STREAM_MAX_MIRRORS) {
+      break;
+    }
+    if (mirror.length() > 0 && mirror.length() < STREAM_URL_MAX_LENGTH &&
+        sendCommand(AUDIO_CMD_ADD_URL, 0, mirror)) {
+      queued++;
+    }
+  }
+  
+  currentURL = url;
+  currentStationId = -1;
+  reconnecting = false;
+  playing = true;
+  paused = false;
+  
+  if (!tracks.empty()) {
+    trackIndex = 0;
+    trackFailures = 0;
+    publishStation(tracks[0].c_str() + tracks[0].lastIndexOf('/') + 1);
+  }
+  return true;
+}
+
+bool AudioPlayerClass::playStation(const Station& station) {
+  if (!playStation(station.url, station.mirrors)) {
+    return false;
+  }
+  
+  currentStationId = station.id;
+  updateNeighbour();
+  return true;
 }
 
 void AudioPlayerClass::pause() {
   if (playing && !paused) {
-    audio.pauseResume();
+    sendCommand(AUDIO_CMD_PAUSE);
     paused = true;
     Serial.println("[AUDIO] Paused");
   }
@@ -77,7 +178,7 @@ void AudioPlayerClass::pause() {
 
 void AudioPlayerClass::resume() {
   if (playing && paused) {
-    audio.pauseResume();
+    sendCommand(AUDIO_CMD_RESUME);
     paused = false;
     Serial.println("[AUDIO] Resumed");
   }
@@ -85,11 +186,17 @@ void AudioPlayerClass::resume() {
 
 void AudioPlayerClass::stop() {
   if (playing) {
-    audio.stopSong();
+    rememberLoudness();
+    StreamRecorder.stop();
+    sendCommand(AUDIO_CMD_STOP);
     playing = false;
     paused = false;
+    reconnecting = false;
     currentURL = "";
-    clearMetadata();
+    currentStationId = -1;
+    tracks.clear();
+    sendCommand(AUDIO_CMD_WARM);
+    metadata.clear();
     
     Serial.println("[AUDIO] Stopped");
   }
@@ -103,22 +210,54 @@ bool AudioPlayerClass::isPaused() {
   return paused;
 }
 
-void AudioPlayerClass::next() {
-  // Next track (if supported by stream/playlist)
-  // For most live streams, this won't do anything
-  Serial.println("[AUDIO] Next track requested");
-  // audio.next(); // If supported by library
+uint32_t AudioPlayerClass::getTimeBehindMs() {
+  return AudioPipeline.isReady() ? AudioPipeline.getTimeShiftMs() : 0;
+}
+
+bool AudioPlayerClass::startRecording(bool splitTracks) {
+  // Only a live stream the fetch stage is reading can be teed
+  if (!playing || !AudioPipeline.isReady() || AudioPipelineClass::isLocalURL(currentURL.c_str()) ||
+      AudioPipeline.getFetchState() != FETCH_STREAMING) {
+    return false;
+  }
+  
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  return StreamRecorder.start(snapshot.station, AudioPipeline.getCodecExtension(), splitTracks);
 }
 
-void AudioPlayerClass::previous() {
-  // Previous track (if supported by stream/playlist)
-  Serial.println("[AUDIO] Previous track requested");
-  // audio.previous(); // If supported by library
+void AudioPlayerClass::stopRecording() {
+  StreamRecorder.stop();
+}
+
+void AudioPlayerClass::jumpToLive() {
+  if (playing && AudioPipeline.isTimeShifted() && sendCommand(AUDIO_CMD_LIVE)) {
+    paused = false;
+    Serial.println("[AUDIO] Jumping to live");
+  }
+}
+
+Station* AudioPlayerClass::next() {
+  if (!tracks.empty()) {
+    return playTrack(trackIndex + 1) ? StationManager.getStation(currentStationId) : nullptr;
+  }
+  return step(1);
+}
+
+Station* AudioPlayerClass::previous() {
+  if (!tracks.empty()) {
+    return playTrack(trackIndex - 1) ? StationManager.getStation(currentStationId) : nullptr;
+  }
+  return step(-1);
 }
 
 bool AudioPlayerClass::canSkip() {
-  // Most live streams don't support skipping
-  return false;
+  if (!tracks.empty()) {
+    return tracks.size() > 1;
+  }
+  
+  std::vector<Station*> list = StationManager.getCurrentStations();
+  return list.size() > 1 && findCurrentStation(list) >= 0;
 }
 
 void AudioPlayerClass::setVolume(int volume) {
@@ -129,7 +268,7 @@ void AudioPlayerClass::setVolume(int volume) {
   currentVolume = volume;
   
   if (!muted) {
-    audio.setVolume(volume);
+    applyVolume(volume);
   }
   
   #ifdef DEBUG_MODE
@@ -152,7 +291,7 @@ void AudioPlayerClass::volumeDown() {
 void AudioPlayerClass::mute() {
   if (!muted) {
     volumeBeforeMute = currentVolume;
-    audio.setVolume(0);
+    applyVolume(0);
     muted = true;
     Serial.println("[AUDIO] Muted");
   }
@@ -160,7 +299,7 @@ void AudioPlayerClass::mute() {
 
 void AudioPlayerClass::unmute() {
   if (muted) {
-    audio.setVolume(volumeBeforeMute);
+    applyVolume(volumeBeforeMute);
     muted = false;
     Serial.println("[AUDIO] Unmuted");
   }
@@ -170,58 +309,739 @@ bool AudioPlayerClass::isMuted() {
   return muted;
 }
 
+void AudioPlayerClass::applyVolume(int volume) {
+  if (!AudioPipeline.isReady()) {
+    sendCommand(AUDIO_CMD_VOLUME, libraryVolume(volume));
+    return;
+  }
+  
+  uint32_t gain = 0;
+  if (volume > VOLUME_MIN) {
+    gain = PcmGain::fromDecibels((volume - VOLUME_MAX) * VOLUME_DB_PER_STEP);
+  }
+  AudioPipeline.setGain(gain);
+}
+
+int AudioPlayerClass::libraryVolume(int volume) {
+  // Direct decoder output: the library's own 0-21 scale
+  return (volume * VOLUME_LIBRARY_MAX + VOLUME_MAX / 2) / VOLUME_MAX;
+}
+
+void AudioPlayerClass::rememberLoudness() {
+  // Only a gain measured over enough of the stream is worth keeping
+  float gainDb;
+  if (playing && currentURL.length() > 0 && AudioPipeline.getLearnedLoudness(gainDb)) {
+    LoudnessMemory.store(currentURL, gainDb);
+  }
+}
+
 StreamMetadata AudioPlayerClass::getMetadata() {
-  return metadata;
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  
+  StreamMetadata result;
+  result.title = snapshot.title[0] != '\0' ? snapshot.title : snapshot.station;
+  result.artist = snapshot.artist;
+  result.album = snapshot.album;
+  result.genre = snapshot.genre;
+  result.station = snapshot.station;
+  result.bitrate = snapshot.bitrate;
+  result.hasAlbumArt = snapshot.art[0] != '\0';
+  result.albumArtURL = snapshot.art;
+  result.streamURL = snapshot.url;
+  return result;
 }
 
 String AudioPlayerClass::getTitle() {
-  return metadata.title;
+  // Station name until the first stream title arrives
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  return snapshot.title[0] != '\0' ? snapshot.title : snapshot.station;
 }
 
 String AudioPlayerClass::getArtist() {
-  return metadata.artist;
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  return snapshot.artist;
 }
 
 String AudioPlayerClass::getAlbum() {
-  return metadata.album;
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  return snapshot.album;
 }
 
 int AudioPlayerClass::getBitrate() {
-  return metadata.bitrate;
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  return snapshot.bitrate;
 }
 
 bool AudioPlayerClass::hasMetadata() {
-  return metadataAvailable;
+  MetadataSnapshot snapshot;
+  metadata.read(snapshot);
+  return snapshot.available;
+}
+
+uint32_t AudioPlayerClass::getMetadataVersion() {
+  return metadata.version();
+}
+
+void AudioPlayerClass::publishStation(const char* name) {
+  metadata.setStation(name);
+}
+
+void AudioPlayerClass::publishStreamTitle(const char* streamTitle) {
+  // Usually "Artist - Title"; split and copied by the mailbox
+  metadata.setStreamInfo(IcySpan{streamTitle, strlen(streamTitle)}, IcySpan{nullptr, 0});
+}
+
+void AudioPlayerClass::publishStreamMetadata(const IcyMetadataParser& block) {
+  metadata.setStreamInfo(block.find("StreamTitle"), block.find("StreamUrl"));
+}
+
+void AudioPlayerClass::publishTag(Id3Field field, const char* text) {
+  metadata.setTag(field, text);
+}
+
+void AudioPlayerClass::publishAlbumArt(const char* path) {
+  metadata.setAlbumArt(path);
+}
+
+void AudioPlayerClass::publishBitrate(int bitrate) {
+  metadata.setBitrate(bitrate);
 }
 
 void AudioPlayerClass::update() {
-  // Update audio loop (must be called regularly)
-  if (playing) {
-    audio.loop();
+  // Resolved playlist URLs are written to SD from here, not the fetch task
+  PlaylistResolver.update();
+  LoudnessMemory.update();
+  
+  // What the audio task made of the current play command
+  PlaybackStatus current;
+  if (readStatus(current)) {
+    if (current.failed) {
+      playing = false;
+    }
+    
+    // A file ended: move on through the folder
+    if (current.trackEnded && trackHandled != current.session) {
+      trackHandled = current.session;
+      trackFinished(current.trackFailed);
+    }
+  }
+  
+  // Decoding runs on the audio task; just report its headroom
+  #ifdef DEBUG_MODE
+  unsigned long now = millis();
+  if (playing && now - lastStatsLog > 10000) {
+    lastStatsLog = now;
+    AudioTaskStats stats = getTaskStats();
+    Serial.printf("[AUDIO] Task busy avg/max: %uus/%uus, min slack: %dus, overruns: %u, stack free: %u\n",
+                  stats.avgBusyUs, stats.maxBusyUs, stats.minSlackUs,
+                  stats.overruns, stats.stackFree);
+    
+    AudioPipelineLevels levels = AudioPipeline.getLevels();
+    Serial.printf("[AUDIO] Stream ring: %u/%u, PCM ring: %u/%u, underruns: %u, warm starts: %u\n",
+                  levels.streamFill, levels.streamSize, levels.pcmFill, levels.pcmSize,
+                  levels.outputUnderruns, levels.warmPromotions);
+    Serial.printf("[AUDIO] Jitter buffer (%s): %ums/%ums, jitter: %ums, underruns: %u%s\n",
+                  AudioPipeline.getBufferProfileName(levels.bufferProfile),
+                  levels.depthMs, levels.targetMs, levels.jitterMs,
+                  levels.streamUnderruns, levels.rebuffering ? " (rebuffering)" : "");
+    
+    ConnectionCacheStats cache = ConnectionCache.getStats();
+    Serial.printf("[AUDIO] Connection cache: %d hosts (%u hits, %u lookups), %d streams (%u hits)\n",
+                  cache.hosts, cache.dnsHits, cache.dnsMisses, cache.params, cache.paramHits);
+    AudioTelemetry telemetry = getTelemetry();
+    Serial.printf("[AUDIO] Throughput %u kbps (advertised %u, decoder %u), decode cycle p95 %uus, load %u.%u%%, reconnects %u\n",
+                  telemetry.measuredKbps, telemetry.advertisedKbps, telemetry.decoderKbps,
+                  telemetry.decodeCycleUs.percentile(95), telemetry.decodeLoad / 10,
+                  telemetry.decodeLoad % 10, telemetry.reconnects);
+    Serial.printf("[AUDIO] Resampler: %u -> %u Hz, drift %+d ppm, load %u.%u%%\n",
+                  levels.sampleRate, levels.outputRate, levels.driftPpm,
+                  levels.resampleLoad / 10, levels.resampleLoad % 10);
+    Serial.printf("[AUDIO] Loudness: %.1f LUFS, normalization %+.1f dB%s, %d stations learned\n",
+                  levels.loudness, levels.loudnessGainDb,
+                  levels.loudnessSettled ? "" : " (settling)", LoudnessMemory.getCount());
+    if (StreamRecorder.isRecording()) {
+      RecorderStatus record = StreamRecorder.getStatus();
+      Serial.printf("[AUDIO] Recording %s: %u KB, %u dropped, tee %uus, SD %ums\n",
+                    record.path.c_str(), record.bytesWritten / 1024, record.bytesDropped,
+                    record.teeUs, record.writeUs / 1000);
+    }
+    if (levels.timeShifted) {
+      Serial.printf("[AUDIO] Time-shift: %ums behind live, %u KB backlog\n",
+                    levels.timeShiftMs, levels.timeShiftBytes / 1024);
+    }
   }
+  #endif
 }
 
 bool AudioPlayerClass::isConnected() {
-  return playing && !hasError;
+  PlaybackStatus current;
+  return playing && !(readStatus(current) && current.failed);
+}
+
+bool AudioPlayerClass::isReconnecting() {
+  return playing && reconnecting;
 }
 
 String AudioPlayerClass::getError() {
-  return lastError;
+  PlaybackStatus current;
+  return readStatus(current) ? String(current.error) : String();
+}
+
+AudioTaskStats AudioPlayerClass::getTaskStats() {
+  AudioTaskStats stats = taskStats;
+  if (taskHandle != nullptr) {
+    stats.stackFree = uxTaskGetStackHighWaterMark(taskHandle);
+  }
+  return stats;
 }
 
-void AudioPlayerClass::clearMetadata() {
-  metadata.title = "";
-  metadata.artist = "";
-  metadata.album = "";
-  metadata.genre = "";
-  metadata.bitrate = 0;
-  metadata.hasAlbumArt = false;
-  metadata.albumArtURL = "";
-  metadataAvailable = false;
+void AudioPlayerClass::resetTaskStats() {
+  memset(&taskStats, 0, sizeof(taskStats));
+  taskStats.minSlackUs = AUDIO_TASK_BUDGET_US;
 }
 
-void AudioPlayerClass::updateMetadata() {
-  metadataAvailable = true;
+AudioTelemetry AudioPlayerClass::getTelemetry() {
+  AudioTelemetry result = telemetry;
+  uint64_t played = playedUs;
+  result.decodeLoad = played > 0 ? (uint32_t)(decodeTotalUs * 1000 / played) : 0;
+  AudioPipeline.getTelemetry(result);
+  return result;
+}
+
+void AudioPlayerClass::resetTelemetry() {
+  memset(&telemetry, 0, sizeof(telemetry));
+  decodeTotalUs = 0;
+  playedUs = 0;
+  AudioPipeline.resetTelemetry();
+}
+
+// ============================================================================
+// Audio Task
+// ============================================================================
+
+void AudioPlayerClass::taskEntry(void* param) {
+  ((AudioPlayerClass*)param)->taskLoop();
+}
+
+void AudioPlayerClass::taskLoop() {
+  AudioCommand command;
+  
+  while (true) {
+    // Idle: sleep until a command arrives. Backing off: sleep until the
+    // retry is due (a command still wakes us). Streaming: yield one tick
+    // per cycle so lower-priority tasks on this core still run
+    TickType_t wait = (decodeState != DECODE_IDLE) ? 1 : portMAX_DELAY;
+    if (decodeState == DECODE_BACKOFF) {
+      long remaining = (long)(retryAt - millis());
+      wait = remaining > 0 ? pdMS_TO_TICKS(remaining) + 1 : 0;
+    }
+    while (xQueueReceive(commandQueue, &command, wait) == pdTRUE) {
+      handleCommand(command);
+      wait = 0;
+    }
+    
+    if (decodeState == DECODE_BACKOFF) {
+      if ((long)(millis() - retryAt) >= 0) {
+        connectCandidate();
+      }
+      continue;
+    }
+    
+    if (decodeState == DECODE_WAITING) {
+      startDecoder();
+      continue;
+    }
+    
+    if (decodeState == DECODE_IDLE) {
+      continue;
+    }
+    
+    uint32_t framesBefore = AudioPipeline.getPcmFrames();
+    uint32_t waitBefore = AudioPipeline.getPcmWaitUs();
+    int64_t start = esp_timer_get_time();
+    audio.loop();
+    uint32_t busyUs = (uint32_t)(esp_timer_get_time() - start);
+    recordCycle(busyUs);
+    recordDecode(busyUs, AudioPipeline.getPcmFrames() - framesBefore,
+                 AudioPipeline.getPcmWaitUs() - waitBefore);
+    
+    AudioPipeline.setSampleRate(audio.getSampleRate());
+    AudioPipeline.setBitrate(audio.getBitRate());
+    
+    // A file plays to its end once; the decoder stops when it gets there
+    if (AudioPipelineClass::isLocalURL(streamURL)) {
+      if (decodeState == DECODE_PIPELINE && AudioPipeline.getFetchState() == FETCH_ERROR) {
+        String error = AudioPipeline.getFetchError();
+        finishTrack(error.c_str());
+      } else if (!decodePaused && !audio.isRunning()) {
+        finishTrack(nullptr);
+      }
+      continue;
+    }
+    
+    // Fetch stage gone and everything it delivered has been decoded
+    if (decodeState == DECODE_PIPELINE) {
+      FetchState fetch = AudioPipeline.getFetchState();
+      if ((fetch == FETCH_ENDED || fetch == FETCH_ERROR) &&
+          AudioPipeline.getLevels().streamFill == 0) {
+        retryOrFail("Stream ended");
+        continue;
+      }
+    }
+    
+    // Library dropped a stream we did not pause
+    if (decodeState == DECODE_DIRECT && !decodePaused && !audio.isRunning()) {
+      retryOrFail("Stream lost");
+      continue;
+    }
+    
+    // A stream that has played for a while earns a fresh retry budget
+    if (retryAttempt > 0 && millis() - connectedAt >= STREAM_STABLE_MS) {
+      retryAttempt = 0;
+    }
+  }
+}
+
+void AudioPlayerClass::handleCommand(const AudioCommand& command) {
+  switch (command.type) {
+    case AUDIO_CMD_PLAY:
+      stopDecoder();
+      taskSession = (uint32_t)command.value;
+      strlcpy(candidates[0], command.url, sizeof(candidates[0]));
+      candidateCount = 1;
+      candidateIndex = 0;
+      retryAttempt = 0;
+      reconnecting = false;
+      connectCandidate();
+      break;
+      
+    case AUDIO_CMD_ADD_URL:
+      if (candidateCount > 0 && candidateCount <= STREAM_MAX_MIRRORS) {
+        strlcpy(candidates[candidateCount], command.url, sizeof(candidates[0]));
+        candidateCount++;
+      }
+      break;
+      
+    case AUDIO_CMD_WARM:
+      if (AudioPipeline.isReady()) {
+        AudioPipeline.setWarmURL(command.url);
+      }
+      break;
+      
+    case AUDIO_CMD_STOP:
+      stopDecoder();
+      candidateCount = 0;
+      reconnecting = false;
+      break;
+      
+    case AUDIO_CMD_PAUSE:
+    case AUDIO_CMD_RESUME:
+      // pauseResume() toggles, so only act when the state differs
+      if ((decodeState == DECODE_PIPELINE || decodeState == DECODE_DIRECT) &&
+          audio.isRunning() == (command.type == AUDIO_CMD_PAUSE)) {
+        audio.pauseResume();
+        decodePaused = (command.type == AUDIO_CMD_PAUSE);
+        AudioPipeline.setOutputActive(command.type == AUDIO_CMD_RESUME);
+        
+        // A live stream keeps arriving; record it instead of losing it
+        if (decodePaused && decodeState == DECODE_PIPELINE && AudioPipeline.startTimeShift()) {
+          Serial.println("[AUDIO] Time-shifting");
+        }
+      }
+      break;
+      
+    case AUDIO_CMD_LIVE:
+      // A fresh connection starts at live; the backlog goes with the old one
+      if (decodeState == DECODE_PIPELINE && AudioPipeline.isTimeShifted()) {
+        stopDecoder();
+        retryAttempt = 0;
+        connectCandidate();
+      }
+      break;
+      
+    case AUDIO_CMD_VOLUME:
+      audio.setVolume(command.value);
+      break;
+  }
+}
+
+void AudioPlayerClass::startDecoder() {
+  AudioPipelineLevels levels = AudioPipeline.getLevels();
+  
+  switch (AudioPipeline.getFetchState()) {
+    case FETCH_CONNECTING:
+      break;
+      
+    case FETCH_STREAMING:
+    case FETCH_ENDED:
+      // Prebuffer to the jitter target (short streams start with what they have)
+      if (AudioPipeline.isBufferReady() ||
+          (AudioPipeline.getFetchState() == FETCH_ENDED && levels.streamFill > 0)) {
+        String path = String("/stream.") + AudioPipeline.getCodecExtension();
+        AudioPipeline.setOutputActive(true);
+        
+        if (audio.connecttoFS(AudioPipeline.getStreamFS(), path.c_str())) {
+          decodeState = DECODE_PIPELINE;
+          decoderStarted();
+          Serial.printf("[AUDIO] ✓ Decoding %s after %lums (%ums buffered)\n",
+                        path.c_str(), millis() - decodeWaitStart, levels.depthMs);
+        } else {
+          retryOrFail("Unsupported stream format", false);
+        }
+        return;
+      }
+      break;
+      
+    case FETCH_UNSUPPORTED:
+      // HLS and odd content types: let the library fetch them, starting
+      // past any playlist the fetch stage already resolved
+      AudioPipeline.setOutputActive(true);
+      if (audio.connecttohost(AudioPipeline.getResolvedURL()[0] != '\0' ?
+                              AudioPipeline.getResolvedURL() : streamURL)) {
+        decodeState = DECODE_DIRECT;
+        decoderStarted();
+        Serial.println("[AUDIO] ✓ Stream connected (direct)");
+      } else {
+        retryOrFail("Failed to connect to stream");
+      }
+      return;
+      
+    case FETCH_ERROR:
+      {
+        String error = AudioPipeline.getFetchError();
+        retryOrFail(error.length() > 0 ? error.c_str() : "Failed to connect to stream");
+      }
+      return;
+      
+    case FETCH_IDLE:
+      stopDecoder();
+      return;
+  }
+  
+  if (millis() - decodeWaitStart > STREAM_CONNECT_TIMEOUT * 2) {
+    retryOrFail("Stream timed out");
+  }
+}
+
+void AudioPlayerClass::stopDecoder() {
+  if (decodeState == DECODE_PIPELINE || decodeState == DECODE_DIRECT) {
+    audio.stopSong();
+  }
+  
+  if (AudioPipeline.isReady()) {
+    AudioPipeline.setOutputActive(false);
+    AudioPipeline.stopFetch();
+    AudioPipeline.flushOutput();
+  }
+  
+  decodeState = DECODE_IDLE;
+  decodePaused = false;
+}
+
+void AudioPlayerClass::connectCandidate() {
+  strlcpy(streamURL, candidates[candidateIndex], sizeof(streamURL));
+  
+  if (retryAttempt > 0) {
+    Serial.printf("[AUDIO] Reconnecting (attempt %d): %s\n", retryAttempt, streamURL);
+  }
+  
+  if (AudioPipeline.isReady()) {
+    AudioPipeline.startFetch(streamURL);
+    decodeState = DECODE_WAITING;
+    decodeWaitStart = millis();
+  } else if (AudioPipelineClass::isLocalURL(streamURL)) {
+    if (audio.connecttoFS(SD, streamURL + strlen(LOCAL_URL_PREFIX))) {
+      decodeState = DECODE_DIRECT;
+      decoderStarted();
+    } else {
+      finishTrack("Cannot play file");
+    }
+  } else if (audio.connecttohost(streamURL)) {
+    decodeState = DECODE_DIRECT;
+    decoderStarted();
+    Serial.println("[AUDIO] ✓ Stream connected");
+  } else {
+    retryOrFail("Failed to connect to stream");
+  }
+}
+
+void AudioPlayerClass::decoderStarted() {
+  telemetry.connects++;
+  connectedAt = millis();
+  reconnecting = false;
+}
+
+void AudioPlayerClass::retryOrFail(const char* reason, bool transient) {
+  // A file that will not open or decode fails the same way next time
+  if (AudioPipelineClass::isLocalURL(streamURL)) {
+    finishTrack(reason);
+    return;
+  }
+  
+  stopDecoder();
+  
+  // A format problem on the only URL will not go away by retrying
+  int limit = STREAM_MAX_RECONNECTS * candidateCount;
+  if (candidateCount == 0 || (!transient && candidateCount == 1) || retryAttempt >= limit) {
+    reconnecting = false;
+    reportError(reason);
+    return;
+  }
+  
+  // Each URL gets a go at every delay before it doubles; randomizing
+  // the upper half keeps players behind one outage from retrying in step
+  int level = min(retryAttempt / candidateCount, 16);
+  uint32_t delayMs = min((uint32_t)STREAM_BACKOFF_BASE_MS << level, (uint32_t)STREAM_BACKOFF_MAX_MS);
+  delayMs = delayMs / 2 + esp_random() % (delayMs / 2 + 1);
+  
+  retryAttempt++;
+  telemetry.reconnects++;
+  candidateIndex = (candidateIndex + 1) % candidateCount;
+  retryAt = millis() + delayMs;
+  decodeState = DECODE_BACKOFF;
+  reconnecting = true;
+  
+  Serial.printf("[AUDIO] %s, retry %d/%d in %lums\n",
+                reason, retryAttempt, limit, (unsigned long)delayMs);
+}
+
+void AudioPlayerClass::reportError(const char* message) {
+  telemetry.failures++;
+  
+  // The UI may have queued another station while this one retried;
+  // that one is not ours to fail
+  if (taskSession != playSession.load(std::memory_order_acquire)) {
+    Serial.printf("[AUDIO] ✗ %s (superseded)\n", message);
+    return;
+  }
+  postStatus(taskSession, message, true, false);
+  Serial.printf("[AUDIO] ✗ %s\n", message);
+}
+
+void AudioPlayerClass::finishTrack(const char* error) {
+  stopDecoder();
+  candidateCount = 0;
+  
+  // The UI side picks the next track (or stops) from update()
+  if (error != nullptr) {
+    telemetry.failures++;
+    Serial.printf("[AUDIO] ✗ %s: %s\n", error, streamURL);
+  }
+  postStatus(taskSession, error, false, true);
+}
+
+void AudioPlayerClass::postStatus(uint32_t session, const char* error, bool failed, bool trackEnded) {
+  status.publish([=](PlaybackStatus& next) {
+    // A late write for an older session must not cover a newer one
+    if ((int32_t)(session - next.session) < 0) {
+      return;
+    }
+    if (session != next.session) {
+      memset(&next, 0, sizeof(next));
+      next.session = session;
+    }
+    
+    if (error != nullptr) {
+      strncpy(next.error, error, sizeof(next.error) - 1);
+    }
+    next.failed = next.failed || failed;
+    if (trackEnded) {
+      next.trackEnded = true;
+      next.trackFailed = error != nullptr;
+    }
+  });
+}
+
+bool AudioPlayerClass::readStatus(PlaybackStatus& out) {
+  // Anything from before the last PLAY is stale
+  status.read(out);
+  return out.session == playSession.load(std::memory_order_acquire);
+}
+
+void AudioPlayerClass::recordCycle(uint32_t busyUs) {
+  int32_t slack = (int32_t)AUDIO_TASK_BUDGET_US - (int32_t)busyUs;
+  
+  taskStats.cycles++;
+  taskStats.lastBusyUs = busyUs;
+  taskStats.avgBusyUs = (taskStats.avgBusyUs * 15 + busyUs) / 16;
+  
+  if (busyUs > taskStats.maxBusyUs) {
+    taskStats.maxBusyUs = busyUs;
+  }
+  if (slack < taskStats.minSlackUs) {
+    taskStats.minSlackUs = slack;
+  }
+  if (slack < 0) {
+    taskStats.overruns++;
+  }
+}
+
+void AudioPlayerClass::recordDecode(uint32_t busyUs, uint32_t frames, uint32_t waitUs) {
+  // Cycles that only parsed headers or waited for data decoded nothing
+  uint32_t rate = audio.getSampleRate();
+  if (frames == 0 || rate == 0) {
+    return;
+  }
+  
+  // Time blocked on a full PCM ring is the output's pace, not decoding
+  uint32_t decodeUs = busyUs > waitUs ? busyUs - waitUs : 0;
+  
+  // One sample per cycle, however many codec frames it took; `frames`
+  // counts PCM frames, which the codec does not split evenly
+  telemetry.decodeCycles++;
+  telemetry.decodeCycleUs.add(decodeUs);
+  decodeTotalUs += decodeUs;
+  playedUs += (uint64_t)frames * 1000000 / rate;
+}
+
+bool AudioPlayerClass::queuePlay(const String& url) {
+  // The session is current before the task can report on it
+  uint32_t previous = playSession.load(std::memory_order_relaxed);
+  playSession.store(previous + 1, std::memory_order_release);
+  
+  if (!sendCommand(AUDIO_CMD_PLAY, (int)(previous + 1), url)) {
+    playSession.store(previous, std::memory_order_release);
+    return false;
+  }
+  return true;
+}
+
+bool AudioPlayerClass::sendCommand(AudioCommandType type, int value, const String& url) {
+  if (commandQueue == nullptr) {
+    return false;
+  }
+  
+  AudioCommand command;
+  command.type = type;
+  command.value = value;
+  strlcpy(command.url, url.c_str(), sizeof(command.url));
+  
+  if (xQueueSend(commandQueue, &command, pdMS_TO_TICKS(100)) != pdTRUE) {
+    taskStats.commandsDropped++;
+    Serial.println("[AUDIO] ✗ Command queue full");
+    return false;
+  }
+  
+  return true;
+}
+
+Station* AudioPlayerClass::step(int direction) {
+  std::vector<Station*> list = StationManager.getCurrentStations();
+  int index = findCurrentStation(list);
+  if (index < 0 || list.size() < 2) {
+    return nullptr;
+  }
+  
+  int count = list.size();
+  Station* station = list[(index + direction + count) % count];
+  zapDirection = direction;
+  
+  Serial.printf("[AUDIO] %s station: %s\n", direction > 0 ? "Next" : "Previous",
+                station->name.c_str());
+  return playStation(*station) ? station : nullptr;
+}
+
+int AudioPlayerClass::findCurrentStation(const std::vector<Station*>& list) {
+  for (size_t i = 0; i < list.size(); i++) {
+    if (list[i]->id == currentStationId) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void AudioPlayerClass::updateNeighbour() {
+  // Keep the station in the direction the user last zapped connected
+  std::vector<Station*> list = StationManager.getCurrentStations();
+  int index = findCurrentStation(list);
+  if (index < 0 || list.size() < 2) {
+    sendCommand(AUDIO_CMD_WARM);
+    return;
+  }
+  
+  // Files need no warming: the card answers at once
+  int count = list.size();
+  const String& url = list[(index + zapDirection + count) % count]->url;
+  sendCommand(AUDIO_CMD_WARM, 0, AudioPipelineClass::isLocalURL(url.c_str()) ? String() : url);
+}
+
+bool AudioPlayerClass::loadTracks(const String& url) {
+  String path = url.substring(strlen(LOCAL_URL_PREFIX));
+  SDDirIterator dir = SDManager.openDir(path, LOCAL_FILE_TYPES);
+  if (!dir.isOpen()) {
+    return true;    // A single file
+  }
+  
+  if (!path.endsWith("/")) {
+    path += "/";
+  }
+  
+  String name;
+  bool isDirectory;
+  while (tracks.size() < LOCAL_MAX_TRACKS && dir.next(name, isDirectory)) {
+    if (!isDirectory) {
+      tracks.push_back(String(LOCAL_URL_PREFIX) + path + name);
+    }
+  }
+  dir.close();
+  
+  std::sort(tracks.begin(), tracks.end());
+  Serial.printf("[AUDIO] Folder %s: %u tracks\n", path.c_str(), tracks.size());
+  return !tracks.empty();
+}
+
+bool AudioPlayerClass::playTrack(int index) {
+  int count = tracks.size();
+  trackIndex = (index % count + count) % count;
+  const String& track = tracks[trackIndex];
+  
+  // Same folder, same normalization: the gain carries over like an album's
+  metadata.clear();
+  
+  if (!queuePlay(track)) {
+    return false;
+  }
+  
+  publishStation(track.c_str() + track.lastIndexOf('/') + 1);
+  reconnecting = false;
+  playing = true;
+  paused = false;
+  
+  Serial.printf("[AUDIO] Track %d/%d: %s\n", trackIndex + 1, count, track.c_str());
+  return true;
+}
+
+void AudioPlayerClass::trackFinished(bool failed) {
+  if (!playing) {
+    return;
+  }
+  
+  // A single file plays once
+  if (tracks.empty()) {
+    if (failed) {
+      postStatus(playSession, nullptr, true, false);
+    }
+    playing = false;
+    Serial.println("[AUDIO] Playback finished");
+    return;
+  }
+  
+  // Give up once every track in the folder has failed in a row
+  trackFailures = failed ? trackFailures + 1 : 0;
+  if (trackFailures >= (int)tracks.size()) {
+    postStatus(playSession, "No playable files", true, false);
+    playing = false;
+    tracks.clear();
+    Serial.println("[AUDIO] ✗ No playable files in folder");
+    return;
+  }
+  
+  playTrack(trackIndex + 1);
 }
 
 // ============================================================================
@@ -239,8 +1059,29 @@ void audio_id3data(const char *info) {
   Serial.print("[AUDIO ID3] ");
   Serial.println(info);
   
-  // Parse ID3 data and update metadata
-  // TODO: Parse ID3 tags
+  // The pipeline reads tags (and covers) itself as it streams the file;
+  // without it, take the library's "Title: ..." lines
+  if (AudioPipeline.isReady()) {
+    return;
+  }
+  
+  static const struct {
+    const char* prefix;
+    Id3Field field;
+  } lines[] = {
+    {"Title: ", ID3_TITLE},
+    {"Artist: ", ID3_ARTIST},
+    {"Album: ", ID3_ALBUM},
+    {"Genre: ", ID3_GENRE}
+  };
+  
+  for (const auto& line : lines) {
+    size_t length = strlen(line.prefix);
+    if (strncmp(info, line.prefix, length) == 0) {
+      AudioPlayer.publishTag(line.field, info + length);
+      return;
+    }
+  }
 }
 
 void audio_eof_mp3(const char *info) {
@@ -251,23 +1092,14 @@ void audio_showstation(const char *info) {
   Serial.print("[AUDIO STATION] ");
   Serial.println(info);
   
-  AudioPlayer.getMetadata().title = String(info);
+  AudioPlayer.publishStation(info);
 }
 
 void audio_showstreamtitle(const char *info) {
   Serial.print("[AUDIO STREAM] ");
   Serial.println(info);
   
-  // Parse stream title (usually "Artist - Title")
-  String streamTitle = String(info);
-  int separatorPos = streamTitle.indexOf(" - ");
-  
-  if (separatorPos > 0) {
-    AudioPlayer.getMetadata().artist = streamTitle.substring(0, separatorPos);
-    AudioPlayer.getMetadata().title = streamTitle.substring(separatorPos + 3);
-  } else {
-    AudioPlayer.getMetadata().title = streamTitle;
-  }
+  AudioPlayer.publishStreamTitle(info);
 }
 
 void audio_bitrate(const char *info) {
@@ -276,7 +1108,7 @@ void audio_bitrate(const char *info) {
   Serial.println(info);
   #endif
   
-  AudioPlayer.getMetadata().bitrate = String(info).toInt();
+  AudioPlayer.publishBitrate(atoi(info));
 }
 
 void audio_commercial(const char *info) {
@@ -296,3 +1128,13 @@ void audio_lasthost(const char *info) {
   Serial.println(info);
   #endif
 }
+
+void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool* continueI2S) {
+  // Hand decoded PCM to the output stage instead of the library's I2S port
+  if (AudioPipeline.isReady()) {
+    AudioPipeline.writePcm(outBuff, validSamples, channels);
+    *continueI2S = false;
+  } else {
+    *continueI2S = true;
+  }
+}
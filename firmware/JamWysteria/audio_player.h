@@ -2,7 +2,25 @@
  * Audio Player for Jam Wysteria
  * 
  * Handles internet radio streaming using ESP32-audioI2S library
- * with I2S output to MAX98357A amplifier
+ * with I2S output to MAX98357A amplifier. Decoding runs on its own
+ * pinned FreeRTOS task; control calls are queued to it. The network
+ * fetch and I2S output stages live in AudioPipeline.
+ *
+ * Failed or dropped streams are retried on the audio task with
+ * jittered exponential backoff, rotating through the station's
+ * alternate URLs.
+ *
+ * Pausing a live stream through the pipeline time-shifts it: the
+ * stream keeps being recorded and resume continues from the pause
+ * point, until jumpToLive() or the next station.
+ *
+ * "sd:" URLs play files from the card; a folder plays its audio
+ * files in name order, with next/previous stepping through them.
+ *
+ * Each PLAY command carries a session number. What becomes of it
+ * (gave up, file ended) comes back through a SeqlockMailbox, and
+ * anything the audio task reports for an older session is dropped,
+ * so a station still retrying cannot fail the one just picked.
  */
 
 #ifndef AUDIO_PLAYER_H
@@ -10,25 +28,90 @@
 
 #include "Audio.h"
 #include "config.h"
+#include "audio_pipeline.h"
+#include "metadata_mailbox.h"
+#include "seqlock_mailbox.h"
+#include "audio_telemetry.h"
+
+// Commands sent from the UI to the audio task
+enum AudioCommandType {
+  AUDIO_CMD_PLAY,
+  AUDIO_CMD_ADD_URL,    // Alternate URL for the station just queued
+  AUDIO_CMD_WARM,       // Neighbouring station to keep connected
+  AUDIO_CMD_STOP,
+  AUDIO_CMD_PAUSE,
+  AUDIO_CMD_RESUME,
+  AUDIO_CMD_LIVE,       // Drop the time-shift backlog, reconnect to live
+  AUDIO_CMD_VOLUME
+};
+
+// Decoder state (audio task)
+enum DecodeState {
+  DECODE_IDLE,
+  DECODE_WAITING,       // Fetch stage connecting / prebuffering
+  DECODE_PIPELINE,      // Decoding from the stream ring
+  DECODE_DIRECT,        // Library fetches itself (playlists, unknown types)
+  DECODE_BACKOFF        // Waiting to retry after a failure
+};
+
+struct AudioCommand {
+  AudioCommandType type;
+  int value;                  // Volume, or the session of a PLAY
+  char url[STREAM_URL_MAX_LENGTH];
+};
+
+#define PLAYBACK_ERROR_MAX 64
+
+// Outcome of a play command (audio task and UI loop write, any task reads)
+struct PlaybackStatus {
+  uint32_t session;           // PLAY command it belongs to
+  bool failed;                // Gave up: shown to the user
+  bool trackEnded;            // A file finished; the UI moves on through the folder
+  bool trackFailed;           // ... because it would not play
+  char error[PLAYBACK_ERROR_MAX];
+};
+
+// Audio task timing (busy = time spent in audio.loop() per cycle)
+struct AudioTaskStats {
+  uint32_t cycles;
+  uint32_t lastBusyUs;
+  uint32_t avgBusyUs;
+  uint32_t maxBusyUs;
+  int32_t minSlackUs;         // Worst AUDIO_TASK_BUDGET_US - busy seen
+  uint32_t overruns;          // Cycles that went over budget
+  uint32_t commandsDropped;   // Queue full
+  uint32_t stackFree;         // Stack high-water mark in bytes
+};
 
 class AudioPlayerClass {
 public:
   AudioPlayerClass();
   
-  // Initialization
+  // Initialization (starts the audio task)
   void init();
   
-  // Playback control
-  bool playStation(const String& url);
+  // Playback control (queued; connection errors are reported via getError()
+  // once every URL has run out of retries)
+  bool playStation(const String& url, const std::vector<String>& mirrors = std::vector<String>());
+  bool playStation(const Station& station);
   void pause();
   void resume();
   void stop();
   bool isPlaying();
   bool isPaused();
   
-  // Track control (for playlist streams)
-  void next();
-  void previous();
+  // Time-shift (after pausing a live stream)
+  uint32_t getTimeBehindMs();         // 0 = live
+  void jumpToLive();
+  
+  // Recording (the live stream being played, to SD; ends with the station)
+  bool startRecording(bool splitTracks);
+  void stopRecording();
+  
+  // Station control (order of the current folder, or the tracks of an
+  // SD folder being played; returns the new station)
+  Station* next();
+  Station* previous();
   bool canSkip();
   
   // Volume control
@@ -40,43 +123,118 @@ public:
   void unmute();
   bool isMuted();
   
-  // Stream info
+  // Stream info (any task; reads never block)
   StreamMetadata getMetadata();
   String getTitle();
   String getArtist();
   String getAlbum();
   int getBitrate();
   bool hasMetadata();
+  uint32_t getMetadataVersion();  // Changes whenever the metadata does
+  
+  // Metadata updates (audio callbacks)
+  void publishStation(const char* name);
+  void publishStreamTitle(const char* streamTitle);
+  void publishStreamMetadata(const IcyMetadataParser& block);
+  void publishTag(Id3Field field, const char* text);
+  void publishAlbumArt(const char* path);
+  void publishBitrate(int bitrate);
   
-  // Update (call in loop)
+  // Update (call in loop; audio itself runs on the audio task)
   void update();
   
   // Connection status
   bool isConnected();
+  bool isReconnecting();
   String getError();
   
+  // Audio task instrumentation
+  AudioTaskStats getTaskStats();
+  void resetTaskStats();
+  
+  // Pipeline telemetry (throughput, decode time, underruns, buffer fill)
+  AudioTelemetry getTelemetry();
+  void resetTelemetry();
+  
 private:
   Audio audio;
   
-  // Playback state
-  bool playing;
-  bool paused;
+  // Audio task
+  TaskHandle_t taskHandle;
+  QueueHandle_t commandQueue;
+  AudioTaskStats taskStats;
+  AudioTelemetry telemetry;           // Decoder and connection parts (audio task)
+  uint64_t decodeTotalUs;
+  uint64_t playedUs;
+  
+  // Decoder (owned by the audio task)
+  DecodeState decodeState;
+  char streamURL[STREAM_URL_MAX_LENGTH];
+  unsigned long decodeWaitStart;
+  
+  // Reconnect (owned by the audio task)
+  char candidates[STREAM_MAX_MIRRORS + 1][STREAM_URL_MAX_LENGTH];
+  int candidateCount;
+  int candidateIndex;
+  int retryAttempt;
+  unsigned long retryAt;
+  unsigned long connectedAt;
+  bool decodePaused;
+  volatile bool reconnecting;
+  
+  // Playback state (as requested by the UI)
+  volatile bool playing;
+  volatile bool paused;
   bool muted;
   int currentVolume;
   int volumeBeforeMute;
   
   // Current stream info
   String currentURL;
-  StreamMetadata metadata;
-  bool metadataAvailable;
+  int currentStationId;       // -1 when playing a bare URL
+  int zapDirection;           // Last next/previous step, picks the warm neighbour
+  MetadataMailbox metadata;
+  
+  // SD folder playback (UI side; the audio task flags each track's end)
+  std::vector<String> tracks;         // "sd:" URLs in name order
+  int trackIndex;
+  int trackFailures;                  // Tracks in a row that would not play
+  
+  // Play sessions and their outcome
+  std::atomic<uint32_t> playSession;  // Last PLAY queued (UI)
+  uint32_t taskSession;               // PLAY being carried out (audio task)
+  uint32_t trackHandled;              // Session whose file end was acted on (UI)
+  SeqlockMailbox<PlaybackStatus> status;
+  unsigned long lastStatsLog;
   
-  // Error tracking
-  String lastError;
-  bool hasError;
+  // Audio task
+  static void taskEntry(void* param);
+  void taskLoop();
+  void handleCommand(const AudioCommand& command);
+  void startDecoder();
+  void stopDecoder();
+  void connectCandidate();
+  void decoderStarted();
+  void retryOrFail(const char* reason, bool transient = true);
+  void reportError(const char* message);
+  void finishTrack(const char* error);
+  void postStatus(uint32_t session, const char* error, bool failed, bool trackEnded);
+  bool readStatus(PlaybackStatus& out);
+  void recordCycle(uint32_t busyUs);
+  void recordDecode(uint32_t busyUs, uint32_t frames, uint32_t waitUs);
+  bool sendCommand(AudioCommandType type, int value = 0, const String& url = "");
+  bool queuePlay(const String& url);
   
   // Helper functions
-  void clearMetadata();
-  void updateMetadata();
+  void applyVolume(int volume);
+  int libraryVolume(int volume);
+  void rememberLoudness();
+  Station* step(int direction);
+  int findCurrentStation(const std::vector<Station*>& list);
+  void updateNeighbour();
+  bool loadTracks(const String& url);
+  bool playTrack(int index);
+  void trackFinished(bool failed);
 };
 
 // Global instance
@@ -92,5 +250,6 @@ void audio_bitrate(const char *info);
 void audio_commercial(const char *info);
 void audio_icyurl(const char *info);
 void audio_lasthost(const char *info);
+void audio_process_i2s(int16_t* outBuff, uint16_t validSamples, uint8_t bitsPerSample, uint8_t channels, bool* continueI2S);
 
 #endif // AUDIO_PLAYER_H
@@ -0,0 +1,58 @@
+/**
+ * Audio Pipeline Stage Steps for Jam Wysteria
+ *
+ * The data path of the fetch and output stages, one step at a time:
+ * an AudioSource into the stream ring, and the PCM ring through the
+ * resampler into frames for a PcmSink. AudioPipeline runs these in
+ * its FreeRTOS tasks against HttpStream and I2S; the host tests run
+ * them in threads against a file source and a PCM file sink.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef AUDIO_STAGES_H
+#define AUDIO_STAGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "audio_io.h"
+#include "spsc_ring.h"
+#include "polyphase_resampler.h"
+
+#define PCM_FRAME_BYTES         4         // 16-bit stereo
+
+// Fetch stage: one read of at most `room` bytes from the source into
+// the ring. Returns bytes moved, 0 if the source had nothing ready or
+// there is no room, -1 at the end of the stream. The bytes stay in
+// `chunk` for anyone teeing the stream.
+inline int fetchIntoRing(AudioSource& source, SpscRingBuffer& ring,
+                         uint8_t* chunk, size_t chunkSize, size_t room) {
+  size_t wanted = room < chunkSize ? room : chunkSize;
+  if (wanted > ring.space()) {
+    wanted = ring.space();
+  }
+  if (wanted == 0) {
+    return 0;
+  }
+  
+  int received = source.read(chunk, wanted);
+  if (received > 0) {
+    ring.write(chunk, received);
+  }
+  return received;
+}
+
+// Output stage: whole frames from the PCM ring through the resampler.
+// Returns frames produced at `frames`; 0 while the ring is empty or
+// the filter still lacks a window's worth of input.
+inline size_t resampleFromRing(SpscRingBuffer& ring, PolyphaseResampler& resampler,
+                               int16_t* frames, size_t maxFrames) {
+  size_t ready = ring.available() & ~(size_t)(PCM_FRAME_BYTES - 1);
+  size_t room = resampler.space() * PCM_FRAME_BYTES;
+  size_t bytes = ring.read((uint8_t*)resampler.inputBuffer(), ready < room ? ready : room);
+  resampler.commit(bytes / PCM_FRAME_BYTES);
+  
+  return resampler.process(frames, maxFrames);
+}
+
+#endif // AUDIO_STAGES_H
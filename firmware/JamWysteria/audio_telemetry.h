@@ -0,0 +1,102 @@
+/**
+ * Audio Telemetry for Jam Wysteria
+ *
+ * Counters and histograms for diagnosing stutters in the field:
+ * network throughput against the advertised bitrate, decode time per
+ * decoder cycle, underruns, buffer fill over time and reconnects.
+ * Each value is written by the one task that owns it (fetch, decoder
+ * or output); readers take a copy and may see it mid-update, which is
+ * fine for statistics.
+ *
+ * Histograms use power-of-two buckets: bucket 0 counts zeros, bucket
+ * n counts values in [2^(n-1), 2^n), and the last bucket everything
+ * from 2^(TELEMETRY_BUCKETS-2) up.
+ */
+
+#ifndef AUDIO_TELEMETRY_H
+#define AUDIO_TELEMETRY_H
+
+#include <cstdint>
+#include <cstring>
+#include "config.h"
+
+#define TELEMETRY_BUCKETS 17        // Up to 32768 (us or ms) and above
+
+struct TelemetryHistogram {
+  uint32_t buckets[TELEMETRY_BUCKETS];
+  uint32_t count;
+  uint32_t max;
+  uint64_t sum;
+  
+  void clear() {
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    max = 0;
+    sum = 0;
+  }
+  
+  void add(uint32_t value) {
+    int bucket = 0;
+    while (bucket < TELEMETRY_BUCKETS - 1 && value >= (1u << bucket)) {
+      bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    sum += value;
+    if (value > max) {
+      max = value;
+    }
+  }
+  
+  uint32_t mean() const {
+    return count > 0 ? (uint32_t)(sum / count) : 0;
+  }
+  
+  // Upper bound of the bucket holding the given percentile
+  uint32_t percentile(int pct) const {
+    if (count == 0) {
+      return 0;
+    }
+    uint64_t wanted = ((uint64_t)count * pct + 99) / 100;
+    uint64_t seen = 0;
+    for (int i = 0; i < TELEMETRY_BUCKETS - 1; i++) {
+      seen += buckets[i];
+      if (seen >= wanted) {
+        return i == 0 ? 0 : (1u << i) - 1;
+      }
+    }
+    return max;
+  }
+};
+
+struct AudioTelemetry {
+  uint32_t sinceMs;               // Time covered (since boot or the last reset)
+  
+  // Network (fetch task)
+  uint32_t bytesReceived;
+  uint32_t measuredKbps;          // Over the last TELEMETRY_RATE_WINDOW_S of streaming
+  uint32_t advertisedKbps;        // icy-br header (0 = not sent)
+  uint32_t decoderKbps;           // As the decoder reports it
+  
+  // Connections (audio task)
+  uint32_t connects;
+  uint32_t reconnects;            // Retries after a failure or a dropped stream
+  uint32_t failures;              // Every URL out of retries
+  
+  // Decoder (audio task). A cycle is one audio.loop() that produced
+  // PCM; it may decode one codec frame or several, so per-cycle time
+  // is comparable only within a codec and bitrate; decodeLoad is the
+  // figure that holds across them.
+  uint32_t decodeCycles;
+  uint32_t decodeLoad;            // Decode time per played time, permille
+  TelemetryHistogram decodeCycleUs;   // Per cycle, waits for the output excluded
+  
+  // Buffering (output task)
+  uint32_t i2sUnderruns;
+  uint32_t streamUnderruns;
+  TelemetryHistogram fillMs;      // Stream ring depth, one sample per TELEMETRY_SAMPLE_MS
+  uint16_t fillHistory[TELEMETRY_HISTORY];  // Latest samples, oldest first
+  int fillHistoryCount;
+};
+
+#endif // AUDIO_TELEMETRY_H
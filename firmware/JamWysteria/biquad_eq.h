@@ -0,0 +1,235 @@
+/**
+ * Biquad Equalizer for Jam Wysteria
+ *
+ * A short chain of second-order filters (RBJ cookbook shapes) run on
+ * interleaved 16-bit stereo in the output stage. Coefficients are
+ * designed in floating point when the settings or the sample rate
+ * change, then applied in Q28 fixed point (direct form I, 64-bit
+ * accumulator). Low shelves and the high-pass put poles close to
+ * z = 1, which would amplify the output rounding many times over;
+ * the rounding remainder is fed back into the next sample (first
+ * order noise shaping) to cancel that. Output is saturated to 16
+ * bits after each stage; limitGain() scales the input so a steady
+ * full-scale sine never gets there.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef BIQUAD_EQ_H
+#define BIQUAD_EQ_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define BIQUAD_MAX_STAGES   6
+#define BIQUAD_COEFF_SHIFT  28      // |coefficient| < 8
+
+enum BiquadType {
+  BIQUAD_HIGHPASS,
+  BIQUAD_LOW_SHELF,
+  BIQUAD_PEAKING,
+  BIQUAD_HIGH_SHELF
+};
+
+struct Biquad {
+  int32_t b0, b1, b2, a1, a2;
+  int32_t x1[2], x2[2];       // Per channel history
+  int32_t y1[2], y2[2];
+  int32_t error[2];           // Truncation remainder fed back
+};
+
+class BiquadChain {
+public:
+  BiquadChain() : count(0), shaping(true) {}
+  
+  void clear() {
+    count = 0;
+  }
+  
+  // Append a stage; `scale` multiplies its passband (for headroom)
+  bool add(BiquadType type, float frequency, float gainDb, float q,
+           float sampleRate, float scale = 1.0f) {
+    if (count >= BIQUAD_MAX_STAGES || sampleRate <= 0.0f ||
+        frequency <= 0.0f || frequency >= sampleRate / 2) {
+      return false;
+    }
+    
+    float A = powf(10.0f, gainDb / 40.0f);
+    float w0 = 2.0f * (float)M_PI * frequency / sampleRate;
+    float cosw = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    float shelf = 2.0f * sqrtf(A) * alpha;
+    float b0, b1, b2, a0, a1, a2;
+    
+    switch (type) {
+      case BIQUAD_HIGHPASS:
+        b0 = (1.0f + cosw) / 2.0f;
+        b1 = -(1.0f + cosw);
+        b2 = b0;
+        a0 = 1.0f + alpha;
+        a1 = -2.0f * cosw;
+        a2 = 1.0f - alpha;
+        break;
+        
+      case BIQUAD_LOW_SHELF:
+        b0 = A * ((A + 1.0f) - (A - 1.0f) * cosw + shelf);
+        b1 = 2.0f * A * ((A - 1.0f) - (A + 1.0f) * cosw);
+        b2 = A * ((A + 1.0f) - (A - 1.0f) * cosw - shelf);
+        a0 = (A + 1.0f) + (A - 1.0f) * cosw + shelf;
+        a1 = -2.0f * ((A - 1.0f) + (A + 1.0f) * cosw);
+        a2 = (A + 1.0f) + (A - 1.0f) * cosw - shelf;
+        break;
+        
+      case BIQUAD_PEAKING:
+        b0 = 1.0f + alpha * A;
+        b1 = -2.0f * cosw;
+        b2 = 1.0f - alpha * A;
+        a0 = 1.0f + alpha / A;
+        a1 = -2.0f * cosw;
+        a2 = 1.0f - alpha / A;
+        break;
+        
+      case BIQUAD_HIGH_SHELF:
+      default:
+        b0 = A * ((A + 1.0f) + (A - 1.0f) * cosw + shelf);
+        b1 = -2.0f * A * ((A - 1.0f) + (A + 1.0f) * cosw);
+        b2 = A * ((A + 1.0f) + (A - 1.0f) * cosw - shelf);
+        a0 = (A + 1.0f) - (A - 1.0f) * cosw + shelf;
+        a1 = 2.0f * ((A - 1.0f) - (A + 1.0f) * cosw);
+        a2 = (A + 1.0f) - (A - 1.0f) * cosw - shelf;
+        break;
+    }
+    
+    Biquad& stage = stages[count++];
+    memset(&stage, 0, sizeof(stage));
+    stage.b0 = toFixed(b0 * scale / a0);
+    stage.b1 = toFixed(b1 * scale / a0);
+    stage.b2 = toFixed(b2 * scale / a0);
+    stage.a1 = toFixed(a1 / a0);
+    stage.a2 = toFixed(a2 / a0);
+    return true;
+  }
+  
+  // Drop filter history (after a flush or a stream change)
+  void reset() {
+    for (int i = 0; i < count; i++) {
+      memset(stages[i].x1, 0, sizeof(stages[i].x1));
+      memset(stages[i].x2, 0, sizeof(stages[i].x2));
+      memset(stages[i].y1, 0, sizeof(stages[i].y1));
+      memset(stages[i].y2, 0, sizeof(stages[i].y2));
+      memset(stages[i].error, 0, sizeof(stages[i].error));
+    }
+  }
+  
+  int getCount() const { return count; }
+  const Biquad& getStage(int index) const { return stages[index]; }
+  
+  // Error feedback is on unless switched off (to measure what it costs)
+  void setNoiseShaping(bool enabled) { shaping = enabled; }
+  
+  // Largest gain a sine meets after any stage, from the fixed point
+  // coefficients on a 1/12 octave grid from 20 Hz up
+  float peakGain(float sampleRate) const {
+    float peak = 0.0f;
+    for (float frequency = 20.0f; frequency < sampleRate / 2; frequency *= 1.06f) {
+      float phi = sinf((float)M_PI * frequency / sampleRate);
+      phi *= phi;
+      float gain = 1.0f;
+      for (int s = 0; s < count; s++) {
+        gain *= magnitude(stages[s], phi);
+        peak = gain > peak ? gain : peak;
+      }
+    }
+    return peak;
+  }
+  
+  // Scale the first stage so no stage sees more than unity gain; the
+  // boosts of neighbouring bands add up where they overlap, and
+  // shelves overshoot a little past their corner
+  void limitGain(float sampleRate) {
+    float peak = peakGain(sampleRate);
+    if (count == 0 || peak <= 1.0f) {
+      return;
+    }
+    
+    float scale = 1.0f / peak;
+    stages[0].b0 = (int32_t)lrint(stages[0].b0 * (double)scale);
+    stages[0].b1 = (int32_t)lrint(stages[0].b1 * (double)scale);
+    stages[0].b2 = (int32_t)lrint(stages[0].b2 * (double)scale);
+  }
+  
+  // Interleaved stereo, in place
+  void process(int16_t* samples, size_t frames) {
+    for (int s = 0; s < count; s++) {
+      Biquad& stage = stages[s];
+      for (int ch = 0; ch < 2; ch++) {
+        if (shaping) {
+          run<true>(stage, ch, samples + ch, frames);
+        } else {
+          run<false>(stage, ch, samples + ch, frames);
+        }
+      }
+    }
+  }
+  
+private:
+  Biquad stages[BIQUAD_MAX_STAGES];
+  int count;
+  bool shaping;
+  
+  static int32_t toFixed(float value) {
+    return (int32_t)lrintf(value * (float)(1 << BIQUAD_COEFF_SHIFT));
+  }
+  
+  // |H| at phi = sin²(w/2) (cookbook form). The coefficient sums are
+  // taken in integers, as they nearly cancel for corners near DC.
+  static float magnitude(const Biquad& stage, float phi) {
+    const float unit = (float)(1 << BIQUAD_COEFF_SHIFT);
+    float b0 = stage.b0 / unit, b1 = stage.b1 / unit, b2 = stage.b2 / unit;
+    float a1 = stage.a1 / unit, a2 = stage.a2 / unit;
+    float bSum = ((int64_t)stage.b0 + stage.b1 + stage.b2) / unit;
+    float aSum = ((int64_t)(1 << BIQUAD_COEFF_SHIFT) + stage.a1 + stage.a2) / unit;
+    
+    float numerator = bSum * bSum - 4.0f * (b0 * b1 + 4.0f * b0 * b2 + b1 * b2) * phi +
+                      16.0f * b0 * b2 * phi * phi;
+    float denominator = aSum * aSum - 4.0f * (a1 + 4.0f * a2 + a1 * a2) * phi +
+                        16.0f * a2 * phi * phi;
+    return denominator > 0.0f && numerator > 0.0f ? sqrtf(numerator / denominator) : 0.0f;
+  }
+  
+  // One channel of one stage; history lives in registers for the block
+  template <bool Shaped>
+  static void run(Biquad& stage, int ch, int16_t* samples, size_t frames) {
+    const int64_t b0 = stage.b0, b1 = stage.b1, b2 = stage.b2;
+    const int64_t a1 = stage.a1, a2 = stage.a2;
+    int32_t x1 = stage.x1[ch], x2 = stage.x2[ch];
+    int32_t y1 = stage.y1[ch], y2 = stage.y2[ch];
+    int32_t error = stage.error[ch];
+    
+    for (size_t i = 0; i < frames; i++) {
+      int32_t x0 = samples[i * 2];
+      int64_t acc = b0 * x0 + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2 + error;
+      int32_t y0 = (int32_t)(acc >> BIQUAD_COEFF_SHIFT);
+      if (Shaped) {
+        error = (int32_t)(acc - ((int64_t)y0 << BIQUAD_COEFF_SHIFT));
+      }
+      
+      x2 = x1;
+      x1 = x0;
+      y2 = y1;
+      y1 = y0;
+      
+      samples[i * 2] = (int16_t)(y0 > 32767 ? 32767 : (y0 < -32768 ? -32768 : y0));
+    }
+    
+    stage.x1[ch] = x1;
+    stage.x2[ch] = x2;
+    stage.y1[ch] = y1;
+    stage.y2[ch] = y2;
+    stage.error[ch] = error;
+  }
+};
+
+#endif // BIQUAD_EQ_H
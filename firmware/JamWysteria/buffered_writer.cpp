@@ -0,0 +1,207 @@
+/**
+ * Buffered File Writer Implementation
+ */
+
+#include "buffered_writer.h"
+#include "sd_manager.h"
+#include <esp32/rom/crc.h>
+
+BufferedFileWriter::BufferedFileWriter() :
+  filePath(""),
+  buffer(nullptr),
+  bufferSize(0),
+  bufferUsed(0),
+  totalBytes(0),
+  maxBytes(0),
+  crc(0),
+  error(false),
+  overLimit(false) {
+}
+
+BufferedFileWriter::~BufferedFileWriter() {
+  if (isOpen()) {
+    close();
+  }
+  releaseBuffer();
+}
+
+bool BufferedFileWriter::open(const String& path, size_t size, size_t maxSize) {
+  if (isOpen()) {
+    close();
+  }
+  
+  // Round the buffer down to whole SD blocks
+  size = (size / SD_BLOCK_SIZE) * SD_BLOCK_SIZE;
+  if (size == 0) {
+    size = SD_BLOCK_SIZE;
+  }
+  
+  if (buffer == nullptr || bufferSize != size) {
+    releaseBuffer();
+    buffer = (uint8_t*)malloc(size);
+    if (buffer == nullptr) {
+      Serial.printf("[SD] ✗ No memory for %u byte write buffer\n", size);
+      return false;
+    }
+    bufferSize = size;
+  }
+  
+  file = SD.open(path.c_str(), FILE_WRITE);
+  if (!file) {
+    Serial.printf("[SD] Failed to create file: %s\n", path.c_str());
+    return false;
+  }
+  
+  SDManager.notifyPathChanged(path, true);
+  
+  filePath = path;
+  bufferUsed = 0;
+  totalBytes = 0;
+  maxBytes = maxSize;
+  crc = 0;
+  error = false;
+  overLimit = false;
+  
+  return true;
+}
+
+bool BufferedFileWriter::close() {
+  if (!isOpen()) {
+    return false;
+  }
+  
+  bool success = flush();
+  file.close();
+  
+  return success && !error;
+}
+
+void BufferedFileWriter::abort() {
+  if (isOpen()) {
+    file.close();
+  }
+  
+  bufferUsed = 0;
+  
+  if (filePath.length() > 0) {
+    SD.remove(filePath.c_str());
+    SDManager.notifyPathChanged(filePath, false);
+    Serial.printf("[SD] Removed partial file: %s\n", filePath.c_str());
+  }
+}
+
+bool BufferedFileWriter::isOpen() {
+  return (bool)file;
+}
+
+size_t BufferedFileWriter::write(const uint8_t* data, size_t length) {
+  if (!isOpen() || error || overLimit) {
+    return 0;
+  }
+  
+  if (maxBytes > 0 && totalBytes + length > maxBytes) {
+    overLimit = true;
+    return 0;
+  }
+  
+  crc = crc32_le(crc, data, length);
+  totalBytes += length;
+  
+  size_t remaining = length;
+  
+  // Top up a partially filled buffer first
+  if (bufferUsed > 0) {
+    size_t chunk = min(remaining, bufferSize - bufferUsed);
+    memcpy(buffer + bufferUsed, data, chunk);
+    bufferUsed += chunk;
+    data += chunk;
+    remaining -= chunk;
+    
+    if (bufferUsed == bufferSize) {
+      if (!writeBlocks(buffer, bufferSize)) {
+        return 0;
+      }
+      bufferUsed = 0;
+    }
+  }
+  
+  // Whole buffers go straight from the caller's memory
+  if (remaining >= bufferSize) {
+    size_t direct = (remaining / bufferSize) * bufferSize;
+    if (!writeBlocks(data, direct)) {
+      return 0;
+    }
+    data += direct;
+    remaining -= direct;
+  }
+  
+  // Keep the tail for the next call
+  if (remaining > 0) {
+    memcpy(buffer + bufferUsed, data, remaining);
+    bufferUsed += remaining;
+  }
+  
+  return length;
+}
+
+bool BufferedFileWriter::flush() {
+  if (!isOpen() || error) {
+    return false;
+  }
+  
+  if (bufferUsed > 0) {
+    if (!writeBlocks(buffer, bufferUsed)) {
+      return false;
+    }
+    bufferUsed = 0;
+  }
+  
+  file.flush();
+  return true;
+}
+
+bool BufferedFileWriter::hasError() {
+  return error;
+}
+
+bool BufferedFileWriter::limitExceeded() {
+  return overLimit;
+}
+
+size_t BufferedFileWriter::getSize() {
+  return totalBytes;
+}
+
+uint32_t BufferedFileWriter::getCRC32() {
+  return crc;
+}
+
+String BufferedFileWriter::getPath() {
+  return filePath;
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+bool BufferedFileWriter::writeBlocks(const uint8_t* data, size_t length) {
+  size_t written = file.write(data, length);
+  
+  if (written != length) {
+    Serial.printf("[SD] ✗ Write failed: %s (%u/%u bytes)\n",
+                  filePath.c_str(), written, length);
+    error = true;
+    return false;
+  }
+  
+  return true;
+}
+
+void BufferedFileWriter::releaseBuffer() {
+  if (buffer != nullptr) {
+    free(buffer);
+    buffer = nullptr;
+  }
+  bufferSize = 0;
+  bufferUsed = 0;
+}
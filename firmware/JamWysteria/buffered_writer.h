@@ -0,0 +1,59 @@
+/**
+ * Buffered File Writer for Jam Wysteria
+ *
+ * Collects small writes into a block-aligned RAM buffer and
+ * flushes whole SD blocks, keeping a running CRC32 and
+ * enforcing an optional size limit
+ */
+
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <SD.h>
+#include <FS.h>
+#include "config.h"
+
+class BufferedFileWriter {
+public:
+  BufferedFileWriter();
+  ~BufferedFileWriter();
+  
+  // Open/close
+  bool open(const String& path, size_t bufferSize = UPLOAD_BUFFER_SIZE, size_t maxSize = 0);
+  bool close();
+  void abort();
+  bool isOpen();
+  
+  // Writing (returns bytes accepted)
+  size_t write(const uint8_t* data, size_t length);
+  bool flush();
+  
+  // Status
+  bool hasError();
+  bool limitExceeded();
+  size_t getSize();
+  uint32_t getCRC32();
+  String getPath();
+  
+private:
+  File file;
+  String filePath;
+  
+  // Block buffer
+  uint8_t* buffer;
+  size_t bufferSize;
+  size_t bufferUsed;
+  
+  // Accounting
+  size_t totalBytes;
+  size_t maxBytes;
+  uint32_t crc;
+  bool error;
+  bool overLimit;
+  
+  // Helper functions
+  bool writeBlocks(const uint8_t* data, size_t length);
+  void releaseBuffer();
+};
+
+#endif // BUFFERED_WRITER_H
@@ -0,0 +1,134 @@
+/**
+ * Codec Sniffer for Jam Wysteria
+ *
+ * Tells the codec of a stream from its first bytes, for servers whose
+ * Content-Type is missing or wrong. Containers are recognized by
+ * their signature at the start (Ogg, FLAC, MP4 "ftyp", after any
+ * ID3v2 tag); raw MP3 and ADTS AAC by a frame header whose length
+ * leads to a second, matching header, so a stream joined mid-frame
+ * or a stray 0xFF byte does not fool it.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef CODEC_SNIFFER_H
+#define CODEC_SNIFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Frame header fields that must agree between consecutive frames
+struct SniffedFrame {
+  size_t length;              // Bytes to the next header
+  uint8_t signature;          // Version/layer or profile bits
+  uint8_t rateIndex;
+};
+
+// MPEG audio (layers I-III, versions 1, 2 and 2.5)
+inline bool sniffMpegFrame(const uint8_t* h, SniffedFrame& frame) {
+  static const uint16_t bitrates[2][3][15] = {
+    {{0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},   // V1 L1
+     {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},      // V1 L2
+     {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320}},      // V1 L3
+    {{0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},      // V2 L1
+     {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},           // V2 L2
+     {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160}}           // V2 L3
+  };
+  static const uint32_t rates[3] = {44100, 48000, 32000};
+  
+  if (h[0] != 0xFF || (h[1] & 0xE0) != 0xE0) {
+    return false;
+  }
+  int version = (h[1] >> 3) & 3;      // 0 = 2.5, 1 = reserved, 2 = 2, 3 = 1
+  int layer = 4 - ((h[1] >> 1) & 3);  // 4 = reserved (ADTS)
+  int bitrateIndex = h[2] >> 4;
+  int rateIndex = (h[2] >> 2) & 3;
+  if (version == 1 || layer == 4 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) {
+    return false;
+  }
+  
+  uint32_t bitrate = bitrates[version == 3 ? 0 : 1][layer - 1][bitrateIndex] * 1000;
+  uint32_t rate = rates[rateIndex] >> (version == 3 ? 0 : version == 2 ? 1 : 2);
+  uint32_t padding = (h[2] >> 1) & 1;
+  
+  if (layer == 1) {
+    frame.length = (12 * bitrate / rate + padding) * 4;
+  } else {
+    frame.length = (layer == 3 && version != 3 ? 72 : 144) * bitrate / rate + padding;
+  }
+  frame.signature = h[1] & 0x1E;
+  frame.rateIndex = (uint8_t)rateIndex;
+  return frame.length >= 4;
+}
+
+// AAC in ADTS frames
+inline bool sniffAdtsFrame(const uint8_t* h, SniffedFrame& frame) {
+  if (h[0] != 0xFF || (h[1] & 0xF6) != 0xF0) {
+    return false;
+  }
+  int rateIndex = (h[2] >> 2) & 0x0F;
+  if (rateIndex > 12) {
+    return false;
+  }
+  
+  frame.length = ((size_t)(h[3] & 0x03) << 11) | ((size_t)h[4] << 3) | (h[5] >> 5);
+  frame.signature = h[2] >> 6;        // Profile
+  frame.rateIndex = (uint8_t)rateIndex;
+  return frame.length >= 7;
+}
+
+// File extension the decoder knows the codec by ("mp3", "aac", "flac",
+// "ogg", "m4a"), or nullptr if the bytes do not tell yet (feed more)
+inline const char* sniffCodec(const uint8_t* data, size_t length) {
+  size_t start = 0;
+  
+  // A stream may open with an ID3v2 tag (header and syncsafe size)
+  if (length >= 10 && memcmp(data, "ID3", 3) == 0) {
+    start = 10 + (((size_t)(data[6] & 0x7F) << 21) | ((size_t)(data[7] & 0x7F) << 14) |
+                  ((size_t)(data[8] & 0x7F) << 7) | (data[9] & 0x7F));
+    if (data[5] & 0x10) {
+      start += 10;                    // Footer
+    }
+  }
+  if (start + 8 > length) {
+    return nullptr;
+  }
+  
+  const uint8_t* head = data + start;
+  if (memcmp(head, "OggS", 4) == 0) {
+    return "ogg";
+  }
+  if (memcmp(head, "fLaC", 4) == 0) {
+    return "flac";
+  }
+  if (memcmp(head + 4, "ftyp", 4) == 0) {
+    return "m4a";
+  }
+  
+  // Raw frames: a header, and another where its length says
+  for (size_t i = start; i + 6 <= length; i++) {
+    if (data[i] != 0xFF) {
+      continue;
+    }
+    
+    SniffedFrame frame, next;
+    bool adts = sniffAdtsFrame(data + i, frame);
+    if (!adts && !sniffMpegFrame(data + i, frame)) {
+      continue;
+    }
+    if (i + frame.length + 6 > length) {
+      continue;                       // Next header not in yet; a later one may confirm
+    }
+    
+    const uint8_t* second = data + i + frame.length;
+    bool matched = adts ? sniffAdtsFrame(second, next) : sniffMpegFrame(second, next);
+    if (matched && next.signature == frame.signature && next.rateIndex == frame.rateIndex) {
+      return adts ? "aac" : "mp3";
+    }
+  }
+  
+  return nullptr;
+}
+
+#endif // CODEC_SNIFFER_H
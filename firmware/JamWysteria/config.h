@@ -8,6 +8,8 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <vector>
+
 // ============================================================================
 // DEBUG SETTINGS
 // ============================================================================
@@ -83,21 +85,175 @@
 // ============================================================================
 // AUDIO SETTINGS
 // ============================================================================
-#define AUDIO_BUFFER_SIZE   8192    // Audio buffer size in bytes
+#define AUDIO_BUFFER_SIZE   16384   // Decoder input window in bytes (fits a FLAC frame)
 #define AUDIO_SAMPLE_RATE   44100   // Sample rate in Hz
 #define AUDIO_BITS_PER_SAMPLE 16    // Bits per sample
 #define AUDIO_CHANNELS      1       // 1=Mono, 2=Stereo
 
 // Volume settings
 #define VOLUME_MIN          0
-#define VOLUME_MAX          21      // 0-21 for ESP32-audioI2S library
-#define VOLUME_DEFAULT      12      // Default volume level
-#define VOLUME_STEP         1       // Volume adjustment step
+#define VOLUME_MAX          48      // Software gain steps, 0 = silence
+#define VOLUME_DEFAULT      32      // Default volume level
+#define VOLUME_STEP         2       // Volume adjustment step
+#define VOLUME_DB_PER_STEP  1.0f    // Log scale: VOLUME_MAX is 0 dB, each step below -1 dB
+#define VOLUME_RAMP_MS      30      // Gain changes and mute fade over this window
+#define VOLUME_LIBRARY_MAX  21      // ESP32-audioI2S scale (direct decoder output only)
+
+// Tone control (biquad chain in the output stage)
+#define EQ_GAIN_MIN_DB      -12
+#define EQ_GAIN_MAX_DB      12
+#define EQ_GAIN_STEP_DB     2
+#define EQ_BASS_HZ          150     // Low shelf
+#define EQ_MID_HZ           1000    // Peaking band
+#define EQ_MID_Q            0.9f
+#define EQ_TREBLE_HZ        5000    // High shelf
+#define EQ_SHELF_Q          0.707f
+#define EQ_HIGHPASS_HZ      60      // Below what the speaker can move (0 = off)
+#define EQ_CPU_BUDGET_PCT   10      // Share of each output block the chain may take
+
+// Loudness normalization (K-weighted meter and slow gain in the output stage)
+#define LOUDNESS_TARGET_LUFS        -20.0f
+#define LOUDNESS_MAX_BOOST_DB       6.0f    // Only usable below full volume (gain never exceeds unity)
+#define LOUDNESS_MAX_CUT_DB         -18.0f
+#define LOUDNESS_BLOCK_MS           100     // Meter block
+#define LOUDNESS_WINDOW_BLOCKS      30      // Short-term window (3 s)
+#define LOUDNESS_GATE_LUFS          -50.0f  // Quieter blocks (gaps, silence) do not move the gain
+#define LOUDNESS_SLEW_DB_PER_S      0.5f    // Steady state: slow enough to keep dynamics
+#define LOUDNESS_FAST_SLEW_DB_PER_S 3.0f    // Unknown station, until settled
+#define LOUDNESS_SETTLE_S           15      // Measured audio before a learned gain is trusted
+#define LOUDNESS_MEMORY_ENTRIES     64      // Stations whose gain is remembered
+#define LOUDNESS_SAVE_DELTA_DB      0.5f    // Smaller changes are not written back
+#define LOUDNESS_SAVE_DELAY         5000    // ms a learned gain waits before hitting SD
+
+// Sample-rate conversion and clock drift (polyphase resampler in the output stage)
+#define RESAMPLE_FIXED_OUTPUT   true    // I2S stays at AUDIO_SAMPLE_RATE (false = follow the stream)
+#define DRIFT_MAX_PPM           500     // Largest ratio nudge (under a cent of pitch)
+#define DRIFT_PPM_PER_MS        0.2f    // Nudge per ms the buffer sits off its set point
+#define DRIFT_SETTLE_MS         20000   // Streaming time before the set point is taken
+#define DRIFT_UPDATE_MS         1000
+
+// Audio telemetry (/api/audio/stats)
+#define TELEMETRY_SAMPLE_MS         1000    // Buffer fill and throughput sampling
+#define TELEMETRY_HISTORY           60      // Fill samples kept (a minute)
+#define TELEMETRY_RATE_WINDOW_S     30      // Throughput averaged over this much streaming
 
 // Stream connection settings
 #define STREAM_CONNECT_TIMEOUT  10000   // Connection timeout in ms
 #define STREAM_RECONNECT_DELAY  5000    // Delay before reconnect attempt in ms
-#define STREAM_MAX_RECONNECTS   3       // Max reconnection attempts
+#define STREAM_MAX_RECONNECTS   6       // Retries per station URL before giving up
+#define STREAM_BACKOFF_BASE_MS  500     // First retry delay (doubles each round)
+#define STREAM_BACKOFF_MAX_MS   30000   // Retry delay ceiling
+#define STREAM_STABLE_MS        30000   // Playback time that resets the backoff
+#define STREAM_MAX_MIRRORS      4       // Alternate URLs tried per station
+#define STREAM_URL_MAX_LENGTH   256     // Longest URL passed to the audio task
+
+// Audio task (decoding and I2S feeding run off the UI loop)
+#define AUDIO_TASK_CORE         0       // Arduino loop() runs on core 1
+#define AUDIO_TASK_PRIORITY     5       // Above loop() (1), below WiFi (23)
+#define AUDIO_TASK_STACK        8192    // Stack size in bytes
+#define AUDIO_TASK_BUDGET_US    5000    // Per-cycle time budget used for slack accounting
+#define AUDIO_COMMAND_QUEUE_LEN 8       // Pending control commands
+
+// Audio pipeline (fetch -> decode -> output, joined by SPSC rings)
+#define AUDIO_STREAM_RING_SIZE      (256 * 1024) // Compressed bytes between fetch and decode (PSRAM)
+#define AUDIO_STREAM_RING_FALLBACK  (32 * 1024) // Stream ring size when PSRAM is unavailable
+#define AUDIO_PCM_RING_SIZE         (16 * 1024) // PCM bytes between decode and I2S (~90 ms)
+#define AUDIO_FETCH_CHUNK           1024        // Bytes moved per network read
+#define AUDIO_DECODE_READ_WAIT_MS   20          // Decoder wait when the stream ring is empty
+#define AUDIO_FETCH_TASK_CORE       1
+#define AUDIO_FETCH_TASK_PRIORITY   3
+#define AUDIO_FETCH_TASK_STACK      8192        // Room for TLS handshakes
+#define AUDIO_OUTPUT_TASK_CORE      1
+#define AUDIO_OUTPUT_TASK_PRIORITY  6           // Mostly blocked in i2s_write()
+#define AUDIO_OUTPUT_TASK_STACK     4096
+#define AUDIO_OUTPUT_DMA_BUFFERS    8
+#define AUDIO_OUTPUT_DMA_LENGTH     256         // Frames per DMA buffer
+#define STREAM_MAX_REDIRECTS        5
+#define CODEC_SNIFF_BYTES           3072        // Stream start read to tell the codec (covers two 320 kbps MP3 frames)
+#define CODEC_SNIFF_TIMEOUT_MS      2000        // Give up sniffing a trickling stream after this
+
+// Local playback ("sd:/path/file.mp3" and "sd:/folder/" station URLs)
+#define LOCAL_URL_PREFIX            "sd:"
+#define LOCAL_READ_AHEAD            (128 * 1024) // File audio read ahead of the decoder (PSRAM ring)
+#define LOCAL_READ_CHUNK            4096        // Bytes per SD read (whole sectors)
+#define LOCAL_MAX_TRACKS            256         // Files played from one folder
+#define LOCAL_FILE_TYPES            ".mp3,.aac,.flac,.ogg,.opus,.wav"
+#define ART_DIR                     "/art"      // Cover pictures from ID3 tags, named by CRC32
+#define ART_TEMP_FILE               "/art/incoming.tmp"
+#define ART_MAX_SIZE                (1024 * 1024) // Larger pictures are skipped
+#define ART_WRITE_BUFFER            4096        // Bytes per SD write (whole blocks)
+
+// Time-shift (a paused live stream keeps arriving and is played from the pause point)
+#define TIMESHIFT_RAM_SIZE          (1024 * 1024) // PSRAM backlog (~1 min at 128 kbps)
+#define TIMESHIFT_SPILL_MAX         (64 * 1024 * 1024) // SD spill-over ceiling (~70 min at 128 kbps)
+#define TIMESHIFT_SPILL_BLOCK       4096        // Bytes per spill file write/read (whole sectors)
+
+// Stream recording (compressed stream teed to SD, /api/record)
+#define RECORD_DIR                  "/recordings"
+#define RECORD_RING_SIZE            (256 * 1024) // Write-behind buffer (PSRAM, ~16 s at 128 kbps)
+#define RECORD_WRITE_BUFFER         (16 * 1024) // Bytes per SD write (whole blocks)
+#define RECORD_TITLE_MAX            128         // ICY title kept for a split
+#define RECORD_NAME_MAX             48          // Title characters used in a file name
+#define RECORD_SPLIT_QUEUE_LEN      4           // Title changes waiting for the writer
+#define RECORD_POLL_MS              20
+#define RECORD_TASK_CORE            0
+#define RECORD_TASK_PRIORITY        1           // Below the audio and fetch tasks
+#define RECORD_TASK_STACK           4096
+
+// Station prober (background reachability and now-playing checks for the folder view)
+#define PROBE_WORKERS               2           // Stations checked at once
+#define PROBE_QUEUE_LEN             16          // Stations waiting for a worker
+#define PROBE_RESULT_ENTRIES        64          // Least recently used dropped beyond this
+#define PROBE_TTL_S                 300         // A result is checked again after this
+#define PROBE_DEAD_TTL_S            60          // ... or this, for a station that failed
+#define PROBE_CONNECT_TIMEOUT       5000        // ms; half a tune-in's patience
+#define PROBE_TITLE_TIMEOUT         5000        // ms waiting for the first ICY title
+#define PROBE_MAX_BYTES             (24 * 1024) // Stream bytes read for a title at most
+#define PROBE_WORKER_BPS            (8 * 1024)  // Read rate per worker (bytes/s)
+#define PROBE_TITLE_MAX             64
+#define PROBE_MIN_FREE_HEAP         (64 * 1024) // Internal heap needed to start a check
+#define PROBE_IDLE_MS               1000        // Recheck of WiFi and heap while waiting
+#define PROBE_TASK_CORE             0
+#define PROBE_TASK_PRIORITY         1           // Below the audio and fetch tasks
+#define PROBE_TASK_STACK            8192        // Room for TLS handshakes
+
+// Playlist resolution (.m3u / .pls / .xspf)
+#define PLAYLIST_MAX_SIZE           8192        // Largest playlist body read
+#define PLAYLIST_MAX_DEPTH          3           // Playlists pointing at playlists
+#define PLAYLIST_CACHE_ENTRIES      32
+#define PLAYLIST_CACHE_TTL_S        86400       // Re-resolve once a day
+#define PLAYLIST_CACHE_SAVE_DELAY   5000        // ms a change waits before hitting SD
+
+// Warm neighbour (next/previous station kept connected)
+#define WARM_BUFFER_SIZE            (32 * 1024) // Latest neighbour audio kept (PSRAM)
+#define WARM_MAX_BITRATE            192         // kbps; richer neighbours are not kept warm
+#define WARM_MIN_FREE_HEAP          (64 * 1024) // Internal heap needed to open one (TLS is costly)
+#define WARM_START_DELAY_MS         5000        // Main stream settle time before warming
+#define WARM_RETRY_MS               15000       // Wait after a failed or dropped warm connection
+#define WARM_POLL_MS                10
+#define WARM_TASK_CORE              1
+#define WARM_TASK_PRIORITY          2           // Below the fetch task
+#define WARM_TASK_STACK             8192        // Room for TLS handshakes
+
+// Connection cache (stream host addresses and stream parameters)
+#define DNS_CACHE_ENTRIES           16
+#define DNS_TTL_MIN_S               60          // Floor for short-lived answers
+#define DNS_TTL_MAX_S               3600        // Ceiling for long-lived answers
+#define DNS_QUERY_TIMEOUT_MS        2000
+#define DNS_LOCAL_PORT              10053       // First local port tried for queries
+#define STREAM_PARAMS_ENTRIES       16
+
+// Jitter buffer (stream ring depth adapts to network jitter and underruns)
+#define BUFFER_PROFILE_FAST         0           // Quick tune-in, shallow buffer
+#define BUFFER_PROFILE_BALANCED     1
+#define BUFFER_PROFILE_ROBUST       2           // Deep buffer for flaky networks
+#define BUFFER_PROFILE_COUNT        3
+#define BUFFER_PROFILE_DEFAULT      BUFFER_PROFILE_BALANCED
+#define JITTER_DEFAULT_BYTE_RATE    16000       // 128 kbps until the bitrate is known
+#define JITTER_WINDOW_MS            2000        // Arrival gap measurement window
+#define JITTER_HEADROOM             2           // Target depth as a multiple of jitter
+#define JITTER_UNDERRUN_STEP_MS     1000        // Target growth per underrun
+#define JITTER_DECAY_MS             30000       // Underrun-free time before the target shrinks
 
 // ============================================================================
 // WIFI SETTINGS
@@ -105,6 +261,7 @@
 #define WIFI_CONNECT_TIMEOUT    20000   // WiFi connection timeout in ms
 #define WIFI_SCAN_MAX_NETWORKS  20      // Maximum networks to display
 #define WIFI_RECONNECT_DELAY    5000    // Delay before reconnect in ms
+#define WIFI_MAX_RECONNECTS     3       // Max reconnection attempts
 
 // ============================================================================
 // WEB SERVER SETTINGS
@@ -113,15 +270,30 @@
 #define WEB_SOCKET_PORT     81          // WebSocket port for real-time updates
 #define API_ENDPOINT        "/api"      // API base path
 
+// File uploads
+#define UPLOAD_BUFFER_SIZE  8192        // Per-upload write buffer (whole SD blocks, 4-32KB)
+#define UPLOAD_MAX_SIZE     (512 * 1024) // Maximum accepted upload size in bytes
+
 // ============================================================================
 // SD CARD SETTINGS
 // ============================================================================
 #define SD_MAX_PATH_LENGTH  256
+#define SD_BLOCK_SIZE       512         // SD card block (sector) size in bytes
+#define SD_PATH_CACHE_SIZE  32          // Recently seen paths kept for exists()
 #define SD_CONFIG_FILE      "/config/config.json"
 #define SD_STATIONS_FILE    "/config/stations.json"
+#define SD_PLAYLIST_CACHE_FILE "/config/playlists.json"
+#define SD_LOUDNESS_FILE    "/config/loudness.json"
+#define SD_TIMESHIFT_FILE   "/timeshift.bin"
 #define SD_LOGOS_DIR        "/logos"
 #define SD_ICONS_DIR        "/icons"
 
+// Block cache (PSRAM)
+#define SD_BLOCK_CACHE_SIZE         (256 * 1024) // PSRAM budget in bytes (0 = disabled)
+#define SD_BLOCK_CACHE_LINE_SECTORS 8           // Sectors per cache line (max 8)
+#define SD_BLOCK_CACHE_READAHEAD    4           // Lines prefetched on sequential reads
+#define SD_BLOCK_CACHE_BYPASS_SECTORS 32        // Reads this large skip the cache
+
 // Default icons
 #define DEFAULT_FOLDER_ICON     "📁"
 #define DEFAULT_STATION_ICON    "📻"
@@ -130,6 +302,16 @@
 #define DEFAULT_SPORTS_ICON     "⚽"
 #define DEFAULT_TALK_ICON       "🎙️"
 
+// ============================================================================
+// FLASH CONFIG (NVS)
+// ============================================================================
+#define NVS_CONFIG_NAMESPACE    "jamwysteria"
+#define NVS_CONFIG_KEY          "config"
+#define NVS_CONFIG_VERSION      3       // Bump when ConfigRecord layout changes
+#define NVS_SSID_LENGTH         33      // 32 chars + terminator
+#define NVS_PASSWORD_LENGTH     65      // 64 chars + terminator
+#define NVS_STATION_LENGTH      96      // Longest last-station name kept in flash
+
 // ============================================================================
 // UI SETTINGS
 // ============================================================================
@@ -167,7 +349,8 @@ enum AppState {
   STATE_ADD_STATION,
   STATE_ADD_FOLDER,
   STATE_EDIT_STATION,
-  STATE_EDIT_FOLDER
+  STATE_EDIT_FOLDER,
+  STATE_AUDIO_SETTINGS
 };
 
 // ============================================================================
@@ -201,7 +384,8 @@ enum PlayerAction {
   PLAYER_ACTION_PREVIOUS,
   PLAYER_ACTION_VOLUME_UP,
   PLAYER_ACTION_VOLUME_DOWN,
-  PLAYER_ACTION_BACK
+  PLAYER_ACTION_BACK,
+  PLAYER_ACTION_LIVE
 };
 
 // Settings actions
@@ -214,6 +398,19 @@ enum SettingsAction {
   SETTINGS_ACTION_BACK
 };
 
+// Audio settings actions
+enum AudioSettingsAction {
+  AUDIO_ACTION_NONE,
+  AUDIO_ACTION_BASS_DOWN,
+  AUDIO_ACTION_BASS_UP,
+  AUDIO_ACTION_MID_DOWN,
+  AUDIO_ACTION_MID_UP,
+  AUDIO_ACTION_TREBLE_DOWN,
+  AUDIO_ACTION_TREBLE_UP,
+  AUDIO_ACTION_FLAT,
+  AUDIO_ACTION_BACK
+};
+
 // Folder view actions
 enum FolderAction {
   FOLDER_ACTION_NONE,
@@ -245,6 +442,7 @@ struct TouchPoint {
 struct Station {
   String name;
   String url;
+  std::vector<String> mirrors;  // Alternate URLs (other servers or bitrates)
   String iconPath;
   String parentFolder;
   int id;
@@ -266,9 +464,11 @@ struct StreamMetadata {
   String artist;
   String album;
   String genre;
+  String station;
   int bitrate;
   bool hasAlbumArt;
   String albumArtURL;
+  String streamURL;           // ICY StreamUrl (artwork or station page)
 };
 
 // Configuration structure
@@ -280,6 +480,10 @@ struct AppConfig {
   String lastStation;
   bool autoConnect;
   int screenTimeout;
+  int bufferProfile;
+  int eqBass;                 // Tone control gains in dB
+  int eqMid;
+  int eqTreble;
 };
 
 // ============================================================================
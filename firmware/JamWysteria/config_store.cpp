@@ -0,0 +1,128 @@
+/**
+ * Flash Config Store Implementation
+ */
+
+#include "config_store.h"
+#include <esp32/rom/crc.h>
+
+#define CONFIG_RECORD_MAGIC 0x4A57   // "JW"
+
+// Global instance
+ConfigStoreClass ConfigStore;
+
+ConfigStoreClass::ConfigStoreClass() : haveLastWritten(false) {
+  memset(&lastWritten, 0, sizeof(lastWritten));
+}
+
+bool ConfigStoreClass::load(AppConfig& config) {
+  ConfigRecord record;
+  
+  if (!prefs.begin(NVS_CONFIG_NAMESPACE, true)) {
+    Serial.println("[NVS] No stored configuration");
+    return false;
+  }
+  size_t length = prefs.getBytes(NVS_CONFIG_KEY, &record, sizeof(record));
+  prefs.end();
+  
+  if (length != sizeof(record) ||
+      record.magic != CONFIG_RECORD_MAGIC ||
+      record.version != NVS_CONFIG_VERSION ||
+      record.crc != checksum(record)) {
+    Serial.println("[NVS] Stored configuration missing or outdated");
+    return false;
+  }
+  
+  unpack(record, config);
+  lastWritten = record;
+  haveLastWritten = true;
+  
+  Serial.println("[NVS] ✓ Configuration loaded from flash");
+  return true;
+}
+
+bool ConfigStoreClass::save(const AppConfig& config) {
+  ConfigRecord record;
+  pack(config, record);
+  
+  // Unchanged records are not rewritten (spares flash erase cycles)
+  if (haveLastWritten && memcmp(&record, &lastWritten, sizeof(record)) == 0) {
+    return true;
+  }
+  
+  if (!prefs.begin(NVS_CONFIG_NAMESPACE, false)) {
+    Serial.println("[NVS] ✗ Failed to open flash storage");
+    return false;
+  }
+  size_t written = prefs.putBytes(NVS_CONFIG_KEY, &record, sizeof(record));
+  prefs.end();
+  
+  if (written != sizeof(record)) {
+    Serial.println("[NVS] ✗ Failed to save configuration");
+    return false;
+  }
+  
+  lastWritten = record;
+  haveLastWritten = true;
+  return true;
+}
+
+void ConfigStoreClass::clear() {
+  if (prefs.begin(NVS_CONFIG_NAMESPACE, false)) {
+    prefs.remove(NVS_CONFIG_KEY);
+    prefs.end();
+  }
+  haveLastWritten = false;
+}
+
+bool ConfigStoreClass::hasRecord() {
+  if (!prefs.begin(NVS_CONFIG_NAMESPACE, true)) {
+    return false;
+  }
+  bool found = prefs.isKey(NVS_CONFIG_KEY);
+  prefs.end();
+  return found;
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+void ConfigStoreClass::pack(const AppConfig& config, ConfigRecord& record) {
+  // Zero first so padding and string tails compare equal
+  memset(&record, 0, sizeof(record));
+  
+  record.magic = CONFIG_RECORD_MAGIC;
+  record.version = NVS_CONFIG_VERSION;
+  record.autoConnect = config.autoConnect ? 1 : 0;
+  record.volume = config.volume;
+  record.brightness = config.brightness;
+  record.screenTimeout = config.screenTimeout;
+  record.bufferProfile = config.bufferProfile;
+  record.eqBass = config.eqBass;
+  record.eqMid = config.eqMid;
+  record.eqTreble = config.eqTreble;
+  
+  strlcpy(record.wifiSSID, config.wifiSSID.c_str(), sizeof(record.wifiSSID));
+  strlcpy(record.wifiPassword, config.wifiPassword.c_str(), sizeof(record.wifiPassword));
+  strlcpy(record.lastStation, config.lastStation.c_str(), sizeof(record.lastStation));
+  
+  record.crc = checksum(record);
+}
+
+void ConfigStoreClass::unpack(const ConfigRecord& record, AppConfig& config) {
+  config.autoConnect = record.autoConnect != 0;
+  config.volume = record.volume;
+  config.brightness = record.brightness;
+  config.screenTimeout = record.screenTimeout;
+  config.bufferProfile = record.bufferProfile;
+  config.eqBass = record.eqBass;
+  config.eqMid = record.eqMid;
+  config.eqTreble = record.eqTreble;
+  config.wifiSSID = String(record.wifiSSID);
+  config.wifiPassword = String(record.wifiPassword);
+  config.lastStation = String(record.lastStation);
+}
+
+uint32_t ConfigStoreClass::checksum(const ConfigRecord& record) {
+  return crc32_le(0, (const uint8_t*)&record, offsetof(ConfigRecord, crc));
+}
@@ -0,0 +1,57 @@
+/**
+ * Flash Config Store for Jam Wysteria
+ *
+ * Mirrors AppConfig into NVS as one compact binary record so it
+ * can be read at boot before the SD card is mounted. The SD card
+ * copy (config.json) stays the human-editable source of truth.
+ */
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Preferences.h>
+#include "config.h"
+
+// On-flash layout (versioned, CRC protected)
+struct __attribute__((packed)) ConfigRecord {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t autoConnect;
+  int16_t volume;
+  int16_t brightness;
+  int32_t screenTimeout;
+  uint8_t bufferProfile;
+  int8_t eqBass;
+  int8_t eqMid;
+  int8_t eqTreble;
+  char wifiSSID[NVS_SSID_LENGTH];
+  char wifiPassword[NVS_PASSWORD_LENGTH];
+  char lastStation[NVS_STATION_LENGTH];
+  uint32_t crc;
+};
+
+class ConfigStoreClass {
+public:
+  ConfigStoreClass();
+  
+  // Record access (returns false if no valid record)
+  bool load(AppConfig& config);
+  bool save(const AppConfig& config);
+  void clear();
+  bool hasRecord();
+  
+private:
+  Preferences prefs;
+  ConfigRecord lastWritten;
+  bool haveLastWritten;
+  
+  // Helper functions
+  void pack(const AppConfig& config, ConfigRecord& record);
+  void unpack(const ConfigRecord& record, AppConfig& config);
+  uint32_t checksum(const ConfigRecord& record);
+};
+
+// Global instance
+extern ConfigStoreClass ConfigStore;
+
+#endif // CONFIG_STORE_H
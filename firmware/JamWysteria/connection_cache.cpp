@@ -0,0 +1,341 @@
+/**
+ * Connection Cache Implementation
+ */
+
+#include "connection_cache.h"
+#include <WiFiUdp.h>
+#include <esp_timer.h>
+
+#define DNS_PORT            53
+#define DNS_HEADER_SIZE     12
+#define DNS_PACKET_SIZE     512
+#define DNS_TYPE_A          1
+#define DNS_CLASS_IN        1
+
+// Global instance
+ConnectionCacheClass ConnectionCache;
+
+ConnectionCacheClass::ConnectionCacheClass() : useTick(0) {
+  lock = xSemaphoreCreateMutex();
+  queryLock = xSemaphoreCreateMutex();
+  memset(&stats, 0, sizeof(stats));
+}
+
+// ============================================================================
+// Host Addresses
+// ============================================================================
+
+bool ConnectionCacheClass::resolve(const String& host, IPAddress& address, bool* fromCache) {
+  if (fromCache != nullptr) {
+    *fromCache = false;
+  }
+  
+  // IP literal: nothing to look up
+  if (address.fromString(host.c_str())) {
+    return true;
+  }
+  
+  uint32_t now = uptimeSeconds();
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for (auto& entry : hosts) {
+    if (entry.host == host && now < entry.expiresAt) {
+      address = entry.address;
+      entry.lastUsed = ++useTick;
+      stats.dnsHits++;
+      xSemaphoreGive(lock);
+      
+      if (fromCache != nullptr) {
+        *fromCache = true;
+      }
+      return true;
+    }
+  }
+  stats.dnsMisses++;
+  xSemaphoreGive(lock);
+  
+  // One query at a time (fetch and warm tasks may both ask)
+  uint32_t ttl = DNS_TTL_MIN_S;
+  xSemaphoreTake(queryLock, portMAX_DELAY);
+  bool found = query(host, address, ttl);
+  if (!found) {
+    // Resolver trouble: fall back to lwIP, which hides the TTL
+    found = WiFi.hostByName(host.c_str(), address) == 1;
+    ttl = DNS_TTL_MIN_S;
+  }
+  xSemaphoreGive(queryLock);
+  
+  if (!found) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    stats.dnsFailures++;
+    xSemaphoreGive(lock);
+    return false;
+  }
+  
+  ttl = max((uint32_t)DNS_TTL_MIN_S, min(ttl, (uint32_t)DNS_TTL_MAX_S));
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  
+  HostCacheEntry* slot = nullptr;
+  for (auto& entry : hosts) {
+    if (entry.host == host) {
+      slot = &entry;
+      break;
+    }
+  }
+  
+  if (slot == nullptr) {
+    if (hosts.size() < DNS_CACHE_ENTRIES) {
+      hosts.push_back(HostCacheEntry());
+      slot = &hosts.back();
+    } else {
+      // Full: reuse the least recently used entry
+      slot = &hosts[0];
+      for (auto& entry : hosts) {
+        if (entry.lastUsed < slot->lastUsed) {
+          slot = &entry;
+        }
+      }
+    }
+  }
+  
+  slot->host = host;
+  slot->address = address;
+  slot->expiresAt = uptimeSeconds() + ttl;
+  slot->lastUsed = ++useTick;
+  
+  xSemaphoreGive(lock);
+  
+  Serial.printf("[DNS] %s -> %s (ttl %lus)\n", host.c_str(),
+                address.toString().c_str(), (unsigned long)ttl);
+  return true;
+}
+
+void ConnectionCacheClass::invalidate(const String& host) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for (auto it = hosts.begin(); it != hosts.end(); ++it) {
+    if (it->host == host) {
+      hosts.erase(it);
+      break;
+    }
+  }
+  xSemaphoreGive(lock);
+}
+
+// ============================================================================
+// Stream Parameters
+// ============================================================================
+
+bool ConnectionCacheClass::getParams(const String& url, StreamParams& result) {
+  bool found = false;
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  for (auto& entry : params) {
+    if (entry.url == url) {
+      result = entry.params;
+      entry.lastUsed = ++useTick;
+      found = true;
+      break;
+    }
+  }
+  
+  if (found) {
+    stats.paramHits++;
+  } else {
+    stats.paramMisses++;
+  }
+  xSemaphoreGive(lock);
+  
+  return found;
+}
+
+void ConnectionCacheClass::storeParams(const String& url, const StreamParams& value) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  
+  StreamParamsEntry* slot = nullptr;
+  for (auto& entry : params) {
+    if (entry.url == url) {
+      slot = &entry;
+      break;
+    }
+  }
+  
+  if (slot == nullptr) {
+    if (params.size() < STREAM_PARAMS_ENTRIES) {
+      params.push_back(StreamParamsEntry());
+      slot = &params.back();
+    } else {
+      slot = &params[0];
+      for (auto& entry : params) {
+        if (entry.lastUsed < slot->lastUsed) {
+          slot = &entry;
+        }
+      }
+    }
+  }
+  
+  slot->url = url;
+  slot->params = value;
+  slot->lastUsed = ++useTick;
+  
+  xSemaphoreGive(lock);
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+ConnectionCacheStats ConnectionCacheClass::getStats() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ConnectionCacheStats result = stats;
+  result.hosts = hosts.size();
+  result.params = params.size();
+  xSemaphoreGive(lock);
+  return result;
+}
+
+void ConnectionCacheClass::resetStats() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  memset(&stats, 0, sizeof(stats));
+  xSemaphoreGive(lock);
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+bool ConnectionCacheClass::query(const String& host, IPAddress& address, uint32_t& ttl) {
+  IPAddress server = WiFi.dnsIP();
+  if (server == IPAddress(0, 0, 0, 0) || host.length() == 0 || host.length() > 253) {
+    return false;
+  }
+  
+  uint8_t packet[DNS_PACKET_SIZE];
+  uint16_t id = esp_random() & 0xFFFF;
+  
+  // Header: one recursive question
+  memset(packet, 0, DNS_HEADER_SIZE);
+  packet[0] = id >> 8;
+  packet[1] = id & 0xFF;
+  packet[2] = 0x01;
+  packet[5] = 1;
+  
+  // Question: labels, then type A, class IN
+  int length = DNS_HEADER_SIZE;
+  int start = 0;
+  while (start <= (int)host.length()) {
+    int dot = host.indexOf('.', start);
+    if (dot < 0) {
+      dot = host.length();
+    }
+    int label = dot - start;
+    if (label == 0 || label > 63) {
+      return false;
+    }
+    packet[length++] = label;
+    memcpy(packet + length, host.c_str() + start, label);
+    length += label;
+    start = dot + 1;
+  }
+  packet[length++] = 0;
+  packet[length++] = 0;
+  packet[length++] = DNS_TYPE_A;
+  packet[length++] = 0;
+  packet[length++] = DNS_CLASS_IN;
+  
+  WiFiUDP udp;
+  if (!udp.begin(DNS_LOCAL_PORT + (esp_random() % 1000))) {
+    return false;
+  }
+  
+  udp.beginPacket(server, DNS_PORT);
+  udp.write(packet, length);
+  if (!udp.endPacket()) {
+    udp.stop();
+    return false;
+  }
+  
+  // Wait for the answer to this question (ignore strays)
+  int received = 0;
+  unsigned long sent = millis();
+  while (millis() - sent < DNS_QUERY_TIMEOUT_MS) {
+    if (udp.parsePacket() > 0) {
+      received = udp.read(packet, sizeof(packet));
+      if (received >= DNS_HEADER_SIZE && packet[0] == (id >> 8) && packet[1] == (id & 0xFF)) {
+        break;
+      }
+      received = 0;
+    }
+    vTaskDelay(pdMS_TO_TICKS(5));
+  }
+  udp.stop();
+  
+  // Must be a response without error
+  if (received < DNS_HEADER_SIZE || !(packet[2] & 0x80) || (packet[3] & 0x0F) != 0) {
+    return false;
+  }
+  
+  int questions = (packet[4] << 8) | packet[5];
+  int answers = (packet[6] << 8) | packet[7];
+  int offset = DNS_HEADER_SIZE;
+  
+  for (int i = 0; i < questions; i++) {
+    if (!skipName(packet, received, offset)) {
+      return false;
+    }
+    offset += 4;
+  }
+  
+  // A CNAME chain is only as fresh as its shortest-lived link
+  uint32_t shortest = 0xFFFFFFFF;
+  for (int i = 0; i < answers; i++) {
+    if (!skipName(packet, received, offset) || offset + 10 > received) {
+      return false;
+    }
+    
+    uint16_t type = (packet[offset] << 8) | packet[offset + 1];
+    uint16_t cls = (packet[offset + 2] << 8) | packet[offset + 3];
+    uint32_t recordTtl = ((uint32_t)packet[offset + 4] << 24) | ((uint32_t)packet[offset + 5] << 16) |
+                         ((uint32_t)packet[offset + 6] << 8) | packet[offset + 7];
+    uint16_t dataLength = (packet[offset + 8] << 8) | packet[offset + 9];
+    offset += 10;
+    
+    if (offset + dataLength > received) {
+      return false;
+    }
+    
+    shortest = min(shortest, recordTtl);
+    
+    if (type == DNS_TYPE_A && cls == DNS_CLASS_IN && dataLength == 4) {
+      address = IPAddress(packet[offset], packet[offset + 1], packet[offset + 2], packet[offset + 3]);
+      ttl = shortest;
+      return true;
+    }
+    
+    offset += dataLength;
+  }
+  
+  return false;
+}
+
+bool ConnectionCacheClass::skipName(const uint8_t* packet, int length, int& offset) {
+  while (offset < length) {
+    uint8_t label = packet[offset];
+    
+    // Compression pointer ends the name
+    if ((label & 0xC0) == 0xC0) {
+      offset += 2;
+      return offset <= length;
+    }
+    
+    offset += 1 + label;
+    if (label == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+uint32_t ConnectionCacheClass::uptimeSeconds() {
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
@@ -0,0 +1,87 @@
+/**
+ * Connection Cache for Jam Wysteria
+ *
+ * Remembers what it took to reach a station last time: the address
+ * of each stream host (from a small DNS resolver that reports record
+ * TTLs, clamped to a floor and ceiling) and the last known-good
+ * stream parameters per station URL. A cached host connects without
+ * a DNS round trip at tune-in.
+ *
+ * Used from the fetch and warm tasks; all access is locked.
+ */
+
+#ifndef CONNECTION_CACHE_H
+#define CONNECTION_CACHE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <vector>
+#include "config.h"
+
+// Resolved stream host
+struct HostCacheEntry {
+  String host;
+  IPAddress address;
+  uint32_t expiresAt;         // Seconds of uptime
+  uint32_t lastUsed;
+};
+
+// Last known-good stream parameters
+struct StreamParams {
+  char codec[8];              // "mp3", "aac", ...
+  int metaInterval;           // ICY metaint (0 = none)
+  int bitrate;                // kbps (0 = unknown)
+  bool sniffed;               // Codec read from the stream bytes, not the header
+};
+
+struct StreamParamsEntry {
+  String url;
+  StreamParams params;
+  uint32_t lastUsed;
+};
+
+// Hit counters
+struct ConnectionCacheStats {
+  uint32_t dnsHits;
+  uint32_t dnsMisses;         // Looked up (cache empty or expired)
+  uint32_t dnsFailures;
+  uint32_t paramHits;
+  uint32_t paramMisses;
+  int hosts;
+  int params;
+};
+
+class ConnectionCacheClass {
+public:
+  ConnectionCacheClass();
+  
+  // Host addresses (IP literals pass straight through)
+  bool resolve(const String& host, IPAddress& address, bool* fromCache = nullptr);
+  void invalidate(const String& host);
+  
+  // Stream parameters per station URL
+  bool getParams(const String& url, StreamParams& params);
+  void storeParams(const String& url, const StreamParams& params);
+  
+  // Statistics
+  ConnectionCacheStats getStats();
+  void resetStats();
+  
+private:
+  std::vector<HostCacheEntry> hosts;
+  std::vector<StreamParamsEntry> params;
+  ConnectionCacheStats stats;
+  SemaphoreHandle_t lock;
+  SemaphoreHandle_t queryLock;      // One DNS query in flight
+  uint32_t useTick;
+  
+  // Helper functions
+  bool query(const String& host, IPAddress& address, uint32_t& ttl);
+  bool skipName(const uint8_t* packet, int length, int& offset);
+  uint32_t uptimeSeconds();
+};
+
+// Global instance
+extern ConnectionCacheClass ConnectionCache;
+
+#endif // CONNECTION_CACHE_H
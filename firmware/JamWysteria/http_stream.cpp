@@ -0,0 +1,381 @@
+/**
+ * HTTP Stream Client Implementation
+ */
+
+#include "http_stream.h"
+#include "connection_cache.h"
+
+HttpStream::HttpStream() :
+  client(nullptr),
+  url(""),
+  contentType(""),
+  stationName(""),
+  lastError(""),
+  status(0),
+  bitrate(0),
+  chunked(false),
+  timeoutMs(STREAM_CONNECT_TIMEOUT),
+  metaInterval(0),
+  bytesUntilMeta(0),
+  metaLength(-1),
+  metaReceived(0),
+  metaCount(0),
+  metaCallback(nullptr) {
+  metaBuffer[0] = '\0';
+}
+
+HttpStream::~HttpStream() {
+  close();
+}
+
+bool HttpStream::open(const String& streamURL) {
+  close();
+  lastError = "";
+  
+  String current = streamURL;
+  
+  for (int hop = 0; hop <= STREAM_MAX_REDIRECTS; hop++) {
+    bool secure;
+    String host;
+    String path;
+    uint16_t port;
+    
+    if (!parseURL(current, secure, host, port, path)) {
+      lastError = "Invalid stream URL";
+      return false;
+    }
+    
+    if (!connectHost(secure, host, port)) {
+      return false;
+    }
+    
+    // HTTP/1.0 keeps servers from answering with chunked encoding
+    client->print("GET " + path + " HTTP/1.0\r\n" +
+                  "Host: " + host + "\r\n" +
+                  "User-Agent: JamWysteria/" + APP_VERSION + "\r\n" +
+                  "Icy-MetaData: 1\r\n" +
+                  "Accept: */*\r\n" +
+                  "Connection: close\r\n\r\n");
+    
+    String location;
+    if (!readHeaders(location)) {
+      close();
+      return false;
+    }
+    
+    if (status >= 300 && status < 400 && location.length() > 0) {
+      int redirectStatus = status;
+      close();
+      
+      // Relative redirects stay on the same host
+      if (location.startsWith("/")) {
+        location = String(secure ? "https://" : "http://") + host + ":" + String(port) + location;
+      }
+      
+      Serial.printf("[STREAM] Redirect %d -> %s\n", redirectStatus, location.c_str());
+      current = location;
+      continue;
+    }
+    
+    if (status != 200) {
+      lastError = "HTTP error " + String(status);
+      close();
+      return false;
+    }
+    
+    url = current;
+    bytesUntilMeta = metaInterval;
+    metaLength = -1;
+    return true;
+  }
+  
+  lastError = "Too many redirects";
+  close();
+  return false;
+}
+
+int HttpStream::read(uint8_t* buffer, size_t length) {
+  if (client == nullptr) {
+    return -1;
+  }
+  
+  // Finish a metadata block before handing out more audio
+  if (metaInterval > 0 && bytesUntilMeta == 0) {
+    if (!readMetadata()) {
+      return client->connected() ? 0 : -1;
+    }
+  }
+  
+  int ready = client->available();
+  if (ready <= 0) {
+    return client->connected() ? 0 : -1;
+  }
+  
+  size_t want = min(length, (size_t)ready);
+  if (metaInterval > 0) {
+    want = min(want, (size_t)bytesUntilMeta);
+  }
+  
+  int received = client->read(buffer, want);
+  if (received <= 0) {
+    return 0;
+  }
+  
+  if (metaInterval > 0) {
+    bytesUntilMeta -= received;
+  }
+  
+  return received;
+}
+
+void HttpStream::close() {
+  if (client != nullptr) {
+    client->stop();
+    client = nullptr;
+  }
+  
+  status = 0;
+  bitrate = 0;
+  chunked = false;
+  metaInterval = 0;
+  bytesUntilMeta = 0;
+  metaLength = -1;
+  metaCount = 0;
+  contentType = "";
+  stationName = "";
+}
+
+bool HttpStream::isOpen() {
+  return client != nullptr;
+}
+
+int HttpStream::getStatus() {
+  return status;
+}
+
+String HttpStream::getURL() {
+  return url;
+}
+
+String HttpStream::getContentType() {
+  return contentType;
+}
+
+String HttpStream::getStationName() {
+  return stationName;
+}
+
+int HttpStream::getBitrate() {
+  return bitrate;
+}
+
+int HttpStream::getMetaInterval() {
+  return metaInterval;
+}
+
+bool HttpStream::isChunked() {
+  return chunked;
+}
+
+String HttpStream::getError() {
+  return lastError;
+}
+
+void HttpStream::setTimeout(uint32_t ms) {
+  timeoutMs = ms;
+}
+
+void HttpStream::onMetadata(void (*callback)(const IcyMetadataParser& block)) {
+  metaCallback = callback;
+}
+
+uint32_t HttpStream::getMetadataCount() {
+  return metaCount;
+}
+
+const IcyMetadataParser& HttpStream::getMetadata() {
+  return metaParser;
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+bool HttpStream::connectHost(bool secure, const String& host, uint16_t port) {
+  if (secure) {
+    secureClient.setInsecure();
+    secureClient.setHandshakeTimeout(timeoutMs / 1000);
+    client = &secureClient;
+  } else {
+    client = &plainClient;
+  }
+  
+  // A cached address may have moved; one fresh lookup before giving up
+  for (int attempt = 0; attempt < 2; attempt++) {
+    IPAddress address;
+    bool fromCache = false;
+    if (!ConnectionCache.resolve(host, address, &fromCache)) {
+      lastError = "Cannot resolve " + host;
+      break;
+    }
+    
+    // TLS gets the host name for SNI; the address skips the lookup
+    bool connected = secure ?
+      secureClient.connect(address, port, host.c_str(), nullptr, nullptr, nullptr) :
+      plainClient.connect(address, port, timeoutMs);
+    if (connected) {
+      return true;
+    }
+    
+    lastError = "Cannot connect to " + host;
+    if (!fromCache) {
+      break;
+    }
+    ConnectionCache.invalidate(host);
+  }
+  
+  client = nullptr;
+  return false;
+}
+
+bool HttpStream::parseURL(const String& streamURL, bool& secure, String& host, uint16_t& port, String& path) {
+  String rest;
+  
+  if (streamURL.startsWith("https://")) {
+    secure = true;
+    port = 443;
+    rest = streamURL.substring(8);
+  } else if (streamURL.startsWith("http://")) {
+    secure = false;
+    port = 80;
+    rest = streamURL.substring(7);
+  } else {
+    return false;
+  }
+  
+  int slash = rest.indexOf('/');
+  String authority = (slash >= 0) ? rest.substring(0, slash) : rest;
+  path = (slash >= 0) ? rest.substring(slash) : "/";
+  
+  int colon = authority.lastIndexOf(':');
+  if (colon > 0) {
+    port = authority.substring(colon + 1).toInt();
+    host = authority.substring(0, colon);
+  } else {
+    host = authority;
+  }
+  
+  return host.length() > 0 && port > 0;
+}
+
+bool HttpStream::readHeaders(String& location) {
+  String line;
+  
+  // Status line: "HTTP/1.x 200 OK" or Shoutcast's "ICY 200 OK"
+  if (!readLine(line)) {
+    lastError = "No response from server";
+    return false;
+  }
+  
+  int space = line.indexOf(' ');
+  status = (space > 0) ? line.substring(space + 1).toInt() : 0;
+  
+  while (readLine(line)) {
+    if (line.length() == 0) {
+      return true;
+    }
+    
+    int colon = line.indexOf(':');
+    if (colon <= 0) {
+      continue;
+    }
+    
+    String key = line.substring(0, colon);
+    String value = line.substring(colon + 1);
+    key.toLowerCase();
+    value.trim();
+    
+    if (key == "content-type") {
+      contentType = value;
+      contentType.toLowerCase();
+    } else if (key == "location") {
+      location = value;
+    } else if (key == "icy-metaint") {
+      metaInterval = value.toInt();
+    } else if (key == "icy-br") {
+      bitrate = value.toInt();
+    } else if (key == "icy-name") {
+      stationName = value;
+    } else if (key == "transfer-encoding") {
+      value.toLowerCase();
+      chunked = value.indexOf("chunked") >= 0;
+    }
+  }
+  
+  lastError = "Incomplete response headers";
+  return false;
+}
+
+bool HttpStream::readLine(String& line) {
+  line = "";
+  unsigned long start = millis();
+  
+  while (millis() - start < timeoutMs) {
+    if (client->available() <= 0) {
+      if (!client->connected()) {
+        return false;
+      }
+      delay(1);
+      continue;
+    }
+    
+    char c = client->read();
+    if (c == '\n') {
+      return true;
+    }
+    if (c != '\r' && line.length() < 512) {
+      line += c;
+    }
+  }
+  
+  return false;
+}
+
+bool HttpStream::readMetadata() {
+  // One length byte (in 16-byte units), then the metadata text
+  if (metaLength < 0) {
+    if (client->available() <= 0) {
+      return false;
+    }
+    metaLength = client->read() * 16;
+    metaReceived = 0;
+    metaParser.begin(metaBuffer);
+  }
+  
+  while (metaReceived < metaLength) {
+    int ready = client->available();
+    if (ready <= 0) {
+      return false;
+    }
+    
+    int received = client->read((uint8_t*)metaBuffer + metaReceived,
+                                min(ready, metaLength - metaReceived));
+    if (received <= 0) {
+      return false;
+    }
+    metaParser.feed(received);      // Parsed as it arrives
+    metaReceived += received;
+  }
+  
+  if (metaLength > 0) {
+    metaParser.finish();
+    metaCount++;
+    if (metaCallback != nullptr) {
+      metaCallback(metaParser);
+    }
+  }
+  
+  metaLength = -1;
+  bytesUntilMeta = metaInterval;
+  return true;
+}
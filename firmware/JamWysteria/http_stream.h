@@ -0,0 +1,83 @@
+/**
+ * HTTP Stream Client for Jam Wysteria
+ *
+ * Opens an internet radio stream (HTTP or HTTPS, following
+ * redirects), parses the response headers and hands out the audio
+ * bytes with any ICY metadata blocks stripped. Reads never block.
+ */
+
+#ifndef HTTP_STREAM_H
+#define HTTP_STREAM_H
+
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include "audio_io.h"
+#include "icy_metadata.h"
+#include "config.h"
+
+#define ICY_META_MAX_LENGTH (255 * 16)
+
+class HttpStream : public AudioSource {
+public:
+  HttpStream();
+  ~HttpStream();
+  
+  // Connection
+  bool open(const String& url);
+  int read(uint8_t* buffer, size_t length) override;
+  void close() override;
+  bool isOpen();
+  void setTimeout(uint32_t ms);   // Connect and header wait (STREAM_CONNECT_TIMEOUT)
+  
+  // Response info
+  int getStatus();
+  String getURL();              // After redirects
+  String getContentType();
+  String getStationName();
+  int getBitrate();             // icy-br in kbps (0 = unknown)
+  int getMetaInterval();
+  bool isChunked();
+  String getError();
+  
+  // Called from read() with each metadata block, parsed in place
+  // (fields point into the block and are only valid during the call)
+  void onMetadata(void (*callback)(const IcyMetadataParser& block));
+  
+  // Last metadata block, for polling instead (valid until the next starts)
+  uint32_t getMetadataCount();
+  const IcyMetadataParser& getMetadata();
+  
+private:
+  WiFiClient plainClient;
+  WiFiClientSecure secureClient;
+  Client* client;
+  
+  // Response
+  String url;
+  String contentType;
+  String stationName;
+  String lastError;
+  int status;
+  int bitrate;
+  bool chunked;
+  uint32_t timeoutMs;
+  
+  // ICY metadata demux
+  int metaInterval;
+  int bytesUntilMeta;
+  int metaLength;               // -1 = waiting for the length byte
+  int metaReceived;
+  char metaBuffer[ICY_META_MAX_LENGTH];
+  IcyMetadataParser metaParser;
+  uint32_t metaCount;
+  void (*metaCallback)(const IcyMetadataParser& block);
+  
+  // Helper functions
+  bool connectHost(bool secure, const String& host, uint16_t port);
+  bool parseURL(const String& url, bool& secure, String& host, uint16_t& port, String& path);
+  bool readHeaders(String& location);
+  bool readLine(String& line);
+  bool readMetadata();
+};
+
+#endif // HTTP_STREAM_H
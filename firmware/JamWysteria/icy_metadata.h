@@ -0,0 +1,350 @@
+/**
+ * ICY Metadata Parser for Jam Wysteria
+ *
+ * Splits a Shoutcast/Icecast metadata block (StreamTitle='...';
+ * StreamUrl='...';) into its fields as the bytes arrive, without
+ * copying: every key and value is a span into the caller's block
+ * buffer. A quoted value only ends at a quote and ';' followed by the
+ * end of the block, its NUL padding or the next Key=', so quotes and
+ * "';" inside a title survive.
+ *
+ * Text is normalized to UTF-8 on its one copy out: valid UTF-8 passes
+ * through, anything else is read as Windows-1252 (the Latin-1
+ * superset legacy encoders send).
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef ICY_METADATA_H
+#define ICY_METADATA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define ICY_MAX_FIELDS 8
+
+// Text inside a metadata block (not NUL-terminated)
+struct IcySpan {
+  const char* data;
+  size_t length;
+  
+  bool found() const { return data != nullptr; }
+  
+  bool equals(const char* text) const {
+    return data != nullptr && strlen(text) == length && memcmp(data, text, length) == 0;
+  }
+};
+
+struct IcyField {
+  IcySpan key;
+  IcySpan value;
+};
+
+class IcyMetadataParser {
+public:
+  IcyMetadataParser() : block(nullptr), parsed(0), fieldCount(0), state(PADDING) {}
+  
+  // Start a block; the caller writes it into `buffer` and reports each
+  // piece with feed() (fields point into the buffer, so it must stay put)
+  void begin(const char* buffer) {
+    block = buffer;
+    parsed = 0;
+    fieldCount = 0;
+    state = KEY;
+    keyStart = 0;
+  }
+  
+  // `length` more bytes have arrived at the end of the block
+  void feed(size_t length) {
+    size_t end = parsed + length;
+    for (size_t pos = parsed; pos < end; pos++) {
+      step(pos, block[pos]);
+    }
+    parsed = end;
+  }
+  
+  // Block complete: close a value the server left open
+  void finish() {
+    switch (state) {
+      case VALUE:
+      case BARE:
+        endField(trimPadding(parsed));
+        break;
+      case QUOTE:
+      case SEMICOLON:
+      case NEXT_KEY:
+      case NEXT_EQUALS:
+        endField(quotePos);
+        break;
+      default:
+        break;
+    }
+    state = PADDING;
+  }
+  
+  // Fields of the last block
+  int count() const { return fieldCount; }
+  const IcyField& field(int index) const { return fields[index]; }
+  
+  IcySpan find(const char* key) const {
+    for (int i = 0; i < fieldCount; i++) {
+      if (fields[i].key.equals(key)) {
+        return fields[i].value;
+      }
+    }
+    return IcySpan{nullptr, 0};
+  }
+  
+private:
+  enum State {
+    KEY,
+    AFTER_EQUALS,
+    VALUE,          // Inside quotes
+    BARE,           // Unquoted value, ends at ';'
+    QUOTE,          // Quote seen: maybe the end
+    SEMICOLON,      // "';" seen: the end if a key or the padding follows
+    NEXT_KEY,       // Reading what may be the next key
+    NEXT_EQUALS,    // "Key=" after "';": a quote confirms it
+    PADDING
+  };
+  
+  const char* block;
+  size_t parsed;
+  IcyField fields[ICY_MAX_FIELDS];
+  int fieldCount;
+  State state;
+  size_t keyStart;
+  size_t keyEnd;
+  size_t valueStart;
+  size_t quotePos;            // Candidate end of the value
+  size_t nextKeyStart;
+  size_t nextKeyEnd;
+  
+  static bool isKeyChar(char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == '-';
+  }
+  
+  void step(size_t pos, char c) {
+    switch (state) {
+      case KEY:
+        if (pos == keyStart && (c == ';' || c == ' ' || c == '\0')) {
+          keyStart = pos + 1;     // Separators and padding between fields
+          if (c == '\0') {
+            state = PADDING;
+          }
+        } else if (c == '=') {
+          keyEnd = pos;
+          state = AFTER_EQUALS;
+        } else if (!isKeyChar(c)) {
+          state = PADDING;        // Not metadata we understand
+        }
+        break;
+        
+      case AFTER_EQUALS:
+        if (c == '\'') {
+          valueStart = pos + 1;
+          state = VALUE;
+        } else {
+          valueStart = pos;
+          state = BARE;
+          step(pos, c);
+        }
+        break;
+        
+      case BARE:
+        if (c == ';' || c == '\0') {
+          endField(pos);
+          keyStart = pos + 1;
+          state = c == '\0' ? PADDING : KEY;
+        }
+        break;
+        
+      case VALUE:
+        if (c == '\'') {
+          quotePos = pos;
+          state = QUOTE;
+        } else if (c == '\0') {
+          endField(pos);          // Padding before the closing quote
+          state = PADDING;
+        }
+        break;
+        
+      case QUOTE:
+        if (c == ';') {
+          state = SEMICOLON;
+        } else if (c == '\0') {
+          endField(quotePos);
+          state = PADDING;
+        } else if (c == '\'') {
+          quotePos = pos;
+        } else {
+          state = VALUE;
+        }
+        break;
+        
+      case SEMICOLON:
+        if (c == '\0') {
+          endField(quotePos);
+          state = PADDING;
+        } else if (c == ' ') {
+          break;                  // "'; Key='" separates fields too
+        } else if (isKeyChar(c)) {
+          nextKeyStart = pos;
+          state = NEXT_KEY;
+        } else {
+          state = VALUE;
+          step(pos, c);
+        }
+        break;
+        
+      case NEXT_KEY:
+        if (c == '=') {
+          nextKeyEnd = pos;
+          state = NEXT_EQUALS;
+        } else if (!isKeyChar(c)) {
+          state = VALUE;
+          step(pos, c);
+        }
+        break;
+        
+      case NEXT_EQUALS:
+        if (c == '\'') {
+          // Confirmed: the value ended at the quote, a new field starts
+          endField(quotePos);
+          keyStart = nextKeyStart;
+          keyEnd = nextKeyEnd;
+          valueStart = pos + 1;
+          state = VALUE;
+        } else {
+          state = VALUE;
+          step(pos, c);
+        }
+        break;
+        
+      case PADDING:
+        break;
+    }
+  }
+  
+  void endField(size_t valueEnd) {
+    if (fieldCount >= ICY_MAX_FIELDS) {
+      return;
+    }
+    IcyField& field = fields[fieldCount++];
+    field.key = IcySpan{block + keyStart, keyEnd - keyStart};
+    field.value = IcySpan{block + valueStart, valueEnd > valueStart ? valueEnd - valueStart : 0};
+  }
+  
+  size_t trimPadding(size_t end) const {
+    while (end > valueStart && block[end - 1] == '\0') {
+      end--;
+    }
+    return end;
+  }
+};
+
+// ============================================================================
+// Text Helpers
+// ============================================================================
+
+// "Artist - Title" (the usual StreamTitle form); no separator: all title
+inline void icySplitTitle(IcySpan text, IcySpan& artist, IcySpan& title) {
+  for (size_t i = 1; i + 3 <= text.length; i++) {
+    if (memcmp(text.data + i, " - ", 3) == 0) {
+      artist = IcySpan{text.data, i};
+      title = IcySpan{text.data + i + 3, text.length - i - 3};
+      return;
+    }
+  }
+  artist = IcySpan{text.data, 0};
+  title = text;
+}
+
+// Length of the UTF-8 sequence starting at `text` (0 = not valid UTF-8)
+inline size_t icyUtf8Length(const uint8_t* text, size_t available) {
+  uint8_t lead = text[0];
+  size_t length = lead < 0x80 ? 1 : (lead & 0xE0) == 0xC0 ? 2 :
+                  (lead & 0xF0) == 0xE0 ? 3 : (lead & 0xF8) == 0xF0 ? 4 : 0;
+  if (length == 0 || length > available || (length == 2 && lead < 0xC2)) {
+    return 0;
+  }
+  for (size_t i = 1; i < length; i++) {
+    if ((text[i] & 0xC0) != 0x80) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+inline bool icyIsUtf8(IcySpan text) {
+  const uint8_t* bytes = (const uint8_t*)text.data;
+  for (size_t i = 0; i < text.length;) {
+    size_t length = icyUtf8Length(bytes + i, text.length - i);
+    if (length == 0) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+// Copy as NUL-terminated UTF-8, whole characters only; returns the length
+inline size_t icyCopyUtf8(IcySpan text, char* out, size_t size) {
+  // Windows-1252 0x80-0x9F; the rest of the upper half is Latin-1
+  static const uint16_t cp1252[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+  };
+  
+  if (size == 0) {
+    return 0;
+  }
+  
+  const uint8_t* bytes = (const uint8_t*)text.data;
+  bool utf8 = icyIsUtf8(text);
+  size_t used = 0;
+  
+  for (size_t i = 0; i < text.length;) {
+    uint8_t c = bytes[i];
+    char encoded[4];
+    size_t length;
+    
+    if (c < 0x20) {
+      encoded[0] = ' ';           // Control characters
+      length = 1;
+      i++;
+    } else if (utf8 || c < 0x80) {
+      length = utf8 ? icyUtf8Length(bytes + i, text.length - i) : 1;
+      memcpy(encoded, bytes + i, length);
+      i += length;
+    } else {
+      uint16_t code = c < 0xA0 ? cp1252[c - 0x80] : c;
+      if (code < 0x800) {
+        encoded[0] = (char)(0xC0 | (code >> 6));
+        encoded[1] = (char)(0x80 | (code & 0x3F));
+        length = 2;
+      } else {
+        encoded[0] = (char)(0xE0 | (code >> 12));
+        encoded[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+        encoded[2] = (char)(0x80 | (code & 0x3F));
+        length = 3;
+      }
+      i++;
+    }
+    
+    if (used + length >= size) {
+      break;
+    }
+    memcpy(out + used, encoded, length);
+    used += length;
+  }
+  
+  out[used] = '\0';
+  return used;
+}
+
+#endif // ICY_METADATA_H
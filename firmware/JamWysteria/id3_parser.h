@@ -0,0 +1,530 @@
+/**
+ * ID3v2 Tag Parser for Jam Wysteria
+ *
+ * Reads the ID3v2 tag at the start of a file as the file streams past,
+ * in chunks of any size. Title, artist, album and genre (TIT2, TPE1,
+ * TALB, TCON) are decoded to UTF-8 and handed to the listener; the
+ * cover picture (APIC) is passed through in pieces as it arrives, so
+ * neither the tag nor the picture is ever held in RAM. Handles
+ * versions 2.2 to 2.4. Frames that are compressed, encrypted or
+ * unsynchronised are skipped, as is a tag unsynchronised as a whole.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef ID3_PARSER_H
+#define ID3_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#define ID3_TEXT_MAX 128            // Decoded text (UTF-8) per frame
+#define ID3_TEXT_RAW_MAX 256        // Frame bytes read for it (UTF-16 is twice as long)
+
+enum Id3Field {
+  ID3_TITLE,
+  ID3_ARTIST,
+  ID3_ALBUM,
+  ID3_GENRE
+};
+
+class Id3Listener {
+public:
+  virtual ~Id3Listener() {}
+  
+  // Text frame, UTF-8 (only valid during the call)
+  virtual void onId3Text(Id3Field field, const char* text) = 0;
+  
+  // Picture: return false from start to skip it; end reports whether
+  // every byte arrived
+  virtual bool onId3ImageStart(const char* mimeType, uint8_t pictureType, size_t size) = 0;
+  virtual void onId3ImageData(const uint8_t* data, size_t length) = 0;
+  virtual void onId3ImageEnd(bool complete) = 0;
+};
+
+class Id3Parser {
+public:
+  explicit Id3Parser(Id3Listener* listener) : listener(listener) {
+    begin();
+  }
+  
+  // Start of a new file
+  void begin() {
+    state = HEADER;
+    scratchUsed = 0;
+    tagRemaining = 0;
+    imageOpen = false;
+  }
+  
+  // Next bytes of the file, in order; ignored once the tag is done
+  void feed(const uint8_t* data, size_t length) {
+    while (length > 0 && state != DONE) {
+      bool inTag = state != HEADER;
+      size_t available = inTag && length > tagRemaining ? tagRemaining : length;
+      size_t used = step(data, available);
+      data += used;
+      length -= used;
+      
+      if (inTag) {
+        tagRemaining -= used;
+        if (tagRemaining == 0) {
+          finishTag();
+        }
+      }
+    }
+  }
+  
+  // Tag read (or there was none): the rest of the file is audio
+  bool isDone() const {
+    return state == DONE;
+  }
+  
+private:
+  enum State {
+    HEADER,
+    EXTENDED_SIZE,
+    EXTENDED_SKIP,
+    FRAME_HEADER,
+    FRAME_PREFIX,               // Grouping byte, data length indicator
+    FRAME_SKIP,
+    TEXT,
+    IMAGE_ENCODING,
+    IMAGE_FORMAT,               // v2.2: three-letter format instead of a MIME type
+    IMAGE_MIME,
+    IMAGE_TYPE,
+    IMAGE_DESCRIPTION,
+    IMAGE_DATA,
+    DONE
+  };
+  
+  Id3Listener* listener;
+  State state;
+  State contentState;           // Entered after the frame prefix
+  uint8_t version;
+  size_t tagRemaining;          // Tag bytes after the header
+  size_t frameRemaining;
+  size_t skipRemaining;
+  uint8_t scratch[10];          // Headers being collected
+  size_t scratchUsed;
+  
+  // Frame being read
+  Id3Field textField;
+  uint8_t raw[ID3_TEXT_RAW_MAX];
+  size_t rawUsed;
+  char text[ID3_TEXT_MAX];
+  uint8_t encoding;
+  char mime[32];
+  size_t mimeUsed;
+  uint8_t pictureType;
+  size_t descriptionBytes;
+  uint8_t lastByte;
+  bool imageOpen;
+  
+  static size_t syncsafe(const uint8_t* bytes) {
+    return ((size_t)(bytes[0] & 0x7F) << 21) | ((size_t)(bytes[1] & 0x7F) << 14) |
+           ((size_t)(bytes[2] & 0x7F) << 7) | (bytes[3] & 0x7F);
+  }
+  
+  static size_t bigEndian(const uint8_t* bytes, size_t count) {
+    size_t value = 0;
+    for (size_t i = 0; i < count; i++) {
+      value = (value << 8) | bytes[i];
+    }
+    return value;
+  }
+  
+  size_t collect(const uint8_t* data, size_t length, size_t want) {
+    size_t count = want - scratchUsed < length ? want - scratchUsed : length;
+    memcpy(scratch + scratchUsed, data, count);
+    scratchUsed += count;
+    return count;
+  }
+  
+  size_t step(const uint8_t* data, size_t length) {
+    switch (state) {
+      case HEADER: {
+        size_t used = collect(data, length, 10);
+        if (scratchUsed == 10) {
+          parseHeader();
+        }
+        return used;
+      }
+      
+      case EXTENDED_SIZE: {
+        size_t used = collect(data, length, 4);
+        if (scratchUsed == 4) {
+          // v2.4 counts the size field itself, v2.3 does not
+          size_t size = version == 4 ? syncsafe(scratch) : bigEndian(scratch, 4);
+          skipRemaining = version == 4 ? (size > 4 ? size - 4 : 0) : size;
+          scratchUsed = 0;
+          state = skipRemaining > 0 ? EXTENDED_SKIP : FRAME_HEADER;
+        }
+        return used;
+      }
+      
+      case EXTENDED_SKIP: {
+        size_t used = length < skipRemaining ? length : skipRemaining;
+        skipRemaining -= used;
+        if (skipRemaining == 0) {
+          state = FRAME_HEADER;
+        }
+        return used;
+      }
+      
+      case FRAME_HEADER: {
+        size_t size = version == 2 ? 6 : 10;
+        size_t used = collect(data, length, size);
+        if (scratchUsed == size) {
+          parseFrameHeader();
+        }
+        return used;
+      }
+      
+      case DONE:
+        return length;
+        
+      default: {
+        size_t used = frameStep(data, length < frameRemaining ? length : frameRemaining);
+        frameRemaining -= used;
+        if (frameRemaining == 0) {
+          endFrame();
+        }
+        return used;
+      }
+    }
+  }
+  
+  void parseHeader() {
+    scratchUsed = 0;
+    if (memcmp(scratch, "ID3", 3) != 0 || scratch[3] < 2 || scratch[3] > 4) {
+      state = DONE;             // No tag
+      return;
+    }
+    
+    version = scratch[3];
+    uint8_t flags = scratch[5];
+    tagRemaining = syncsafe(scratch + 6);
+    
+    // Whole-tag unsynchronisation (and v2.2 compression) is not worth undoing
+    if (tagRemaining == 0 || (version < 4 && (flags & 0x80)) || (version == 2 && (flags & 0x40))) {
+      state = DONE;
+      return;
+    }
+    
+    state = version > 2 && (flags & 0x40) ? EXTENDED_SIZE : FRAME_HEADER;
+  }
+  
+  void parseFrameHeader() {
+    scratchUsed = 0;
+    if (scratch[0] == 0) {
+      state = DONE;             // Padding: no frames follow
+      return;
+    }
+    
+    size_t size;
+    size_t prefix = 0;
+    bool readable = true;
+    if (version == 2) {
+      size = bigEndian(scratch + 3, 3);
+    } else if (version == 3) {
+      size = bigEndian(scratch + 4, 4);
+      readable = (scratch[9] & 0xC0) == 0;
+      prefix = (scratch[9] & 0x20) ? 1 : 0;
+    } else {
+      size = syncsafe(scratch + 4);
+      readable = (scratch[9] & 0x0E) == 0;
+      prefix = ((scratch[9] & 0x40) ? 1 : 0) + ((scratch[9] & 0x01) ? 4 : 0);
+    }
+    
+    if (size > tagRemaining) {
+      state = DONE;             // Corrupt
+      return;
+    }
+    if (size == 0) {
+      state = FRAME_HEADER;
+      return;
+    }
+    
+    contentState = FRAME_SKIP;
+    if (readable && size > prefix) {
+      contentState = identifyFrame();
+    }
+    
+    frameRemaining = size;
+    skipRemaining = prefix;
+    rawUsed = 0;
+    state = prefix > 0 && contentState != FRAME_SKIP ? FRAME_PREFIX : contentState;
+  }
+  
+  State identifyFrame() {
+    static const struct {
+      const char* v22;
+      const char* v23;
+      Id3Field field;
+    } frames[] = {
+      {"TT2", "TIT2", ID3_TITLE},
+      {"TP1", "TPE1", ID3_ARTIST},
+      {"TAL", "TALB", ID3_ALBUM},
+      {"TCO", "TCON", ID3_GENRE}
+    };
+    
+    const char* id = (const char*)scratch;
+    size_t idLength = version == 2 ? 3 : 4;
+    for (const auto& frame : frames) {
+      if (memcmp(id, version == 2 ? frame.v22 : frame.v23, idLength) == 0) {
+        textField = frame.field;
+        return TEXT;
+      }
+    }
+    if (memcmp(id, version == 2 ? "PIC" : "APIC", idLength) == 0) {
+      return IMAGE_ENCODING;
+    }
+    return FRAME_SKIP;
+  }
+  
+  size_t frameStep(const uint8_t* data, size_t length) {
+    switch (state) {
+      case FRAME_PREFIX: {
+        size_t used = length < skipRemaining ? length : skipRemaining;
+        skipRemaining -= used;
+        if (skipRemaining == 0) {
+          state = contentState;
+        }
+        return used;
+      }
+      
+      case TEXT: {
+        // Past the buffer the text would not fit the metadata anyway
+        size_t count = ID3_TEXT_RAW_MAX - rawUsed < length ? ID3_TEXT_RAW_MAX - rawUsed : length;
+        memcpy(raw + rawUsed, data, count);
+        rawUsed += count;
+        return length;
+      }
+      
+      case IMAGE_ENCODING:
+        encoding = data[0];
+        mimeUsed = 0;
+        state = version == 2 ? IMAGE_FORMAT : IMAGE_MIME;
+        return 1;
+        
+      case IMAGE_FORMAT:
+        mime[mimeUsed++] = (char)data[0];
+        if (mimeUsed == 3) {
+          mime[3] = '\0';
+          snprintf(mime, sizeof(mime), "%s", strcmp(mime, "PNG") == 0 ? "image/png" : "image/jpeg");
+          state = IMAGE_TYPE;
+        }
+        return 1;
+        
+      case IMAGE_MIME:
+        if (data[0] == 0) {
+          mime[mimeUsed] = '\0';
+          state = IMAGE_TYPE;
+        } else if (mimeUsed < sizeof(mime) - 1) {
+          mime[mimeUsed++] = (char)data[0];
+        }
+        return 1;
+        
+      case IMAGE_TYPE:
+        pictureType = data[0];
+        descriptionBytes = 0;
+        state = IMAGE_DESCRIPTION;
+        return 1;
+        
+      case IMAGE_DESCRIPTION: {
+        // Ends at a NUL, a double NUL on a character boundary in UTF-16
+        uint8_t c = data[0];
+        bool wide = encoding == 1 || encoding == 2;
+        descriptionBytes++;
+        if (wide ? (descriptionBytes % 2 == 0 && lastByte == 0 && c == 0) : c == 0) {
+          startImage(frameRemaining - 1);
+        }
+        lastByte = c;
+        return 1;
+      }
+      
+      case IMAGE_DATA:
+        listener->onId3ImageData(data, length);
+        return length;
+        
+      default:
+        return length;          // FRAME_SKIP
+    }
+  }
+  
+  void startImage(size_t size) {
+    if (size > 0 && listener->onId3ImageStart(mime, pictureType, size)) {
+      imageOpen = true;
+      state = IMAGE_DATA;
+    } else {
+      state = FRAME_SKIP;
+    }
+  }
+  
+  void endFrame() {
+    if (state == TEXT) {
+      emitText();
+    } else if (state == IMAGE_DATA) {
+      imageOpen = false;
+      listener->onId3ImageEnd(true);
+    }
+    state = FRAME_HEADER;
+  }
+  
+  void finishTag() {
+    if (imageOpen) {
+      imageOpen = false;
+      listener->onId3ImageEnd(false);
+    }
+    state = DONE;
+  }
+  
+  // ==========================================================================
+  // Text Frames
+  // ==========================================================================
+  
+  void emitText() {
+    if (rawUsed < 2) {
+      return;
+    }
+    
+    decodeText(raw + 1, rawUsed - 1, raw[0]);
+    if (textField == ID3_GENRE) {
+      resolveGenre();
+    }
+    if (text[0] != '\0') {
+      listener->onId3Text(textField, text);
+    }
+  }
+  
+  // Latin-1 (0), UTF-16 with BOM (1), UTF-16BE (2) or UTF-8 (3) to
+  // UTF-8, first value only, cut on a character boundary
+  void decodeText(const uint8_t* in, size_t length, uint8_t textEncoding) {
+    bool wide = textEncoding == 1 || textEncoding == 2;
+    bool bigEndianText = true;
+    size_t i = 0;
+    if (textEncoding == 1 && length >= 2 && ((in[0] == 0xFF && in[1] == 0xFE) || (in[0] == 0xFE && in[1] == 0xFF))) {
+      bigEndianText = in[0] == 0xFE;
+      i = 2;
+    }
+    
+    size_t used = 0;
+    while (i < length) {
+      char encoded[4];
+      size_t count;
+      
+      if (wide) {
+        if (i + 1 >= length) {
+          break;
+        }
+        uint32_t code = bigEndianText ? (in[i] << 8 | in[i + 1]) : (in[i + 1] << 8 | in[i]);
+        i += 2;
+        if (code >= 0xD800 && code < 0xDC00 && i + 1 < length) {
+          uint32_t low = bigEndianText ? (in[i] << 8 | in[i + 1]) : (in[i + 1] << 8 | in[i]);
+          if (low >= 0xDC00 && low < 0xE000) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            i += 2;
+          }
+        }
+        if (code == 0) {
+          break;                // Further values follow
+        }
+        count = encodeUtf8(code, encoded);
+      } else if (textEncoding == 3) {
+        uint8_t lead = in[i];
+        count = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+        if (lead == 0 || i + count > length) {
+          break;
+        }
+        memcpy(encoded, in + i, count);
+        i += count;
+      } else {
+        if (in[i] == 0) {
+          break;
+        }
+        count = encodeUtf8(in[i++], encoded);
+      }
+      
+      if (used + count >= sizeof(text)) {
+        break;
+      }
+      memcpy(text + used, encoded, count);
+      used += count;
+    }
+    
+    text[used] = '\0';
+  }
+  
+  static size_t encodeUtf8(uint32_t code, char* out) {
+    if (code < 0x80) {
+      out[0] = (char)code;
+      return 1;
+    }
+    if (code < 0x800) {
+      out[0] = (char)(0xC0 | (code >> 6));
+      out[1] = (char)(0x80 | (code & 0x3F));
+      return 2;
+    }
+    if (code < 0x10000) {
+      out[0] = (char)(0xE0 | (code >> 12));
+      out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+      out[2] = (char)(0x80 | (code & 0x3F));
+      return 3;
+    }
+    out[0] = (char)(0xF0 | (code >> 18));
+    out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (code & 0x3F));
+    return 4;
+  }
+  
+  // "(17)", "17" (v2.4) or "(17)Rock": an ID3v1 genre number unless
+  // text refines it
+  void resolveGenre() {
+    static const char* const genres[] = {
+      "Blues", "Classic Rock", "Country", "Dance", "Disco", "Funk", "Grunge", "Hip-Hop",
+      "Jazz", "Metal", "New Age", "Oldies", "Other", "Pop", "R&B", "Rap",
+      "Reggae", "Rock", "Techno", "Industrial", "Alternative", "Ska", "Death Metal", "Pranks",
+      "Soundtrack", "Euro-Techno", "Ambient", "Trip-Hop", "Vocal", "Jazz+Funk", "Fusion", "Trance",
+      "Classical", "Instrumental", "Acid", "House", "Game", "Sound Clip", "Gospel", "Noise",
+      "Alternative Rock", "Bass", "Soul", "Punk", "Space", "Meditative", "Instrumental Pop", "Instrumental Rock",
+      "Ethnic", "Gothic", "Darkwave", "Techno-Industrial", "Electronic", "Pop-Folk", "Eurodance", "Dream",
+      "Southern Rock", "Comedy", "Cult", "Gangsta", "Top 40", "Christian Rap", "Pop/Funk", "Jungle",
+      "Native American", "Cabaret", "New Wave", "Psychedelic", "Rave", "Showtunes", "Trailer", "Lo-Fi",
+      "Tribal", "Acid Punk", "Acid Jazz", "Polka", "Retro", "Musical", "Rock & Roll", "Hard Rock"
+    };
+    
+    const char* p = text;
+    bool bracketed = *p == '(';
+    if (bracketed) {
+      p++;
+    }
+    
+    int number = 0;
+    int digits = 0;
+    while (*p >= '0' && *p <= '9' && digits < 3) {
+      number = number * 10 + (*p++ - '0');
+      digits++;
+    }
+    if (digits == 0 || (bracketed && *p != ')')) {
+      return;                   // Plain text
+    }
+    if (bracketed) {
+      p++;
+    }
+    
+    if (*p != '\0') {
+      if (bracketed) {
+        memmove(text, p, strlen(p) + 1);
+      }
+      return;
+    }
+    if (number < (int)(sizeof(genres) / sizeof(genres[0]))) {
+      snprintf(text, sizeof(text), "%s", genres[number]);
+    }
+  }
+};
+
+#endif // ID3_PARSER_H
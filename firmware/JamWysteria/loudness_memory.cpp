@@ -0,0 +1,150 @@
+/**
+ * Loudness Memory Implementation
+ */
+
+#include "loudness_memory.h"
+#include "sd_manager.h"
+#include <ArduinoJson.h>
+
+// Global instance
+LoudnessMemoryClass LoudnessMemory;
+
+LoudnessMemoryClass::LoudnessMemoryClass() : useTick(0), dirty(false), dirtySince(0) {
+}
+
+// ============================================================================
+// Learned Gains
+// ============================================================================
+
+bool LoudnessMemoryClass::lookup(const String& url, float& gainDb) {
+  for (auto& entry : entries) {
+    if (entry.url == url) {
+      gainDb = entry.gainDb;
+      entry.lastUsed = ++useTick;
+      return true;
+    }
+  }
+  return false;
+}
+
+void LoudnessMemoryClass::store(const String& url, float gainDb) {
+  LearnedLoudness* slot = nullptr;
+  for (auto& entry : entries) {
+    if (entry.url == url) {
+      slot = &entry;
+      break;
+    }
+  }
+  
+  if (slot == nullptr) {
+    if (entries.size() < LOUDNESS_MEMORY_ENTRIES) {
+      entries.push_back(LearnedLoudness());
+      slot = &entries.back();
+    } else {
+      // Full: forget the station heard least recently
+      slot = &entries[0];
+      for (auto& entry : entries) {
+        if (entry.lastUsed < slot->lastUsed) {
+          slot = &entry;
+        }
+      }
+    }
+    slot->url = url;
+    slot->gainDb = gainDb + LOUDNESS_SAVE_DELTA_DB * 2;   // Force the write below
+  }
+  
+  slot->lastUsed = ++useTick;
+  
+  // Small drifts are not worth an SD write
+  if (fabsf(slot->gainDb - gainDb) < LOUDNESS_SAVE_DELTA_DB) {
+    return;
+  }
+  
+  slot->gainDb = gainDb;
+  if (!dirty) {
+    dirty = true;
+    dirtySince = millis();
+  }
+}
+
+int LoudnessMemoryClass::getCount() {
+  return entries.size();
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+bool LoudnessMemoryClass::load() {
+  if (!SDManager.isInitialized() || !SDManager.exists(SD_LOUDNESS_FILE)) {
+    return false;
+  }
+  
+  // Strings are copied out of the input: room for all of it
+  String data = SDManager.readFile(SD_LOUDNESS_FILE);
+  DynamicJsonDocument doc(JSON_ARRAY_SIZE(LOUDNESS_MEMORY_ENTRIES) +
+                          LOUDNESS_MEMORY_ENTRIES * JSON_OBJECT_SIZE(2) + data.length());
+  if (deserializeJson(doc, data)) {
+    Serial.println("[LOUDNESS] ✗ Failed to parse learned gains");
+    return false;
+  }
+  
+  entries.clear();
+  for (JsonObject obj : doc.as<JsonArray>()) {
+    if (entries.size() >= LOUDNESS_MEMORY_ENTRIES) {
+      break;
+    }
+    
+    LearnedLoudness entry;
+    entry.url = obj["url"].as<String>();
+    entry.gainDb = constrain(obj["gain"] | 0.0f, LOUDNESS_MAX_CUT_DB, LOUDNESS_MAX_BOOST_DB);
+    entry.lastUsed = 0;
+    entries.push_back(entry);
+  }
+  dirty = false;
+  
+  Serial.printf("[LOUDNESS] ✓ Loaded %u learned station gains\n", entries.size());
+  return true;
+}
+
+bool LoudnessMemoryClass::save() {
+  if (!SDManager.isInitialized()) {
+    return false;
+  }
+  
+  // Every URL is copied into the document
+  size_t capacity = JSON_ARRAY_SIZE(entries.size()) + entries.size() * JSON_OBJECT_SIZE(2);
+  for (const auto& entry : entries) {
+    capacity += entry.url.length() + 1;
+  }
+  
+  DynamicJsonDocument doc(capacity);
+  JsonArray array = doc.to<JsonArray>();
+  for (const auto& entry : entries) {
+    JsonObject obj = array.createNestedObject();
+    obj["url"] = entry.url;
+    obj["gain"] = roundf(entry.gainDb * 10.0f) / 10.0f;
+  }
+  dirty = false;
+  
+  // A truncated file would silently forget stations
+  if (doc.overflowed()) {
+    Serial.printf("[LOUDNESS] ✗ Learned gains do not fit %u bytes, not saved\n", capacity);
+    return false;
+  }
+  
+  String data;
+  serializeJson(doc, data);
+  
+  if (!SDManager.writeFile(SD_LOUDNESS_FILE, data)) {
+    Serial.println("[LOUDNESS] ✗ Failed to save learned gains");
+    return false;
+  }
+  return true;
+}
+
+void LoudnessMemoryClass::update() {
+  if (dirty && millis() - dirtySince >= LOUDNESS_SAVE_DELAY) {
+    save();
+  }
+}
@@ -0,0 +1,48 @@
+/**
+ * Loudness Memory for Jam Wysteria
+ *
+ * Remembers the normalization gain learned for each station (keyed
+ * by stream URL) so the next tune-in starts at the right level
+ * instead of converging again. Persisted to SD; a changed table is
+ * written from the UI loop through update(), a few seconds after the
+ * last change.
+ */
+
+#ifndef LOUDNESS_MEMORY_H
+#define LOUDNESS_MEMORY_H
+
+#include <Arduino.h>
+#include <vector>
+#include "config.h"
+
+struct LearnedLoudness {
+  String url;
+  float gainDb;
+  uint32_t lastUsed;
+};
+
+class LoudnessMemoryClass {
+public:
+  LoudnessMemoryClass();
+  
+  // Learned gains (UI loop)
+  bool lookup(const String& url, float& gainDb);
+  void store(const String& url, float gainDb);
+  int getCount();
+  
+  // Persistence (UI loop)
+  bool load();
+  bool save();
+  void update();              // Saves a changed table after a short delay
+  
+private:
+  std::vector<LearnedLoudness> entries;
+  uint32_t useTick;
+  bool dirty;
+  unsigned long dirtySince;
+};
+
+// Global instance
+extern LoudnessMemoryClass LoudnessMemory;
+
+#endif // LOUDNESS_MEMORY_H
@@ -0,0 +1,141 @@
+/**
+ * Loudness Meter for Jam Wysteria
+ *
+ * Running loudness of interleaved 16-bit stereo, roughly EBU R128
+ * short-term: K-weighting (the BS.1770 shelf and high-pass, built
+ * from RBJ biquads) followed by mean square energy summed over both
+ * channels, in blocks of a few hundred ms averaged over a sliding
+ * window of a few seconds.
+ *
+ * The per-sample path is integer only (Q28 filters, 64-bit energy
+ * sums); the logarithm is taken once per block.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef LOUDNESS_METER_H
+#define LOUDNESS_METER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "biquad_eq.h"
+
+#define LOUDNESS_METER_MAX_BLOCKS   64
+#define LOUDNESS_METER_CHUNK        256     // Frames filtered per pass
+#define LOUDNESS_SILENCE_LUFS       -99.0f
+
+class LoudnessMeter {
+public:
+  LoudnessMeter() : blockFrames(0), windowBlocks(1), frameCount(0), blockEnergy(0),
+                    filled(0), next(0), windowEnergy(0), lastBlock(0) {
+    memset(blocks, 0, sizeof(blocks));
+  }
+  
+  // (Re)design for a sample rate; clears the history
+  void configure(uint32_t sampleRate, uint32_t blockMs, int window) {
+    weighting.clear();
+    weighting.add(BIQUAD_HIGH_SHELF, 1681.97f, 4.0f, 0.7072f, (float)sampleRate);
+    weighting.add(BIQUAD_HIGHPASS, 38.14f, 0.0f, 0.5003f, (float)sampleRate);
+    
+    blockFrames = sampleRate * blockMs / 1000;
+    windowBlocks = window < 1 ? 1 : (window > LOUDNESS_METER_MAX_BLOCKS ? LOUDNESS_METER_MAX_BLOCKS : window);
+    reset();
+  }
+  
+  void reset() {
+    weighting.reset();
+    frameCount = 0;
+    blockEnergy = 0;
+    filled = 0;
+    next = 0;
+    windowEnergy = 0;
+    lastBlock = 0;
+    memset(blocks, 0, sizeof(blocks));
+  }
+  
+  // Returns true each time a block completes
+  bool process(const int16_t* samples, size_t frames) {
+    if (blockFrames == 0) {
+      return false;
+    }
+    
+    bool completed = false;
+    while (frames > 0) {
+      size_t count = frames < LOUDNESS_METER_CHUNK ? frames : LOUDNESS_METER_CHUNK;
+      count = count < blockFrames - frameCount ? count : blockFrames - frameCount;
+      
+      // Weighting filters work in place; the audio itself is untouched
+      memcpy(scratch, samples, count * 2 * sizeof(int16_t));
+      weighting.process(scratch, count);
+      
+      uint64_t energy = 0;
+      for (size_t i = 0; i < count * 2; i++) {
+        int32_t s = scratch[i];
+        energy += (uint32_t)(s * s);
+      }
+      blockEnergy += energy;
+      frameCount += count;
+      
+      if (frameCount >= blockFrames) {
+        finishBlock();
+        completed = true;
+      }
+      
+      samples += count * 2;
+      frames -= count;
+    }
+    return completed;
+  }
+  
+  // LUFS of the last completed block
+  float getBlockLoudness() const {
+    return toLufs(lastBlock);
+  }
+  
+  // LUFS over the window (whatever part of it has been measured)
+  float getShortTerm() const {
+    return filled > 0 ? toLufs(windowEnergy / filled) : LOUDNESS_SILENCE_LUFS;
+  }
+  
+private:
+  BiquadChain weighting;
+  int16_t scratch[LOUDNESS_METER_CHUNK * 2];
+  uint32_t blockFrames;
+  int windowBlocks;
+  uint32_t frameCount;
+  uint64_t blockEnergy;
+  uint64_t blocks[LOUDNESS_METER_MAX_BLOCKS];   // Mean square per frame
+  int filled;
+  int next;
+  uint64_t windowEnergy;
+  uint64_t lastBlock;
+  
+  void finishBlock() {
+    uint64_t mean = blockEnergy / frameCount;
+    
+    windowEnergy -= blocks[next];
+    blocks[next] = mean;
+    windowEnergy += mean;
+    next = (next + 1) % windowBlocks;
+    if (filled < windowBlocks) {
+      filled++;
+    }
+    
+    lastBlock = mean;
+    blockEnergy = 0;
+    frameCount = 0;
+  }
+  
+  // Channel energies summed, relative to a full-scale square
+  static float toLufs(uint64_t meanSquare) {
+    if (meanSquare == 0) {
+      return LOUDNESS_SILENCE_LUFS;
+    }
+    float lufs = -0.691f + 10.0f * log10f((float)meanSquare / (32768.0f * 32768.0f));
+    return lufs < LOUDNESS_SILENCE_LUFS ? LOUDNESS_SILENCE_LUFS : lufs;
+  }
+};
+
+#endif // LOUDNESS_METER_H
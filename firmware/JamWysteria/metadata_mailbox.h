@@ -0,0 +1,132 @@
+/**
+ * Metadata Mailbox for Jam Wysteria
+ *
+ * Hands stream metadata from the audio callbacks (fetch and audio
+ * tasks) to the UI loop through a SeqlockMailbox: writers convert the
+ * text outside any critical section, readers never lock. The change
+ * counter lets the UI poll version() and redraw only when something
+ * actually changed; ICY servers repeat the same title every metaint
+ * bytes, and such writes do not advance it.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef METADATA_MAILBOX_H
+#define METADATA_MAILBOX_H
+
+#include <cstdint>
+#include <cstring>
+#include "icy_metadata.h"
+#include "id3_parser.h"
+#include "seqlock_mailbox.h"
+
+#define METADATA_TEXT_MAX 128
+#define METADATA_URL_MAX 256
+#define METADATA_PATH_MAX 32
+
+// Plain-data copy handed to readers
+struct MetadataSnapshot {
+  char title[METADATA_TEXT_MAX];
+  char artist[METADATA_TEXT_MAX];
+  char album[METADATA_TEXT_MAX];
+  char genre[METADATA_TEXT_MAX];
+  char station[METADATA_TEXT_MAX];
+  char url[METADATA_URL_MAX]; // ICY StreamUrl
+  char art[METADATA_PATH_MAX]; // Cached cover picture (SD path)
+  int bitrate;                // bps as reported by the decoder
+  bool available;             // A title or station name has arrived
+};
+
+class MetadataMailbox {
+public:
+  // Writers (any task)
+  void clear() {
+    publish([](MetadataSnapshot& next) {
+      memset(&next, 0, sizeof(next));
+    });
+  }
+  
+  void setStation(const char* name) {
+    publish([name](MetadataSnapshot& next) {
+      copyText(next.station, name);
+      next.available = true;
+    });
+  }
+  
+  void setStreamTitle(const char* artist, const char* title) {
+    publish([artist, title](MetadataSnapshot& next) {
+      copyText(next.artist, artist);
+      copyText(next.title, title);
+      next.available = true;
+    });
+  }
+  
+  // ICY fields as spans into the metadata block: split, normalized to
+  // UTF-8 and copied into the snapshot in one pass (absent = unchanged)
+  void setStreamInfo(IcySpan streamTitle, IcySpan streamURL) {
+    publish([streamTitle, streamURL](MetadataSnapshot& next) {
+      if (streamTitle.found()) {
+        IcySpan artist, title;
+        icySplitTitle(streamTitle, artist, title);
+        copySpan(next.artist, sizeof(next.artist), artist);
+        copySpan(next.title, sizeof(next.title), title);
+        next.available = true;
+      }
+      if (streamURL.found()) {
+        copySpan(next.url, sizeof(next.url), streamURL);
+      }
+    });
+  }
+  
+  // ID3 text frames of a file, one at a time
+  void setTag(Id3Field field, const char* text) {
+    publish([field, text](MetadataSnapshot& next) {
+      char* dest = field == ID3_TITLE ? next.title : field == ID3_ARTIST ? next.artist :
+                   field == ID3_ALBUM ? next.album : next.genre;
+      copyText(dest, text);
+      next.available = true;
+    });
+  }
+  
+  void setAlbumArt(const char* path) {
+    publish([path](MetadataSnapshot& next) {
+      strncpy(next.art, path, sizeof(next.art) - 1);
+    });
+  }
+  
+  void setBitrate(int bitrate) {
+    publish([bitrate](MetadataSnapshot& next) {
+      next.bitrate = bitrate;
+    });
+  }
+  
+  // Readers (never block); both return the change counter
+  uint32_t version() const {
+    return box.version();
+  }
+  
+  uint32_t read(MetadataSnapshot& out) const {
+    return box.read(out);
+  }
+  
+private:
+  SeqlockMailbox<MetadataSnapshot> box;
+  
+  // Fixed-size and zero-padded, so unchanged text compares equal
+  static void copyText(char* dest, const char* text) {
+    strncpy(dest, text != nullptr ? text : "", METADATA_TEXT_MAX - 1);
+    dest[METADATA_TEXT_MAX - 1] = '\0';
+  }
+  
+  static void copySpan(char* dest, size_t size, IcySpan text) {
+    size_t length = icyCopyUtf8(text, dest, size);
+    memset(dest + length, 0, size - length);
+  }
+  
+  template <typename Edit>
+  void publish(Edit edit) {
+    box.publish(edit);
+  }
+};
+
+#endif // METADATA_MAILBOX_H
@@ -0,0 +1,105 @@
+/**
+ * PCM Gain Stage for Jam Wysteria
+ *
+ * Software volume for the output stage. Gain is Q16 fixed point
+ * (65536 = unity) and only attenuates, so samples never clip. A new
+ * target is reached by a linear ramp over a given number of frames
+ * instead of a jump, which is what made volume changes and mute
+ * click. Outside a ramp the samples go through one flat
+ * multiply-shift loop the compiler can unroll.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef PCM_GAIN_H
+#define PCM_GAIN_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define PCM_GAIN_UNITY 65536
+
+class PcmGain {
+public:
+  PcmGain() : gain(PCM_GAIN_UNITY), target(PCM_GAIN_UNITY), step(0), remaining(0) {}
+  
+  // Gain for an attenuation in dB (0 dB = unity)
+  static uint32_t fromDecibels(float db) {
+    if (db >= 0.0f) {
+      return PCM_GAIN_UNITY;
+    }
+    return (uint32_t)(PCM_GAIN_UNITY * powf(10.0f, db / 20.0f) + 0.5f);
+  }
+  
+  // Jump straight to a gain (stream start, after a flush)
+  void reset(uint32_t value) {
+    gain = target = clamp(value);
+    step = 0;
+    remaining = 0;
+  }
+  
+  // Ramp to a gain over the given number of frames (0 = jump)
+  void setTarget(uint32_t value, uint32_t frames) {
+    target = clamp(value);
+    if (frames == 0 || target == (uint32_t)gain) {
+      reset(target);
+      return;
+    }
+    step = ((int32_t)target - gain) / (int32_t)frames;
+    remaining = frames;
+  }
+  
+  uint32_t getTarget() const { return target; }
+  uint32_t getGain() const { return gain; }
+  bool isRamping() const { return remaining > 0; }
+  
+  // Interleaved stereo, in place
+  void process(int16_t* samples, size_t frames) {
+    size_t i = 0;
+    
+    // Ramp: gain moves every frame
+    for (; remaining > 0 && i < frames; i++) {
+      remaining--;
+      gain = remaining > 0 ? gain + step : (int32_t)target;
+      samples[i * 2] = scale(samples[i * 2], gain);
+      samples[i * 2 + 1] = scale(samples[i * 2 + 1], gain);
+    }
+    
+    if (i == frames || gain == PCM_GAIN_UNITY) {
+      return;
+    }
+    
+    int16_t* rest = samples + i * 2;
+    size_t count = (frames - i) * 2;
+    
+    if (gain == 0) {
+      memset(rest, 0, count * sizeof(int16_t));
+      return;
+    }
+    
+    // Steady gain: no branches in the loop body
+    const int32_t g = gain;
+    for (size_t n = 0; n < count; n++) {
+      rest[n] = (int16_t)((rest[n] * g + 0x8000) >> 16);
+    }
+  }
+  
+private:
+  int32_t gain;
+  uint32_t target;
+  int32_t step;
+  uint32_t remaining;
+  
+  static uint32_t clamp(uint32_t value) {
+    return value > PCM_GAIN_UNITY ? PCM_GAIN_UNITY : value;
+  }
+  
+  // |sample * gain| <= 32768 * 65536 fits 32 bits as gain <= unity
+  static int16_t scale(int16_t sample, int32_t g) {
+    return (int16_t)((sample * g + 0x8000) >> 16);
+  }
+};
+
+#endif // PCM_GAIN_H
@@ -0,0 +1,204 @@
+/**
+ * Playlist Parser for Jam Wysteria
+ *
+ * Format detection and entry extraction for .m3u, .pls and .xspf
+ * playlists, and resolution of relative entries against the URL the
+ * playlist came from:
+ *
+ *   http://h/dir/list.m3u + live.mp3   -> http://h/dir/live.mp3
+ *   http://h/dir/list.m3u + /live.mp3  -> http://h/live.mp3
+ *   http://h/dir/list.m3u + //cdn/x    -> http://cdn/x
+ *
+ * PlaylistResolver wraps this with its cache; the parsing itself is
+ * header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef PLAYLIST_PARSER_H
+#define PLAYLIST_PARSER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+enum PlaylistFormat {
+  PLAYLIST_NONE,
+  PLAYLIST_M3U,
+  PLAYLIST_PLS,
+  PLAYLIST_XSPF
+};
+
+inline std::string playlistLower(std::string text) {
+  for (auto& c : text) {
+    if (c >= 'A' && c <= 'Z') {
+      c = c - 'A' + 'a';
+    }
+  }
+  return text;
+}
+
+inline std::string playlistTrim(const std::string& text) {
+  size_t start = text.find_first_not_of(" \t\r\n");
+  if (start == std::string::npos) {
+    return std::string();
+  }
+  size_t end = text.find_last_not_of(" \t\r\n");
+  return text.substr(start, end - start + 1);
+}
+
+inline bool playlistEndsWith(const std::string& text, const char* suffix) {
+  std::string tail(suffix);
+  return text.size() >= tail.size() && text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+// Format from the content type, or from the URL when the server sends
+// something generic
+inline PlaylistFormat detectPlaylistFormat(const std::string& contentType, const std::string& url) {
+  std::string type = playlistLower(contentType);
+  
+  if (type.find("mpegurl") != std::string::npos) {
+    return PLAYLIST_M3U;
+  }
+  if (type.find("scpls") != std::string::npos) {
+    return PLAYLIST_PLS;
+  }
+  if (type.find("xspf") != std::string::npos) {
+    return PLAYLIST_XSPF;
+  }
+  
+  // Many servers send playlists as text/plain or octet-stream
+  if (type.find("audio/") != std::string::npos) {
+    return PLAYLIST_NONE;
+  }
+  
+  std::string path = playlistLower(url.substr(0, url.find('?')));
+  
+  if (playlistEndsWith(path, ".m3u") || playlistEndsWith(path, ".m3u8")) {
+    return PLAYLIST_M3U;
+  }
+  if (playlistEndsWith(path, ".pls")) {
+    return PLAYLIST_PLS;
+  }
+  if (playlistEndsWith(path, ".xspf")) {
+    return PLAYLIST_XSPF;
+  }
+  
+  return PLAYLIST_NONE;
+}
+
+// Absolute http(s) URL for a playlist entry; false if it cannot be one
+inline bool resolvePlaylistEntry(const std::string& baseURL, const std::string& entry,
+                                 std::string& url) {
+  std::string trimmed = playlistTrim(entry);
+  if (trimmed.empty()) {
+    return false;
+  }
+  
+  std::string lower = playlistLower(trimmed);
+  if (lower.compare(0, 7, "http://") == 0 || lower.compare(0, 8, "https://") == 0) {
+    url = trimmed;
+    return true;
+  }
+  if (lower.find("://") != std::string::npos) {
+    return false;               // Another scheme
+  }
+  
+  // Base: scheme, authority, and the path up to any query or fragment
+  size_t schemeEnd = baseURL.find("://");
+  if (schemeEnd == std::string::npos) {
+    return false;
+  }
+  size_t authorityEnd = baseURL.find_first_of("/?#", schemeEnd + 3);
+  if (authorityEnd == std::string::npos) {
+    authorityEnd = baseURL.size();
+  }
+  
+  if (trimmed.compare(0, 2, "//") == 0) {
+    // Protocol-relative: keep only the scheme
+    url = baseURL.substr(0, schemeEnd + 1) + trimmed;
+  } else if (trimmed[0] == '/') {
+    // Root-relative: keep scheme and authority
+    url = baseURL.substr(0, authorityEnd) + trimmed;
+  } else {
+    // Relative: the playlist's directory
+    std::string path = baseURL.substr(authorityEnd);
+    path = path.substr(0, path.find_first_of("?#"));
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "/" : path.substr(0, slash + 1);
+    url = baseURL.substr(0, authorityEnd) + directory + trimmed;
+  }
+  return true;
+}
+
+// Entries of a playlist body, resolved; HLS and unknown formats give none
+inline bool parsePlaylist(PlaylistFormat format, const std::string& baseURL,
+                          const std::string& body, size_t maxLength,
+                          std::vector<std::string>& urls) {
+  urls.clear();
+  
+  auto add = [&](const std::string& entry) {
+    std::string url;
+    if (resolvePlaylistEntry(baseURL, entry, url) && url.size() < maxLength) {
+      urls.push_back(url);
+    }
+  };
+  
+  if (format == PLAYLIST_M3U || format == PLAYLIST_PLS) {
+    // HLS media playlists list segments, not streams; the decoder handles those
+    if (format == PLAYLIST_M3U && body.find("#EXT-X-") != std::string::npos) {
+      return false;
+    }
+    
+    size_t start = 0;
+    while (start < body.size()) {
+      size_t end = body.find('\n', start);
+      if (end == std::string::npos) {
+        end = body.size();
+      }
+      std::string line = playlistTrim(body.substr(start, end - start));
+      
+      if (format == PLAYLIST_M3U) {
+        if (!line.empty() && line[0] != '#') {
+          add(line);
+        }
+      } else {
+        // FileN=<url>
+        size_t equals = line.find('=');
+        if (equals != std::string::npos && equals > 4 && playlistLower(line.substr(0, 4)) == "file") {
+          add(line.substr(equals + 1));
+        }
+      }
+      
+      start = end + 1;
+    }
+  } else if (format == PLAYLIST_XSPF) {
+    size_t start = 0;
+    while (true) {
+      size_t open = body.find("<location>", start);
+      if (open == std::string::npos) {
+        break;
+      }
+      open += 10;
+      
+      size_t close = body.find("</location>", open);
+      if (close == std::string::npos) {
+        break;
+      }
+      
+      // XML escapes the ampersands of a query string
+      std::string location;
+      for (size_t i = open; i < close; i++) {
+        location += body[i];
+        if (body.compare(i, 5, "&amp;") == 0) {
+          i += 4;
+        }
+      }
+      add(location);
+      
+      start = close + 11;
+    }
+  }
+  
+  return !urls.empty();
+}
+
+#endif // PLAYLIST_PARSER_H
@@ -0,0 +1,262 @@
+/**
+ * Playlist Resolution Steps for Jam Wysteria
+ *
+ * Following a station URL through its playlists to the stream, and
+ * the cache of where that led. A cached route is tried first and
+ * dropped if it no longer connects; a chain of playlists is followed
+ * up to a depth limit; routes expire after a TTL. Everything outside
+ * that logic comes through a ResolveIo: the fetch task runs it over
+ * HttpStream and PlaylistResolver, StationProber through its ProbeIo;
+ * on a host, test/test_playlist_resolve.cpp runs it against a
+ * stand-in server with a simulated clock.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef PLAYLIST_RESOLVE_H
+#define PLAYLIST_RESOLVE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "audio_io.h"
+#include "playlist_parser.h"
+
+// ============================================================================
+// Route Cache
+// ============================================================================
+
+struct CachedRoute {
+  std::string playlistURL;
+  std::string streamURL;
+  uint32_t expiresAt;         // Seconds on the owner's clock
+};
+
+// Stream URLs that playlists resolved to, each kept for a TTL. Not
+// locked: PlaylistResolver serializes access and persists it.
+class RouteCache {
+public:
+  RouteCache(size_t capacity, uint32_t ttl) : capacity(capacity), ttl(ttl) {}
+  
+  // Unexpired resolution of `playlistURL`
+  bool lookup(const std::string& playlistURL, uint32_t now, std::string& streamURL) const {
+    for (const auto& entry : entries) {
+      if (entry.playlistURL == playlistURL) {
+        if (now >= entry.expiresAt) {
+          return false;
+        }
+        streamURL = entry.streamURL;
+        return true;
+      }
+    }
+    return false;
+  }
+  
+  // New or refreshed for a full TTL
+  void store(const std::string& playlistURL, const std::string& streamURL, uint32_t now) {
+    keep(playlistURL, streamURL, now + ttl);
+  }
+  
+  // A saved entry with `ttlLeft` seconds to go (never more than the TTL)
+  void restore(const std::string& playlistURL, const std::string& streamURL,
+               uint32_t ttlLeft, uint32_t now) {
+    if (ttlLeft > 0) {
+      keep(playlistURL, streamURL, now + (ttlLeft < ttl ? ttlLeft : ttl));
+    }
+  }
+  
+  // Returns whether there was an entry
+  bool invalidate(const std::string& playlistURL) {
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+      if (it->playlistURL == playlistURL) {
+        entries.erase(it);
+        return true;
+      }
+    }
+    return false;
+  }
+  
+  // Drops expired entries; returns how many
+  size_t expire(uint32_t now) {
+    size_t before = entries.size();
+    for (auto it = entries.begin(); it != entries.end(); ) {
+      it = now >= it->expiresAt ? entries.erase(it) : it + 1;
+    }
+    return before - entries.size();
+  }
+  
+  void clear() { entries.clear(); }
+  size_t size() const { return entries.size(); }
+  const std::vector<CachedRoute>& getEntries() const { return entries; }
+  
+private:
+  std::vector<CachedRoute> entries;
+  size_t capacity;
+  uint32_t ttl;
+  
+  // Full: the entry closest to expiry makes room
+  void keep(const std::string& playlistURL, const std::string& streamURL, uint32_t expiresAt) {
+    for (auto& entry : entries) {
+      if (entry.playlistURL == playlistURL) {
+        entry.streamURL = streamURL;
+        entry.expiresAt = expiresAt;
+        return;
+      }
+    }
+    
+    if (capacity == 0) {
+      return;
+    }
+    if (entries.size() >= capacity) {
+      auto oldest = entries.begin();
+      for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if (it->expiresAt < oldest->expiresAt) {
+          oldest = it;
+        }
+      }
+      entries.erase(oldest);
+    }
+    entries.push_back({playlistURL, streamURL, expiresAt});
+  }
+};
+
+// ============================================================================
+// Resolution
+// ============================================================================
+
+// The connection, the route cache and the clock, as a resolution sees them
+class ResolveIo : public AudioSource {
+public:
+  // Connection, one response at a time
+  virtual bool open(const std::string& url) = 0;
+  virtual std::string contentType() = 0;
+  
+  // Playlist URLs resolved earlier
+  virtual bool lookupRoute(const std::string& url, std::string& target) = 0;
+  virtual void storeRoute(const std::string& url, const std::string& target) = 0;
+  virtual void dropRoute(const std::string& url) = 0;
+  
+  // Milliseconds on any epoch, a sleep that lets other tasks run, and
+  // whether the caller has moved on (a newer tune-in)
+  virtual uint32_t now() = 0;
+  virtual void wait(uint32_t ms) = 0;
+  virtual bool cancelled() = 0;
+};
+
+// Budgets of one resolution (the PLAYLIST_* settings on the device)
+struct ResolveLimits {
+  uint32_t bodyTimeoutMs;     // Wait for a playlist body to start
+  size_t maxPlaylistSize;
+  int maxDepth;               // Playlists pointing at playlists
+  size_t maxURLLength;
+};
+
+enum ResolveOutcome {
+  RESOLVE_STREAM,             // Connected to the stream (the caller closes it)
+  RESOLVE_PLAYLIST,           // A playlist that cannot be followed (HLS, too deep, stalled)
+  RESOLVE_FAILED,             // No connection
+  RESOLVE_CANCELLED
+};
+
+struct ResolveResult {
+  ResolveOutcome outcome;
+  std::string target;         // The stream, or the playlist the chain stopped at
+  int playlists;              // Playlists read on the way
+  bool staleRoute;            // The cached route failed and was dropped
+};
+
+// Playlist body up to the size limit; false if the server stalled
+// before sending anything, or the caller moved on
+inline bool readPlaylistBody(ResolveIo& io, const ResolveLimits& limits, std::string& body) {
+  uint8_t chunk[256];
+  uint32_t start = io.now();
+  
+  // HTTP/1.0: the server closes the connection after the body
+  while (body.size() < limits.maxPlaylistSize) {
+    if (io.cancelled()) {
+      return false;
+    }
+    
+    int received = io.read(chunk, sizeof(chunk));
+    if (received < 0) {
+      return true;
+    }
+    if (received == 0) {
+      if (io.now() - start > limits.bodyTimeoutMs) {
+        return !body.empty();
+      }
+      io.wait(1);
+      continue;
+    }
+    
+    body.append((const char*)chunk, received);
+  }
+  
+  // Cut off at the size limit is still worth parsing
+  return true;
+}
+
+// The cached route if it still connects, else the playlists from the
+// station URL; a new route is stored once it reaches a stream
+inline void resolvePlaylist(ResolveIo& io, const std::string& url, const ResolveLimits& limits,
+                            ResolveResult& result) {
+  result = ResolveResult();
+  result.outcome = RESOLVE_FAILED;
+  
+  std::string target = url;
+  bool cached = io.lookupRoute(url, target);
+  int depth = 0;
+  
+  while (true) {
+    if (io.cancelled()) {
+      result.outcome = RESOLVE_CANCELLED;
+      return;
+    }
+    
+    if (!io.open(target)) {
+      if (cached) {
+        // Stale route: forget it and read the playlist again
+        io.dropRoute(url);
+        result.staleRoute = true;
+        target = url;
+        cached = false;
+        continue;
+      }
+      result.target = target;
+      return;
+    }
+    
+    PlaylistFormat format = detectPlaylistFormat(io.contentType(), target);
+    if (format == PLAYLIST_NONE) {
+      break;
+    }
+    
+    std::string body;
+    bool complete = readPlaylistBody(io, limits, body);
+    io.close();
+    if (io.cancelled()) {
+      result.outcome = RESOLVE_CANCELLED;
+      return;
+    }
+    result.playlists++;
+    
+    std::vector<std::string> urls;
+    if (!complete || depth >= limits.maxDepth ||
+        !parsePlaylist(format, target, body, limits.maxURLLength, urls)) {
+      result.outcome = RESOLVE_PLAYLIST;
+      result.target = target;
+      return;
+    }
+    target = urls[0];
+    depth++;
+  }
+  
+  if (target != url && !cached) {
+    io.storeRoute(url, target);
+  }
+  result.outcome = RESOLVE_STREAM;
+  result.target = target;
+}
+
+#endif // PLAYLIST_RESOLVE_H
@@ -0,0 +1,178 @@
+/**
+ * Playlist Resolver Implementation
+ */
+
+#include "playlist_resolver.h"
+#include "sd_manager.h"
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+
+// Global instance
+PlaylistResolverClass PlaylistResolver;
+
+PlaylistResolverClass::PlaylistResolverClass() :
+  cache(PLAYLIST_CACHE_ENTRIES, PLAYLIST_CACHE_TTL_S),
+  dirty(false),
+  dirtySince(0) {
+  lock = xSemaphoreCreateMutex();
+}
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+PlaylistFormat PlaylistResolverClass::detectFormat(const String& contentType, const String& url) {
+  return detectPlaylistFormat(contentType.c_str(), url.c_str());
+}
+
+// ============================================================================
+// Resolved URL Cache
+// ============================================================================
+
+bool PlaylistResolverClass::lookup(const String& playlistURL, String& streamURL) {
+  std::string target;
+  uint32_t now = uptimeSeconds();
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (cache.expire(now) > 0) {
+    markDirty();
+  }
+  bool found = cache.lookup(playlistURL.c_str(), now, target);
+  xSemaphoreGive(lock);
+  
+  if (found) {
+    streamURL = target.c_str();
+  }
+  return found;
+}
+
+void PlaylistResolverClass::store(const String& playlistURL, const String& streamURL) {
+  uint32_t now = uptimeSeconds();
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  cache.store(playlistURL.c_str(), streamURL.c_str(), now);
+  markDirty();
+  xSemaphoreGive(lock);
+  
+  Serial.printf("[PLAYLIST] Cached %s -> %s\n", playlistURL.c_str(), streamURL.c_str());
+}
+
+void PlaylistResolverClass::invalidate(const String& playlistURL) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  if (cache.invalidate(playlistURL.c_str())) {
+    markDirty();
+  }
+  xSemaphoreGive(lock);
+}
+
+int PlaylistResolverClass::getCount() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  int count = cache.size();
+  xSemaphoreGive(lock);
+  return count;
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+bool PlaylistResolverClass::load() {
+  if (!SDManager.isInitialized() || !SDManager.exists(SD_PLAYLIST_CACHE_FILE)) {
+    return false;
+  }
+  
+  // Strings are copied out of the input: room for all of it
+  String data = SDManager.readFile(SD_PLAYLIST_CACHE_FILE);
+  DynamicJsonDocument doc(JSON_ARRAY_SIZE(PLAYLIST_CACHE_ENTRIES) +
+                          PLAYLIST_CACHE_ENTRIES * JSON_OBJECT_SIZE(3) + data.length());
+  if (deserializeJson(doc, data)) {
+    Serial.println("[PLAYLIST] ✗ Failed to parse resolved URL cache");
+    return false;
+  }
+  
+  // No wall clock: entries keep the TTL they had left when saved
+  uint32_t now = uptimeSeconds();
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  cache.clear();
+  for (JsonObject obj : doc.as<JsonArray>()) {
+    String playlistURL = obj["playlist"] | "";
+    String streamURL = obj["stream"] | "";
+    cache.restore(playlistURL.c_str(), streamURL.c_str(), obj["ttl"] | 0, now);
+  }
+  dirty = false;
+  int count = cache.size();
+  xSemaphoreGive(lock);
+  
+  Serial.printf("[PLAYLIST] ✓ Loaded %d resolved stream URLs\n", count);
+  return true;
+}
+
+bool PlaylistResolverClass::save() {
+  if (!SDManager.isInitialized()) {
+    return false;
+  }
+  
+  uint32_t now = uptimeSeconds();
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  
+  // The document points at the cached URLs: serialized before the
+  // lock is let go
+  const std::vector<CachedRoute>& entries = cache.getEntries();
+  size_t capacity = JSON_ARRAY_SIZE(entries.size()) + entries.size() * JSON_OBJECT_SIZE(3);
+  DynamicJsonDocument doc(capacity);
+  JsonArray array = doc.to<JsonArray>();
+  
+  for (const auto& entry : entries) {
+    if (entry.expiresAt <= now) {
+      continue;
+    }
+    JsonObject obj = array.createNestedObject();
+    obj["playlist"] = entry.playlistURL.c_str();
+    obj["stream"] = entry.streamURL.c_str();
+    obj["ttl"] = entry.expiresAt - now;
+  }
+  
+  String data;
+  bool overflowed = doc.overflowed();
+  if (!overflowed) {
+    serializeJson(doc, data);
+  }
+  dirty = false;
+  xSemaphoreGive(lock);
+  
+  // A truncated cache would silently forget stations
+  if (overflowed) {
+    Serial.printf("[PLAYLIST] ✗ Resolved URL cache does not fit %u bytes, not saved\n", capacity);
+    return false;
+  }
+  
+  if (!SDManager.writeFile(SD_PLAYLIST_CACHE_FILE, data)) {
+    Serial.println("[PLAYLIST] ✗ Failed to save resolved URL cache");
+    return false;
+  }
+  return true;
+}
+
+void PlaylistResolverClass::update() {
+  if (dirty && millis() - dirtySince >= PLAYLIST_CACHE_SAVE_DELAY) {
+    save();
+  }
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+uint32_t PlaylistResolverClass::uptimeSeconds() {
+  // millis() wraps after 49 days; the 64-bit timer does not
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+void PlaylistResolverClass::markDirty() {
+  if (!dirty) {
+    dirty = true;
+    dirtySince = millis();
+  }
+}
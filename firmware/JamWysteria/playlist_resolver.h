@@ -0,0 +1,54 @@
+/**
+ * Playlist Resolver for Jam Wysteria
+ *
+ * Turns .m3u, .pls and .xspf station URLs into the media URL they
+ * point to, and remembers the answer. Resolved URLs are cached per
+ * station with a TTL and persisted to SD, so a later tune-in opens
+ * the stream directly instead of fetching the playlist first.
+ *
+ * The fetch task parses and queries the cache; the SD copy is only
+ * written from the UI loop through update(). Following the playlists
+ * and the cache's expiry rules live in playlist_resolve.h.
+ */
+
+#ifndef PLAYLIST_RESOLVER_H
+#define PLAYLIST_RESOLVER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "playlist_resolve.h"
+#include "config.h"
+
+class PlaylistResolverClass {
+public:
+  PlaylistResolverClass();
+  
+  // Parsing (playlist_parser.h)
+  PlaylistFormat detectFormat(const String& contentType, const String& url);
+  
+  // Resolved URL cache (any task)
+  bool lookup(const String& playlistURL, String& streamURL);
+  void store(const String& playlistURL, const String& streamURL);
+  void invalidate(const String& playlistURL);
+  int getCount();
+  
+  // Persistence (UI loop)
+  bool load();
+  bool save();
+  void update();              // Saves a changed cache after a short delay
+  
+private:
+  RouteCache cache;                   // Clock: seconds of uptime
+  SemaphoreHandle_t lock;
+  bool dirty;
+  unsigned long dirtySince;
+  
+  // Helper functions
+  uint32_t uptimeSeconds();
+  void markDirty();
+};
+
+// Global instance
+extern PlaylistResolverClass PlaylistResolver;
+
+#endif // PLAYLIST_RESOLVER_H
@@ -0,0 +1,196 @@
+/**
+ * Polyphase Resampler for Jam Wysteria
+ *
+ * Converts interleaved 16-bit stereo from the stream's sample rate
+ * to the output rate, and lets the ratio be nudged by a few hundred
+ * ppm so playback can follow a broadcaster whose clock runs apart
+ * from ours. The filter is a Kaiser-windowed sinc cut below the
+ * lower of the two Nyquist frequencies, sampled at a fixed number of
+ * phases per input sample (Q15); the position between two phases is
+ * interpolated linearly, so any ratio is served by the same table.
+ * The read position is Q32 fixed point.
+ *
+ * Input is written into the resampler's own buffer (space(),
+ * inputBuffer(), commit()), which keeps the filter history between
+ * calls; process() produces as many output frames as the buffered
+ * input allows.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#define RESAMPLE_TAPS       24      // Input samples per output sample
+#define RESAMPLE_PHASE_BITS 6       // 64 phases between two input samples
+#define RESAMPLE_PHASES     (1 << RESAMPLE_PHASE_BITS)
+#define RESAMPLE_CHUNK      256     // Input frames buffered per pass
+#define RESAMPLE_CUTOFF     0.91f   // Fraction of the lower Nyquist frequency
+#define RESAMPLE_KAISER_BETA 8.0f
+
+class PolyphaseResampler {
+public:
+  PolyphaseResampler() : inRate(0), outRate(0), adjustPpm(0), step(0),
+                         position(0), filled(0) {
+    memset(buffer, 0, sizeof(buffer));
+  }
+  
+  // Design the filter for a rate pair; clears the history
+  bool configure(uint32_t inputRate, uint32_t outputRate) {
+    if (inputRate == 0 || outputRate == 0) {
+      return false;
+    }
+    inRate = inputRate;
+    outRate = outputRate;
+    
+    // Cutoff in cycles per input sample
+    uint32_t lower = inRate < outRate ? inRate : outRate;
+    double fc = RESAMPLE_CUTOFF * 0.5 * lower / inRate;
+    double half = RESAMPLE_TAPS / 2;
+    double norm = besselI0(RESAMPLE_KAISER_BETA);
+    
+    // Row p serves a read position p / PHASES past the centre tap;
+    // the extra last row is the first one shifted by a whole sample
+    for (int p = 0; p <= RESAMPLE_PHASES; p++) {
+      double row[RESAMPLE_TAPS];
+      double sum = 0;
+      for (int t = 0; t < RESAMPLE_TAPS; t++) {
+        double d = t - (half - 1) - (double)p / RESAMPLE_PHASES;
+        double x = 2.0 * fc * d;
+        double sinc = x == 0 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+        double w = d / half;
+        double window = w <= -1.0 || w >= 1.0 ? 0.0 :
+                        besselI0(RESAMPLE_KAISER_BETA * sqrt(1.0 - w * w)) / norm;
+        row[t] = sinc * window;
+        sum += row[t];
+      }
+      
+      // Unity gain at DC in every phase (no ripple as the phase moves)
+      for (int t = 0; t < RESAMPLE_TAPS; t++) {
+        coeffs[p][t] = (int16_t)lrint(row[t] / sum * 32768.0);
+      }
+    }
+    
+    updateStep();
+    reset();
+    return true;
+  }
+  
+  // Nudge the ratio: positive consumes input faster
+  void setAdjust(int32_t ppm) {
+    if (ppm != adjustPpm) {
+      adjustPpm = ppm;
+      updateStep();
+    }
+  }
+  
+  int32_t getAdjust() const { return adjustPpm; }
+  
+  // Drop history and buffered input (after a flush)
+  void reset() {
+    memset(buffer, 0, sizeof(buffer));
+    position = 0;
+    filled = RESAMPLE_TAPS - 1;     // Silence ahead of the first sample
+  }
+  
+  // Input side: write up to space() frames at inputBuffer(), then commit
+  size_t space() const { return BUFFER_FRAMES - filled; }
+  int16_t* inputBuffer() { return buffer + filled * 2; }
+  void commit(size_t frames) { filled += frames; }
+  
+  // Produce up to `frames` output frames from the buffered input
+  size_t process(int16_t* out, size_t frames) {
+    if (step == 0) {
+      return 0;
+    }
+    
+    size_t produced = 0;
+    uint64_t pos = position;
+    
+    while (produced < frames) {
+      size_t index = (size_t)(pos >> 32);
+      if (index + RESAMPLE_TAPS > filled) {
+        break;
+      }
+      
+      uint32_t frac = (uint32_t)pos;
+      uint32_t phase = frac >> (32 - RESAMPLE_PHASE_BITS);
+      int32_t blend = (frac >> (32 - RESAMPLE_PHASE_BITS - 15)) & 0x7FFF;
+      const int16_t* c0 = coeffs[phase];
+      const int16_t* c1 = coeffs[phase + 1];
+      const int16_t* x = buffer + index * 2;
+      
+      int32_t left = 0;
+      int32_t right = 0;
+      for (int t = 0; t < RESAMPLE_TAPS; t++) {
+        int32_t c = c0[t] + (((c1[t] - c0[t]) * blend) >> 15);
+        left += c * x[t * 2];
+        right += c * x[t * 2 + 1];
+      }
+      
+      out[produced * 2] = saturate((left + 0x4000) >> 15);
+      out[produced * 2 + 1] = saturate((right + 0x4000) >> 15);
+      produced++;
+      pos += step;
+    }
+    
+    // Move the history still needed to the front
+    size_t consumed = (size_t)(pos >> 32);
+    if (consumed > filled) {
+      consumed = filled;
+    }
+    if (consumed > 0) {
+      memmove(buffer, buffer + consumed * 2, (filled - consumed) * 2 * sizeof(int16_t));
+      filled -= consumed;
+      pos -= (uint64_t)consumed << 32;
+    }
+    position = pos;
+    return produced;
+  }
+  
+private:
+  static const size_t BUFFER_FRAMES = RESAMPLE_TAPS + RESAMPLE_CHUNK;
+  
+  int16_t coeffs[RESAMPLE_PHASES + 1][RESAMPLE_TAPS];
+  int16_t buffer[BUFFER_FRAMES * 2];
+  uint32_t inRate;
+  uint32_t outRate;
+  int32_t adjustPpm;
+  uint64_t step;              // Input frames per output frame, Q32
+  uint64_t position;          // Read position in the buffer, Q32
+  size_t filled;              // Frames in the buffer
+  
+  void updateStep() {
+    if (outRate == 0) {
+      step = 0;
+      return;
+    }
+    double ratio = (double)inRate / outRate * (1.0 + adjustPpm * 1e-6);
+    step = (uint64_t)llround(ratio * 4294967296.0);
+  }
+  
+  static int16_t saturate(int32_t value) {
+    return (int16_t)(value > 32767 ? 32767 : (value < -32768 ? -32768 : value));
+  }
+  
+  // Modified Bessel function of the first kind, order 0 (Kaiser window)
+  static double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; k++) {
+      term *= (x / (2 * k)) * (x / (2 * k));
+      sum += term;
+      if (term < sum * 1e-12) {
+        break;
+      }
+    }
+    return sum;
+  }
+};
+
+#endif // POLYPHASE_RESAMPLER_H
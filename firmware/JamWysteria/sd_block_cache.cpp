@@ -0,0 +1,295 @@
+/**
+ * SD Block Cache Implementation
+ */
+
+#include "sd_block_cache.h"
+
+// Original SPI SD driver entry points (sd_diskio.cpp in the SD library)
+DSTATUS ff_sd_initialize(uint8_t pdrv);
+DSTATUS ff_sd_status(uint8_t pdrv);
+DRESULT ff_sd_read(uint8_t pdrv, uint8_t* buffer, DWORD sector, UINT count);
+DRESULT ff_sd_write(uint8_t pdrv, const uint8_t* buffer, DWORD sector, UINT count);
+DRESULT ff_sd_ioctl(uint8_t pdrv, uint8_t cmd, void* buff);
+
+static_assert(SD_BLOCK_CACHE_LINE_SECTORS <= 8, "validMask holds at most 8 sectors per line");
+
+#define LINE_BYTES      (SD_BLOCK_CACHE_LINE_SECTORS * SD_BLOCK_SIZE)
+#define LINE_FULL_MASK  ((uint8_t)((1u << SD_BLOCK_CACHE_LINE_SECTORS) - 1))
+
+// Global instance
+SDBlockCacheClass SDBlockCache;
+
+// ============================================================================
+// diskio Trampolines
+// ============================================================================
+
+static DSTATUS cachedInitialize(unsigned char pdrv) {
+  SDBlockCache.invalidate();
+  return ff_sd_initialize(pdrv);
+}
+
+static DSTATUS cachedStatus(unsigned char pdrv) {
+  return SDBlockCache.diskStatus(pdrv);
+}
+
+static DRESULT cachedRead(unsigned char pdrv, unsigned char* buffer, uint32_t sector, unsigned count) {
+  return SDBlockCache.diskRead(pdrv, buffer, sector, count);
+}
+
+static DRESULT cachedWrite(unsigned char pdrv, const unsigned char* buffer, uint32_t sector, unsigned count) {
+  return SDBlockCache.diskWrite(pdrv, buffer, sector, count);
+}
+
+static DRESULT cachedIoctl(unsigned char pdrv, unsigned char cmd, void* buffer) {
+  return SDBlockCache.diskIoctl(pdrv, cmd, buffer);
+}
+
+static const ff_diskio_impl_t cachedDiskio = {
+  .init = &cachedInitialize,
+  .status = &cachedStatus,
+  .read = &cachedRead,
+  .write = &cachedWrite,
+  .ioctl = &cachedIoctl
+};
+
+// ============================================================================
+// Public Interface
+// ============================================================================
+
+SDBlockCacheClass::SDBlockCacheClass() :
+  drive(0xFF),
+  enabled(false),
+  lines(nullptr),
+  storage(nullptr),
+  lineCount(0),
+  useTick(0),
+  nextSequentialSector(0),
+  sequentialRun(0) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool SDBlockCacheClass::init(uint8_t pdrv, size_t budget) {
+  lineCount = budget / LINE_BYTES;
+  if (lineCount == 0) {
+    Serial.println("[SD] Block cache disabled");
+    return false;
+  }
+  
+  storage = (uint8_t*)heap_caps_malloc(lineCount * LINE_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  lines = (CacheLine*)calloc(lineCount, sizeof(CacheLine));
+  
+  if (storage == nullptr || lines == nullptr) {
+    Serial.printf("[SD] ✗ No PSRAM for %u KB block cache, running uncached\n", budget / 1024);
+    heap_caps_free(storage);
+    free(lines);
+    storage = nullptr;
+    lines = nullptr;
+    lineCount = 0;
+    return false;
+  }
+  
+  for (int i = 0; i < lineCount; i++) {
+    lines[i].data = storage + i * LINE_BYTES;
+  }
+  
+  drive = pdrv;
+  stats.capacity = lineCount * LINE_BYTES;
+  invalidate();
+  
+  // Route FATFS through the cache from here on
+  ff_diskio_register(drive, &cachedDiskio);
+  enabled = true;
+  
+  Serial.printf("[SD] ✓ Block cache: %u KB in PSRAM (%d lines of %d sectors)\n",
+                stats.capacity / 1024, lineCount, SD_BLOCK_CACHE_LINE_SECTORS);
+  return true;
+}
+
+bool SDBlockCacheClass::isEnabled() {
+  return enabled;
+}
+
+void SDBlockCacheClass::invalidate() {
+  for (int i = 0; i < lineCount; i++) {
+    lines[i].validMask = 0;
+    lines[i].lastUsed = 0;
+  }
+  nextSequentialSector = 0;
+  sequentialRun = 0;
+}
+
+SDBlockCacheStats SDBlockCacheClass::getStats() {
+  return stats;
+}
+
+void SDBlockCacheClass::resetStats() {
+  size_t capacity = stats.capacity;
+  memset(&stats, 0, sizeof(stats));
+  stats.capacity = capacity;
+}
+
+// ============================================================================
+// diskio Implementation
+// ============================================================================
+
+DSTATUS SDBlockCacheClass::diskStatus(uint8_t pdrv) {
+  return ff_sd_status(pdrv);
+}
+
+DRESULT SDBlockCacheClass::diskRead(uint8_t pdrv, uint8_t* buffer, uint32_t sector, unsigned count) {
+  if (!enabled || pdrv != drive) {
+    return ff_sd_read(pdrv, buffer, sector, count);
+  }
+  
+  bool sequential = (sector == nextSequentialSector);
+  sequentialRun = sequential ? sequentialRun + 1 : 0;
+  nextSequentialSector = sector + count;
+  
+  // Large transfers go straight to the card as one multi-block read;
+  // the cache is write-through so it can never hold newer data
+  if (count >= SD_BLOCK_CACHE_BYPASS_SECTORS) {
+    stats.bypassed += count;
+    return ff_sd_read(pdrv, buffer, sector, count);
+  }
+  
+  uint32_t lastTag = 0;
+  
+  for (unsigned i = 0; i < count; i++) {
+    uint32_t s = sector + i;
+    uint32_t tag = s / SD_BLOCK_CACHE_LINE_SECTORS;
+    uint8_t bit = 1u << (s % SD_BLOCK_CACHE_LINE_SECTORS);
+    uint8_t* out = buffer + i * SD_BLOCK_SIZE;
+    lastTag = tag;
+    
+    CacheLine* line = findLine(tag);
+    if (line != nullptr && (line->validMask & bit)) {
+      memcpy(out, line->data + (s % SD_BLOCK_CACHE_LINE_SECTORS) * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+      line->lastUsed = ++useTick;
+      stats.hits++;
+      continue;
+    }
+    
+    stats.misses++;
+    
+    if (line == nullptr) {
+      line = allocateLine(tag);
+    }
+    
+    // Sequential streams fill the whole line; random access only the sector
+    if (sequentialRun > 0) {
+      if (!fillLine(line)) {
+        return RES_ERROR;
+      }
+    } else {
+      uint8_t* slot = line->data + (s % SD_BLOCK_CACHE_LINE_SECTORS) * SD_BLOCK_SIZE;
+      if (ff_sd_read(pdrv, slot, s, 1) != RES_OK) {
+        return RES_ERROR;
+      }
+      line->validMask |= bit;
+    }
+    
+    memcpy(out, line->data + (s % SD_BLOCK_CACHE_LINE_SECTORS) * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+  }
+  
+  if (sequentialRun > 0) {
+    readAhead(lastTag + 1);
+  }
+  
+  return RES_OK;
+}
+
+DRESULT SDBlockCacheClass::diskWrite(uint8_t pdrv, const uint8_t* buffer, uint32_t sector, unsigned count) {
+  if (!enabled || pdrv != drive) {
+    return ff_sd_write(pdrv, buffer, sector, count);
+  }
+  
+  DRESULT result = ff_sd_write(pdrv, buffer, sector, count);
+  stats.writes += count;
+  
+  // Keep cached copies identical to the card
+  for (unsigned i = 0; i < count; i++) {
+    uint32_t s = sector + i;
+    CacheLine* line = findLine(s / SD_BLOCK_CACHE_LINE_SECTORS);
+    if (line == nullptr) {
+      continue;
+    }
+    
+    uint8_t bit = 1u << (s % SD_BLOCK_CACHE_LINE_SECTORS);
+    if (result == RES_OK) {
+      memcpy(line->data + (s % SD_BLOCK_CACHE_LINE_SECTORS) * SD_BLOCK_SIZE,
+             buffer + i * SD_BLOCK_SIZE, SD_BLOCK_SIZE);
+      line->validMask |= bit;
+    } else {
+      line->validMask &= ~bit;
+    }
+  }
+  
+  return result;
+}
+
+DRESULT SDBlockCacheClass::diskIoctl(uint8_t pdrv, uint8_t cmd, void* buffer) {
+  // Write-through: nothing to flush beyond what the driver does
+  return ff_sd_ioctl(pdrv, cmd, buffer);
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+SDBlockCacheClass::CacheLine* SDBlockCacheClass::findLine(uint32_t tag) {
+  for (int i = 0; i < lineCount; i++) {
+    if (lines[i].validMask != 0 && lines[i].tag == tag) {
+      return &lines[i];
+    }
+  }
+  return nullptr;
+}
+
+SDBlockCacheClass::CacheLine* SDBlockCacheClass::allocateLine(uint32_t tag) {
+  CacheLine* victim = &lines[0];
+  for (int i = 0; i < lineCount; i++) {
+    if (lines[i].validMask == 0) {
+      victim = &lines[i];
+      break;
+    }
+    if (lines[i].lastUsed < victim->lastUsed) {
+      victim = &lines[i];
+    }
+  }
+  
+  victim->tag = tag;
+  victim->validMask = 0;
+  victim->lastUsed = ++useTick;
+  return victim;
+}
+
+bool SDBlockCacheClass::fillLine(CacheLine* line) {
+  uint32_t first = line->tag * SD_BLOCK_CACHE_LINE_SECTORS;
+  if (ff_sd_read(drive, line->data, first, SD_BLOCK_CACHE_LINE_SECTORS) != RES_OK) {
+    line->validMask = 0;
+    return false;
+  }
+  
+  line->validMask = LINE_FULL_MASK;
+  line->lastUsed = ++useTick;
+  return true;
+}
+
+void SDBlockCacheClass::readAhead(uint32_t tag) {
+  for (int i = 0; i < SD_BLOCK_CACHE_READAHEAD; i++) {
+    CacheLine* line = findLine(tag + i);
+    if (line != nullptr && line->validMask == LINE_FULL_MASK) {
+      continue;
+    }
+    
+    if (line == nullptr) {
+      line = allocateLine(tag + i);
+    }
+    
+    // Past the end of the card (or a read error): stop prefetching
+    if (!fillLine(line)) {
+      return;
+    }
+    stats.readAheads++;
+  }
+}
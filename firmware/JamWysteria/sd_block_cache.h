@@ -0,0 +1,79 @@
+/**
+ * SD Block Cache for Jam Wysteria
+ *
+ * LRU cache of SD sectors held in PSRAM, inserted underneath FATFS
+ * by re-registering the card's diskio driver. Reads are served from
+ * the cache when possible; sequential access triggers read-ahead.
+ * Writes go straight through to the card and refresh cached copies.
+ */
+
+#ifndef SD_BLOCK_CACHE_H
+#define SD_BLOCK_CACHE_H
+
+#include <Arduino.h>
+#include "diskio_impl.h"
+#include "config.h"
+
+// Cache counters
+struct SDBlockCacheStats {
+  uint32_t hits;          // Sectors served from cache
+  uint32_t misses;        // Sectors read from the card on demand
+  uint32_t readAheads;    // Lines prefetched by sequential detection
+  uint32_t bypassed;      // Sectors read uncached (large transfers)
+  uint32_t writes;        // Sectors written through
+  size_t capacity;        // Cache size in bytes (0 = disabled)
+};
+
+class SDBlockCacheClass {
+public:
+  SDBlockCacheClass();
+  
+  // Initialization (call after SD.begin() with the card's drive number)
+  bool init(uint8_t pdrv, size_t budget = SD_BLOCK_CACHE_SIZE);
+  bool isEnabled();
+  void invalidate();
+  
+  // Statistics
+  SDBlockCacheStats getStats();
+  void resetStats();
+  
+  // diskio entry points (called by FATFS)
+  DSTATUS diskStatus(uint8_t pdrv);
+  DRESULT diskRead(uint8_t pdrv, uint8_t* buffer, uint32_t sector, unsigned count);
+  DRESULT diskWrite(uint8_t pdrv, const uint8_t* buffer, uint32_t sector, unsigned count);
+  DRESULT diskIoctl(uint8_t pdrv, uint8_t cmd, void* buffer);
+  
+private:
+  struct CacheLine {
+    uint32_t tag;         // First sector / SD_BLOCK_CACHE_LINE_SECTORS
+    uint32_t lastUsed;
+    uint8_t validMask;    // One bit per sector in the line
+    uint8_t* data;
+  };
+  
+  uint8_t drive;
+  bool enabled;
+  
+  // Storage
+  CacheLine* lines;
+  uint8_t* storage;
+  int lineCount;
+  uint32_t useTick;
+  
+  // Sequential detection
+  uint32_t nextSequentialSector;
+  int sequentialRun;
+  
+  SDBlockCacheStats stats;
+  
+  // Helper functions
+  CacheLine* findLine(uint32_t tag);
+  CacheLine* allocateLine(uint32_t tag);
+  bool fillLine(CacheLine* line);
+  void readAhead(uint32_t tag);
+};
+
+// Global instance
+extern SDBlockCacheClass SDBlockCache;
+
+#endif // SD_BLOCK_CACHE_H
@@ -3,12 +3,20 @@
  */
 
 #include "sd_manager.h"
+#include "sd_block_cache.h"
+#include "config_store.h"
 #include <ArduinoJson.h>
 
 // Global instance
 SDManagerClass SDManager;
 
-SDManagerClass::SDManagerClass() : initialized(false) {
+SDManagerClass::SDManagerClass() : initialized(false), pathCacheTick(0) {
+  pathCacheLock = xSemaphoreCreateMutex();
+  for (int i = 0; i < SD_PATH_CACHE_SIZE; i++) {
+    pathCache[i].exists = false;
+    pathCache[i].lastUsed = 0;
+  }
+  
   // Initialize config with defaults
   config.wifiSSID = "";
   config.wifiPassword = "";
@@ -17,11 +25,19 @@ SDManagerClass::SDManagerClass() : initialized(false) {
   config.lastStation = "";
   config.autoConnect = true;
   config.screenTimeout = 0; // 0 = never timeout
+  config.bufferProfile = BUFFER_PROFILE_DEFAULT;
+  config.eqBass = 0;
+  config.eqMid = 0;
+  config.eqTreble = 0;
 }
 
 bool SDManagerClass::init() {
   Serial.println("[SD] Initializing SD card...");
   
+  // SD.begin() takes the first free FATFS drive; note it for the block cache
+  BYTE pdrv = 0xFF;
+  ff_diskio_get_drive(&pdrv);
+  
   // Initialize SD card
   if (!SD.begin(SD_CS)) {
     Serial.println("[SD] ✗ SD card initialization failed");
@@ -55,6 +71,9 @@ bool SDManagerClass::init() {
   Serial.printf("[SD] Used: %lluMB\n", getUsedBytes() / (1024 * 1024));
   Serial.printf("[SD] Free: %lluMB\n", getFreeBytes() / (1024 * 1024));
   
+  // Serve FAT reads from PSRAM where possible
+  SDBlockCache.init(pdrv, SD_BLOCK_CACHE_SIZE);
+  
   // Create default directories
   createDir("/config");
   createDir("/logos");
@@ -71,34 +90,62 @@ bool SDManagerClass::isInitialized() {
 }
 
 bool SDManagerClass::exists(const String& path) {
-  return SD.exists(path.c_str());
+  bool cached;
+  if (lookupPath(path, cached) >= 0) {
+    return cached;
+  }
+  
+  bool found = SD.exists(path.c_str());
+  cachePath(path, found);
+  return found;
 }
 
 bool SDManagerClass::createDir(const String& path) {
-  if (exists(path)) {
+  if (path.length() == 0 || path == "/" || isKnownDir(path)) {
     return true;
   }
   
-  return SD.mkdir(path.c_str());
+  // Parents first, each one memoized on the way down
+  String parentPath = getParentPath(path);
+  if (parentPath.length() > 0 && !createDir(parentPath)) {
+    return false;
+  }
+  
+  if (!exists(path)) {
+    if (!SD.mkdir(path.c_str())) {
+      Serial.printf("[SD] Failed to create directory: %s\n", path.c_str());
+      return false;
+    }
+    cachePath(path, true);
+  }
+  
+  rememberDir(path);
+  return true;
 }
 
 bool SDManagerClass::remove(const String& path) {
-  return SD.remove(path.c_str());
+  bool success = SD.remove(path.c_str());
+  if (success) {
+    cachePath(path, false);
+  }
+  return success;
 }
 
 bool SDManagerClass::rename(const String& oldPath, const String& newPath) {
-  return SD.rename(oldPath.c_str(), newPath.c_str());
+  bool success = SD.rename(oldPath.c_str(), newPath.c_str());
+  if (success) {
+    // Anything cached below a renamed directory is stale
+    invalidateTree(oldPath);
+    cachePath(oldPath, false);
+    cachePath(newPath, true);
+  }
+  return success;
 }
 
 String SDManagerClass::readFile(const String& path) {
-  if (!exists(path)) {
-    Serial.printf("[SD] File not found: %s\n", path.c_str());
-    return "";
-  }
-  
-  File file = SD.open(path.c_str(), FILE_READ);
+  File file = openForRead(path);
   if (!file) {
-    Serial.printf("[SD] Failed to open file: %s\n", path.c_str());
+    Serial.printf("[SD] File not found: %s\n", path.c_str());
     return "";
   }
   
@@ -112,11 +159,7 @@ String SDManagerClass::readFile(const String& path) {
 }
 
 bool SDManagerClass::readFile(const String& path, uint8_t* buffer, size_t length) {
-  if (!exists(path)) {
-    return false;
-  }
-  
-  File file = SD.open(path.c_str(), FILE_READ);
+  File file = openForRead(path);
   if (!file) {
     return false;
   }
@@ -128,11 +171,7 @@ bool SDManagerClass::readFile(const String& path, uint8_t* buffer, size_t length
 }
 
 size_t SDManagerClass::getFileSize(const String& path) {
-  if (!exists(path)) {
-    return 0;
-  }
-  
-  File file = SD.open(path.c_str(), FILE_READ);
+  File file = openForRead(path);
   if (!file) {
     return 0;
   }
@@ -152,6 +191,7 @@ bool SDManagerClass::writeFile(const String& path, const String& content) {
     Serial.printf("[SD] Failed to create file: %s\n", path.c_str());
     return false;
   }
+  cachePath(path, true);
   
   size_t written = file.print(content);
   file.close();
@@ -167,6 +207,7 @@ bool SDManagerClass::writeFile(const String& path, const uint8_t* data, size_t l
   if (!file) {
     return false;
   }
+  cachePath(path, true);
   
   size_t written = file.write(data, length);
   file.close();
@@ -179,6 +220,7 @@ bool SDManagerClass::appendFile(const String& path, const String& content) {
   if (!file) {
     return false;
   }
+  cachePath(path, true);
   
   size_t written = file.print(content);
   file.close();
@@ -186,13 +228,29 @@ bool SDManagerClass::appendFile(const String& path, const String& content) {
   return written == content.length();
 }
 
+bool SDManagerClass::loadCachedConfig() {
+  // Flash copy is readable before the card is mounted
+  return ConfigStore.load(config);
+}
+
 bool SDManagerClass::loadConfig() {
+  if (!initialized) {
+    Serial.println("[SD] No card, using configuration from flash");
+    return false;
+  }
+  
   Serial.println("[SD] Loading configuration...");
   
   String configData = readFile(SD_CONFIG_FILE);
   
   if (configData.length() == 0) {
-    Serial.println("[SD] No configuration file found, using defaults");
+    if (ConfigStore.hasRecord()) {
+      // Recreate the editable file from the flash copy
+      Serial.println("[SD] No configuration file found, restoring from flash");
+      saveConfig();
+    } else {
+      Serial.println("[SD] No configuration file found, using defaults");
+    }
     return false;
   }
   
@@ -213,6 +271,13 @@ bool SDManagerClass::loadConfig() {
   config.lastStation = doc["last_station"] | "";
   config.autoConnect = doc["auto_connect"] | true;
   config.screenTimeout = doc["screen_timeout"] | 0;
+  config.bufferProfile = doc["buffer_profile"] | BUFFER_PROFILE_DEFAULT;
+  config.eqBass = constrain(doc["eq_bass"] | 0, EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+  config.eqMid = constrain(doc["eq_mid"] | 0, EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+  config.eqTreble = constrain(doc["eq_treble"] | 0, EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+  
+  // Pick up hand edits made on the card
+  ConfigStore.save(config);
   
   Serial.println("[SD] ✓ Configuration loaded");
   return true;
@@ -221,6 +286,14 @@ bool SDManagerClass::loadConfig() {
 bool SDManagerClass::saveConfig() {
   Serial.println("[SD] Saving configuration...");
   
+  // Flash copy is what the next boot reads first
+  bool stored = ConfigStore.save(config);
+  
+  if (!initialized) {
+    Serial.println("[SD] No card, configuration saved to flash only");
+    return stored;
+  }
+  
   // Create JSON document
   DynamicJsonDocument doc(1024);
   
@@ -231,6 +304,10 @@ bool SDManagerClass::saveConfig() {
   doc["last_station"] = config.lastStation;
   doc["auto_connect"] = config.autoConnect;
   doc["screen_timeout"] = config.screenTimeout;
+  doc["buffer_profile"] = config.bufferProfile;
+  doc["eq_bass"] = config.eqBass;
+  doc["eq_mid"] = config.eqMid;
+  doc["eq_treble"] = config.eqTreble;
   
   // Serialize to string
   String configData;
@@ -288,24 +365,36 @@ uint64_t SDManagerClass::getFreeBytes() {
 std::vector<String> SDManagerClass::listDir(const String& path) {
   std::vector<String> files;
   
+  SDDirIterator dir = openDir(path);
+  String name;
+  while (dir.next(name)) {
+    files.push_back(name);
+  }
+  
+  return files;
+}
+
+SDDirIterator SDManagerClass::openDir(const String& path, const String& filter) {
   File dir = SD.open(path.c_str());
   if (!dir || !dir.isDirectory()) {
-    return files;
+    return SDDirIterator();
   }
   
-  File file = dir.openNextFile();
-  while (file) {
-    files.push_back(String(file.name()));
-    file = dir.openNextFile();
+  cachePath(path, true);
+  return SDDirIterator(dir, filter);
+}
+
+void SDManagerClass::notifyPathChanged(const String& path, bool exists) {
+  if (!exists) {
+    invalidateTree(path);
   }
-  
-  return files;
+  cachePath(path, exists);
 }
 
 bool SDManagerClass::ensurePathExists(const String& path) {
   String parentPath = getParentPath(path);
   
-  if (parentPath.length() > 0 && !exists(parentPath)) {
+  if (parentPath.length() > 0) {
     return createDir(parentPath);
   }
   
@@ -319,3 +408,174 @@ String SDManagerClass::getParentPath(const String& path) {
   }
   return "";
 }
+
+// ============================================================================
+// Path Cache
+// ============================================================================
+
+File SDManagerClass::openForRead(const String& path) {
+  // Known-missing paths never touch the card; otherwise the open
+  // itself is the existence check
+  bool cached;
+  if (lookupPath(path, cached) >= 0 && !cached) {
+    return File();
+  }
+  
+  File file = SD.open(path.c_str(), FILE_READ);
+  cachePath(path, (bool)file);
+  return file;
+}
+
+int SDManagerClass::lookupPath(const String& path, bool& exists) {
+  int found = -1;
+  
+  xSemaphoreTake(pathCacheLock, portMAX_DELAY);
+  for (int i = 0; i < SD_PATH_CACHE_SIZE; i++) {
+    if (pathCache[i].lastUsed != 0 && pathCache[i].path == path) {
+      pathCache[i].lastUsed = ++pathCacheTick;
+      exists = pathCache[i].exists;
+      found = i;
+      break;
+    }
+  }
+  xSemaphoreGive(pathCacheLock);
+  
+  return found;
+}
+
+void SDManagerClass::cachePath(const String& path, bool exists) {
+  xSemaphoreTake(pathCacheLock, portMAX_DELAY);
+  
+  // Reuse the existing slot, otherwise evict the least recently used
+  int slot = 0;
+  for (int i = 0; i < SD_PATH_CACHE_SIZE; i++) {
+    if (pathCache[i].lastUsed != 0 && pathCache[i].path == path) {
+      slot = i;
+      break;
+    }
+    if (pathCache[i].lastUsed < pathCache[slot].lastUsed) {
+      slot = i;
+    }
+  }
+  
+  pathCache[slot].path = path;
+  pathCache[slot].exists = exists;
+  pathCache[slot].lastUsed = ++pathCacheTick;
+  
+  xSemaphoreGive(pathCacheLock);
+}
+
+void SDManagerClass::invalidateTree(const String& path) {
+  String prefix = path.endsWith("/") ? path : path + "/";
+  
+  xSemaphoreTake(pathCacheLock, portMAX_DELAY);
+  for (int i = 0; i < SD_PATH_CACHE_SIZE; i++) {
+    if (pathCache[i].lastUsed != 0 && pathCache[i].path.startsWith(prefix)) {
+      pathCache[i].path = "";
+      pathCache[i].lastUsed = 0;
+    }
+  }
+  
+  knownDirs.erase(path);
+  auto it = knownDirs.lower_bound(prefix);
+  while (it != knownDirs.end() && it->startsWith(prefix)) {
+    it = knownDirs.erase(it);
+  }
+  xSemaphoreGive(pathCacheLock);
+}
+
+bool SDManagerClass::isKnownDir(const String& path) {
+  xSemaphoreTake(pathCacheLock, portMAX_DELAY);
+  bool known = knownDirs.count(path) > 0;
+  xSemaphoreGive(pathCacheLock);
+  
+  return known;
+}
+
+void SDManagerClass::rememberDir(const String& path) {
+  xSemaphoreTake(pathCacheLock, portMAX_DELAY);
+  knownDirs.insert(path);
+  xSemaphoreGive(pathCacheLock);
+}
+
+// ============================================================================
+// Directory Iterator
+// ============================================================================
+
+SDDirIterator::SDDirIterator() : filter("") {
+}
+
+SDDirIterator::SDDirIterator(File directory, const String& nameFilter) :
+  dir(directory),
+  filter(nameFilter) {
+  filter.toLowerCase();
+}
+
+bool SDDirIterator::next(String& name, bool& isDirectory) {
+  if (!dir) {
+    return false;
+  }
+  
+  while (true) {
+    // Reads the directory entry only; no File is opened per entry
+    String entry = dir.getNextFileName(&isDirectory);
+    if (entry.length() == 0) {
+      close();
+      return false;
+    }
+    
+    int lastSlash = entry.lastIndexOf('/');
+    name = lastSlash >= 0 ? entry.substring(lastSlash + 1) : entry;
+    
+    if (matches(name)) {
+      return true;
+    }
+  }
+}
+
+bool SDDirIterator::next(String& name) {
+  bool isDirectory;
+  return next(name, isDirectory);
+}
+
+void SDDirIterator::close() {
+  if (dir) {
+    dir.close();
+  }
+}
+
+bool SDDirIterator::isOpen() {
+  return (bool)dir;
+}
+
+bool SDDirIterator::matches(const String& name) {
+  if (filter.length() == 0) {
+    return true;
+  }
+  
+  String lowerName = name;
+  lowerName.toLowerCase();
+  
+  if (!filter.startsWith(".")) {
+    return lowerName.indexOf(filter) >= 0;
+  }
+  
+  // Extension list
+  int start = 0;
+  while (start < (int)filter.length()) {
+    int comma = filter.indexOf(',', start);
+    if (comma < 0) {
+      comma = filter.length();
+    }
+    
+    String ext = filter.substring(start, comma);
+    ext.trim();
+    if (ext.length() > 0 && lowerName.endsWith(ext)) {
+      return true;
+    }
+    
+    start = comma + 1;
+  }
+  
+  return false;
+}
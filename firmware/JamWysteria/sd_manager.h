@@ -10,8 +10,43 @@
 
 #include <SD.h>
 #include <FS.h>
+#include <vector>
+#include <set>
 #include "config.h"
 
+/**
+ * Streaming directory iterator
+ * 
+ * Walks a directory one entry at a time without materializing
+ * the listing. Filter is either a comma-separated extension list
+ * (".mp3,.aac") or a case-insensitive name substring ("logo").
+ */
+class SDDirIterator {
+public:
+  SDDirIterator();
+  SDDirIterator(File dir, const String& filter);
+  
+  // Advance to the next matching entry (name without path)
+  bool next(String& name, bool& isDirectory);
+  bool next(String& name);
+  
+  void close();
+  bool isOpen();
+  
+private:
+  File dir;
+  String filter;
+  
+  bool matches(const String& name);
+};
+
+// Recently seen path (exists() cache)
+struct SDPathCacheEntry {
+  String path;
+  bool exists;
+  uint32_t lastUsed;
+};
+
 class SDManagerClass {
 public:
   SDManagerClass();
@@ -22,7 +57,7 @@ public:
   
   // File operations
   bool exists(const String& path);
-  bool createDir(const String& path);
+  bool createDir(const String& path);   // Creates missing parents too
   bool remove(const String& path);
   bool rename(const String& oldPath, const String& newPath);
   
@@ -37,6 +72,7 @@ public:
   bool appendFile(const String& path, const String& content);
   
   // Configuration
+  bool loadCachedConfig();              // From flash (NVS), before init()
   bool loadConfig();
   bool saveConfig();
   AppConfig& getConfig();
@@ -57,11 +93,30 @@ public:
   
   // List directory
   std::vector<String> listDir(const String& path);
+  SDDirIterator openDir(const String& path, const String& filter = "");
+  
+  // Path cache (for files created or removed outside SDManager)
+  void notifyPathChanged(const String& path, bool exists);
   
 private:
   bool initialized;
   AppConfig config;
   
+  // Recently seen paths, kept current by our own creates/deletes/renames
+  SDPathCacheEntry pathCache[SD_PATH_CACHE_SIZE];
+  uint32_t pathCacheTick;
+  SemaphoreHandle_t pathCacheLock;
+  
+  // Directories known to exist this session (skips mkdir lookups)
+  std::set<String> knownDirs;
+  
+  File openForRead(const String& path);
+  int lookupPath(const String& path, bool& exists);
+  void cachePath(const String& path, bool exists);
+  void invalidateTree(const String& path);
+  bool isKnownDir(const String& path);
+  void rememberDir(const String& path);
+  
   // Helper functions
   bool ensurePathExists(const String& path);
   String getParentPath(const String& path);
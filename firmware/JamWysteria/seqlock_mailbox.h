@@ -0,0 +1,103 @@
+/**
+ * Seqlock Mailbox for Jam Wysteria
+ *
+ * Hands one plain-data value from writers on any task to readers on
+ * either core. Writers are serialized by a mutex and build the next
+ * value in a scratch copy outside any critical section; only the
+ * sequence bump and the final copy run with interrupts masked.
+ * Readers never lock, they copy the value and retry if a write
+ * overlapped the copy. The sequence doubles as a change counter;
+ * writes that change nothing do not advance it.
+ *
+ * MetadataMailbox carries the stream metadata in one; AudioPlayer
+ * publishes the outcome of each play command through another.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef SEQLOCK_MAILBOX_H
+#define SEQLOCK_MAILBOX_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+#ifdef ESP_PLATFORM
+#include <freertos/FreeRTOS.h>
+#endif
+
+template <typename T>
+class SeqlockMailbox {
+  static_assert(std::is_trivially_copyable<T>::value, "mailbox values are copied bytewise");
+  
+public:
+  SeqlockMailbox() : sequence(0) {
+    memset(&data, 0, sizeof(data));
+    memset(&scratch, 0, sizeof(scratch));
+  }
+  
+  // Change counter (never blocks)
+  uint32_t version() const {
+    return sequence.load(std::memory_order_acquire) >> 1;
+  }
+  
+  // Copy of the current value (never blocks); returns the change counter
+  uint32_t read(T& out) const {
+    while (true) {
+      uint32_t before = sequence.load(std::memory_order_acquire);
+      if (before & 1) {
+        continue;                 // Write in progress on the other core
+      }
+      
+      memcpy(&out, &data, sizeof(out));
+      std::atomic_thread_fence(std::memory_order_acquire);
+      
+      if (sequence.load(std::memory_order_relaxed) == before) {
+        return before >> 1;
+      }
+    }
+  }
+  
+  // `edit` changes a copy of the current value; it is published unless
+  // nothing changed. Edits see every earlier write, so they can decide
+  // from the current value (whose session it is, say).
+  template <typename Edit>
+  void publish(Edit edit) {
+    // Only writers change `data`, so holding the mutex makes it stable.
+    // The scratch copy keeps the value off the writers' stacks.
+    std::lock_guard<std::mutex> guard(writeLock);
+    
+    memcpy(&scratch, &data, sizeof(scratch));
+    edit(scratch);
+    
+    if (memcmp(&scratch, &data, sizeof(scratch)) == 0) {
+      return;
+    }
+    
+    // Not preempted while odd, so a reader on this core never spins long
+#ifdef ESP_PLATFORM
+    portENTER_CRITICAL(&swapLock);
+#endif
+    uint32_t current = sequence.load(std::memory_order_relaxed);
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(&data, &scratch, sizeof(data));
+    sequence.store(current + 2, std::memory_order_release);
+#ifdef ESP_PLATFORM
+    portEXIT_CRITICAL(&swapLock);
+#endif
+  }
+  
+private:
+  T data;
+  T scratch;                        // Next value being built (under writeLock)
+  std::atomic<uint32_t> sequence;   // Odd while a write is in progress
+  std::mutex writeLock;             // Writers among themselves
+#ifdef ESP_PLATFORM
+  portMUX_TYPE swapLock = portMUX_INITIALIZER_UNLOCKED;   // Final copy only
+#endif
+};
+
+#endif // SEQLOCK_MAILBOX_H
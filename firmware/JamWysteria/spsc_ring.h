@@ -0,0 +1,174 @@
+/**
+ * Lock-free Ring Buffer for Jam Wysteria
+ *
+ * Single-producer / single-consumer byte ring used between the
+ * audio pipeline stages. One task writes, one task reads; neither
+ * takes a lock. Capacity is rounded up to a power of two.
+ *
+ * Header-only and free of Arduino dependencies so the pipeline
+ * stages can be built and exercised on a host.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include <esp_heap_caps.h>
+#endif
+
+class SpscRingBuffer {
+public:
+  SpscRingBuffer() : buffer(nullptr), mask(0), head(0), tail(0), inPsram(false) {}
+  ~SpscRingBuffer() { release(); }
+  
+  // Allocation (PSRAM first when asked, then internal RAM)
+  bool init(size_t size, bool preferPsram) {
+    release();
+    
+    size_t rounded = 1;
+    while (rounded < size) {
+      rounded <<= 1;
+    }
+
+#ifdef ESP_PLATFORM
+    if (preferPsram) {
+      buffer = (uint8_t*)heap_caps_malloc(rounded, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+      inPsram = (buffer != nullptr);
+    }
+#else
+    (void)preferPsram;
+#endif
+    if (buffer == nullptr) {
+      buffer = (uint8_t*)malloc(rounded);
+    }
+    if (buffer == nullptr) {
+      return false;
+    }
+    
+    mask = rounded - 1;
+    head.store(0);
+    tail.store(0);
+    return true;
+  }
+  
+  void release() {
+#ifdef ESP_PLATFORM
+    if (inPsram) {
+      heap_caps_free(buffer);
+    } else {
+      free(buffer);
+    }
+#else
+    free(buffer);
+#endif
+    buffer = nullptr;
+    mask = 0;
+    inPsram = false;
+  }
+  
+  // Producer side (returns bytes accepted)
+  size_t write(const uint8_t* data, size_t length) {
+    size_t w = head.load(std::memory_order_relaxed);
+    size_t r = tail.load(std::memory_order_acquire);
+    size_t count = capacity() - (w - r);
+    if (length < count) {
+      count = length;
+    }
+    
+    size_t offset = w & mask;
+    size_t first = capacity() - offset;
+    if (first > count) {
+      first = count;
+    }
+    memcpy(buffer + offset, data, first);
+    memcpy(buffer, data + first, count - first);
+    
+    head.store(w + count, std::memory_order_release);
+    return count;
+  }
+  
+  // Consumer side (returns bytes copied out)
+  size_t read(uint8_t* data, size_t length) {
+    size_t count = peek(data, length);
+    tail.store(tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    return count;
+  }
+  
+  // Consumer side: copy without consuming
+  size_t peek(uint8_t* data, size_t length) const {
+    size_t r = tail.load(std::memory_order_relaxed);
+    size_t w = head.load(std::memory_order_acquire);
+    size_t count = w - r;
+    if (length < count) {
+      count = length;
+    }
+    
+    size_t offset = r & mask;
+    size_t first = capacity() - offset;
+    if (first > count) {
+      first = count;
+    }
+    memcpy(data, buffer + offset, first);
+    memcpy(data + first, buffer, count - first);
+    return count;
+  }
+  
+  // Consumer side: the readable bytes that lie in one piece (up to
+  // the wrap), for handing on without a copy; skip() them afterwards
+  size_t span(const uint8_t** data) const {
+    size_t r = tail.load(std::memory_order_relaxed);
+    size_t count = head.load(std::memory_order_acquire) - r;
+    size_t offset = r & mask;
+    if (count > capacity() - offset) {
+      count = capacity() - offset;
+    }
+    *data = buffer + offset;
+    return count;
+  }
+  
+  // Consumer side: drop bytes without copying
+  size_t skip(size_t length) {
+    size_t r = tail.load(std::memory_order_relaxed);
+    size_t count = head.load(std::memory_order_acquire) - r;
+    if (length < count) {
+      count = length;
+    }
+    tail.store(r + count, std::memory_order_release);
+    return count;
+  }
+  
+  // Levels (exact for the calling side, a snapshot for the other)
+  size_t available() const {
+    return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+  }
+  
+  size_t space() const {
+    return capacity() - available();
+  }
+  
+  size_t capacity() const {
+    return buffer != nullptr ? mask + 1 : 0;
+  }
+  
+  bool isPsram() const {
+    return inPsram;
+  }
+  
+private:
+  uint8_t* buffer;
+  size_t mask;
+  std::atomic<size_t> head;   // Total bytes written (producer)
+  std::atomic<size_t> tail;   // Total bytes read (consumer)
+  bool inPsram;
+  
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+};
+
+#endif // SPSC_RING_H
@@ -55,6 +55,12 @@ bool StationManagerClass::saveStations() {
     stationObj["id"] = station.id;
     stationObj["name"] = station.name;
     stationObj["url"] = station.url;
+    if (!station.mirrors.empty()) {
+      JsonArray mirrorsArray = stationObj.createNestedArray("mirrors");
+      for (const auto& mirror : station.mirrors) {
+        mirrorsArray.add(mirror);
+      }
+    }
     stationObj["iconPath"] = station.iconPath;
     stationObj["parentFolder"] = station.parentFolder;
   }
@@ -351,13 +357,24 @@ bool StationManagerClass::importStations(const String& jsonData) {
   if (doc.containsKey("stations")) {
     JsonArray stationsArray = doc["stations"];
     for (JsonObject stationObj : stationsArray) {
-      addStation(
+      int id = addStation(
         stationObj["name"].as<String>(),
         stationObj["url"].as<String>(),
         stationObj["icon"].as<String>(),
         stationObj["parent"].as<String>()
       );
+      
+      // Optional alternate URLs, tried in order when the main one fails
+      Station* station = getStation(id);
+      if (station != nullptr && stationObj.containsKey("mirrors")) {
+        for (JsonVariant mirror : stationObj["mirrors"].as<JsonArray>()) {
+          if (station->mirrors.size() < STREAM_MAX_MIRRORS) {
+            station->mirrors.push_back(mirror.as<String>());
+          }
+        }
+      }
     }
+    saveStations();
   }
   
   Serial.println("[STATION] ✓ Import complete");
@@ -441,6 +458,12 @@ String StationManagerClass::exportStations() {
     JsonObject stationObj = stationsArray.createNestedObject();
     stationObj["name"] = station.name;
     stationObj["url"] = station.url;
+    if (!station.mirrors.empty()) {
+      JsonArray mirrorsArray = stationObj.createNestedArray("mirrors");
+      for (const auto& mirror : station.mirrors) {
+        mirrorsArray.add(mirror);
+      }
+    }
     stationObj["icon"] = station.iconPath;
     stationObj["parent"] = station.parentFolder;
   }
@@ -0,0 +1,137 @@
+/**
+ * Station Probe Steps for Jam Wysteria
+ *
+ * One station check, once a worker has picked it up: follow a cached
+ * route or the playlists to the stream as a tune-in would
+ * (playlist_resolve.h), note what the audio response says, and read
+ * at a trickle up to the first ICY title. Everything outside that
+ * logic comes through a ProbeIo: StationProber runs it over
+ * HttpStream, PlaylistResolver and FreeRTOS delays; on a host,
+ * test/test_station_probe.cpp runs it against a stand-in server with
+ * a simulated clock.
+ *
+ * Header-only and free of Arduino dependencies, like SpscRingBuffer.
+ */
+
+#ifndef STATION_PROBE_H
+#define STATION_PROBE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "audio_io.h"
+#include "icy_metadata.h"
+#include "playlist_resolve.h"
+
+enum ProbeState {
+  PROBE_UNKNOWN,
+  PROBE_PENDING,              // Queued or being checked
+  PROBE_ALIVE,
+  PROBE_DEAD
+};
+
+// What a resolution sees, plus the audio response (read() gives
+// audio with the metadata stripped)
+class ProbeIo : public ResolveIo {
+public:
+  virtual bool isChunked() = 0;
+  virtual int bitrate() = 0;                // icy-br in kbps (0 = unknown)
+  virtual size_t metaInterval() = 0;        // 0 = no ICY metadata
+  virtual const IcyMetadataParser* metadata() = 0;   // First block, nullptr until then
+};
+
+// Budgets of one check (the PROBE_* and PLAYLIST_* settings on the device)
+struct ProbeLimits {
+  uint32_t connectTimeoutMs;  // Also the wait for a playlist body
+  uint32_t titleTimeoutMs;
+  size_t maxBytes;            // Stream bytes read for a title at most
+  size_t bytesPerSecond;      // Read rate
+  size_t maxPlaylistSize;
+  int maxDepth;               // Playlists pointing at playlists
+  size_t maxURLLength;
+  size_t titleSize;           // Buffer the title must fit, NUL included
+};
+
+// What a check found; the response fields are empty unless the
+// stream itself answered
+struct ProbeReport {
+  ProbeState state;
+  uint32_t latencyMs;         // Request to audio response headers
+  std::string contentType;
+  bool chunked;
+  int bitrate;
+  std::string title;          // ICY StreamTitle, UTF-8
+};
+
+// The first metadata block follows metaint bytes of audio, which are
+// read at a trickle and thrown away
+inline void probeReadTitle(ProbeIo& io, const ProbeLimits& limits, ProbeReport& report) {
+  uint8_t chunk[1024];          // A fetch-task read
+  size_t got = 0;
+  uint32_t start = io.now();
+  
+  while (io.metadata() == nullptr && got <= limits.maxBytes &&
+         io.now() - start < limits.titleTimeoutMs) {
+    int received = io.read(chunk, sizeof(chunk));
+    if (received < 0) {
+      return;
+    }
+    if (received == 0) {
+      io.wait(10);
+      continue;
+    }
+    
+    got += received;
+    uint32_t due = (uint32_t)((uint64_t)got * 1000 / limits.bytesPerSecond);
+    int32_t ahead = (int32_t)(due - (io.now() - start));
+    if (ahead > 0) {
+      io.wait(ahead);
+    }
+  }
+  
+  const IcyMetadataParser* block = io.metadata();
+  if (block != nullptr && limits.titleSize > 0) {
+    std::vector<char> title(limits.titleSize);
+    icyCopyUtf8(block->find("StreamTitle"), title.data(), title.size());
+    report.title = title.data();
+  }
+}
+
+// Same route as a tune-in: the cached resolution, else the playlists.
+// Leaves the connection open on the stream (the caller closes it).
+inline void probeStation(ProbeIo& io, const std::string& url, const ProbeLimits& limits,
+                         ProbeReport& report) {
+  report = ProbeReport();
+  report.state = PROBE_DEAD;
+  
+  ResolveLimits resolve = {
+    limits.connectTimeoutMs, limits.maxPlaylistSize, limits.maxDepth, limits.maxURLLength
+  };
+  ResolveResult route;
+  uint32_t start = io.now();
+  resolvePlaylist(io, url, resolve, route);
+  
+  if (route.outcome == RESOLVE_FAILED || route.outcome == RESOLVE_CANCELLED) {
+    return;
+  }
+  
+  report.state = PROBE_ALIVE;
+  report.latencyMs = io.now() - start;
+  
+  // HLS or similar: the server answers, only the decoder can say more
+  if (route.outcome == RESOLVE_PLAYLIST) {
+    return;
+  }
+  
+  report.contentType = io.contentType();
+  report.chunked = io.isChunked();
+  report.bitrate = io.bitrate();
+  
+  // Only worth reading when the first title comes within the byte budget
+  if (io.metaInterval() > 0 && io.metaInterval() <= limits.maxBytes) {
+    probeReadTitle(io, limits, report);
+  }
+}
+
+#endif // STATION_PROBE_H
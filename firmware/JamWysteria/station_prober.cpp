@@ -0,0 +1,262 @@
+/**
+ * Station Prober Implementation
+ */
+
+#include "station_prober.h"
+#include "audio_pipeline.h"
+#include "playlist_resolver.h"
+#include <esp_timer.h>
+
+// Global instance
+StationProberClass StationProber;
+
+StationProberClass::StationProberClass() :
+  queue(nullptr),
+  useTick(0),
+  changes(0) {
+  lock = xSemaphoreCreateMutex();
+}
+
+bool StationProberClass::init() {
+  queue = xQueueCreate(PROBE_QUEUE_LEN, STREAM_URL_MAX_LENGTH);
+  if (queue == nullptr) {
+    return false;
+  }
+  
+  for (int i = 0; i < PROBE_WORKERS; i++) {
+    xTaskCreatePinnedToCore(taskEntry, "probe", PROBE_TASK_STACK, this,
+                            PROBE_TASK_PRIORITY, nullptr, PROBE_TASK_CORE);
+  }
+  
+  Serial.printf("[PROBE] ✓ %d background workers\n", PROBE_WORKERS);
+  return true;
+}
+
+// ============================================================================
+// Checks
+// ============================================================================
+
+void StationProberClass::request(const String& url) {
+  if (queue == nullptr || url.length() == 0 || url.length() >= STREAM_URL_MAX_LENGTH ||
+      AudioPipelineClass::isLocalURL(url.c_str())) {
+    return;
+  }
+  
+  uint32_t now = uptimeSeconds();
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ProbeEntry* entry = findEntry(url);
+  if (entry == nullptr) {
+    entry = addEntry(url);
+  }
+  entry->lastUsed = ++useTick;
+  
+  const ProbeResult& last = entry->result;
+  uint32_t ttl = last.state == PROBE_DEAD ? PROBE_DEAD_TTL_S : PROBE_TTL_S;
+  bool fresh = (last.state == PROBE_ALIVE || last.state == PROBE_DEAD) && now - last.checkedAt < ttl;
+  
+  // A full queue drops the request; the next redraw asks again
+  if (!entry->queued && !fresh && xQueueSend(queue, url.c_str(), 0) == pdTRUE) {
+    entry->queued = true;
+    if (entry->result.state == PROBE_UNKNOWN) {
+      entry->result.state = PROBE_PENDING;
+      changes = changes + 1;
+    }
+  }
+  xSemaphoreGive(lock);
+}
+
+void StationProberClass::cancelPending() {
+  if (queue == nullptr) {
+    return;
+  }
+  
+  char url[STREAM_URL_MAX_LENGTH];
+  while (xQueueReceive(queue, url, 0) == pdTRUE) {
+    xSemaphoreTake(lock, portMAX_DELAY);
+    ProbeEntry* entry = findEntry(url);
+    if (entry != nullptr) {
+      entry->queued = false;
+      if (entry->result.state == PROBE_PENDING) {
+        entry->result.state = PROBE_UNKNOWN;
+      }
+    }
+    xSemaphoreGive(lock);
+  }
+}
+
+bool StationProberClass::getResult(const String& url, ProbeResult& result) {
+  bool found = false;
+  
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ProbeEntry* entry = findEntry(url);
+  if (entry != nullptr) {
+    result = entry->result;
+    found = true;
+  }
+  xSemaphoreGive(lock);
+  
+  return found;
+}
+
+std::vector<ProbeEntry> StationProberClass::getResults() {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  std::vector<ProbeEntry> result = entries;
+  xSemaphoreGive(lock);
+  return result;
+}
+
+uint32_t StationProberClass::version() {
+  return changes;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+void StationProberClass::taskEntry(void* param) {
+  ((StationProberClass*)param)->workerLoop();
+}
+
+void StationProberClass::workerLoop() {
+  // Each worker keeps its own connection (the TLS client is large)
+  HttpStream* http = new HttpStream();
+  http->setTimeout(PROBE_CONNECT_TIMEOUT);
+  char url[STREAM_URL_MAX_LENGTH];
+  
+  while (true) {
+    if (xQueueReceive(queue, url, portMAX_DELAY) != pdTRUE) {
+      continue;
+    }
+    
+    // Tune-ins come first: wait out a missing network or a tight heap
+    while (!WiFi.isConnected() || ESP.getFreeHeap() < PROBE_MIN_FREE_HEAP) {
+      vTaskDelay(pdMS_TO_TICKS(PROBE_IDLE_MS));
+    }
+    
+    ProbeResult result;
+    probe(*http, url, result);
+    http->close();
+    store(url, result);
+    
+    #ifdef DEBUG_MODE
+    Serial.printf("[PROBE] %s: %s %lu ms %s %d kbps '%s'\n", url,
+                  result.state == PROBE_ALIVE ? "alive" : "dead", (unsigned long)result.latencyMs,
+                  result.codec, result.bitrate, result.title);
+    #endif
+  }
+}
+
+// ============================================================================
+// Probe I/O
+// ============================================================================
+
+// What a check in station_probe.h sees of the device
+class HttpProbeIo : public ProbeIo {
+public:
+  explicit HttpProbeIo(HttpStream& http) : http(http) {}
+  
+  bool open(const std::string& url) override { return http.open(url.c_str()); }
+  int read(uint8_t* buffer, size_t length) override { return http.read(buffer, length); }
+  void close() override { http.close(); }
+  std::string contentType() override { return http.getContentType().c_str(); }
+  bool isChunked() override { return http.isChunked(); }
+  int bitrate() override { return http.getBitrate(); }
+  size_t metaInterval() override { return http.getMetaInterval() > 0 ? http.getMetaInterval() : 0; }
+  
+  const IcyMetadataParser* metadata() override {
+    return http.getMetadataCount() > 0 ? &http.getMetadata() : nullptr;
+  }
+  
+  bool lookupRoute(const std::string& url, std::string& target) override {
+    String streamURL;
+    if (!PlaylistResolver.lookup(url.c_str(), streamURL)) {
+      return false;
+    }
+    target = streamURL.c_str();
+    return true;
+  }
+  
+  void storeRoute(const std::string& url, const std::string& target) override {
+    PlaylistResolver.store(url.c_str(), target.c_str());
+  }
+  
+  void dropRoute(const std::string& url) override { PlaylistResolver.invalidate(url.c_str()); }
+  
+  uint32_t now() override { return millis(); }
+  void wait(uint32_t ms) override { vTaskDelay(pdMS_TO_TICKS(ms)); }
+  bool cancelled() override { return false; }
+  
+private:
+  HttpStream& http;
+};
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+void StationProberClass::probe(HttpStream& http, const char* url, ProbeResult& result) {
+  static const ProbeLimits limits = {
+    PROBE_CONNECT_TIMEOUT, PROBE_TITLE_TIMEOUT, PROBE_MAX_BYTES, PROBE_WORKER_BPS,
+    PLAYLIST_MAX_SIZE, PLAYLIST_MAX_DEPTH, STREAM_URL_MAX_LENGTH, PROBE_TITLE_MAX
+  };
+  
+  HttpProbeIo io(http);
+  ProbeReport report;
+  probeStation(io, url, limits, report);
+  
+  memset(&result, 0, sizeof(result));
+  result.state = report.state;
+  result.latencyMs = report.latencyMs;
+  result.bitrate = report.bitrate;
+  const char* codec = report.chunked ? nullptr : AudioPipelineClass::codecForContentType(report.contentType.c_str());
+  strlcpy(result.codec, codec != nullptr ? codec : "", sizeof(result.codec));
+  strlcpy(result.title, report.title.c_str(), sizeof(result.title));
+  result.checkedAt = uptimeSeconds();
+}
+
+ProbeEntry* StationProberClass::findEntry(const String& url) {
+  for (auto& entry : entries) {
+    if (entry.url == url) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+ProbeEntry* StationProberClass::addEntry(const String& url) {
+  ProbeEntry* slot;
+  if (entries.size() < PROBE_RESULT_ENTRIES) {
+    entries.push_back(ProbeEntry());
+    slot = &entries.back();
+  } else {
+    slot = &entries[0];
+    for (auto& entry : entries) {
+      if (!entry.queued && entry.lastUsed < slot->lastUsed) {
+        slot = &entry;
+      }
+    }
+  }
+  
+  slot->url = url;
+  memset(&slot->result, 0, sizeof(slot->result));
+  slot->queued = false;
+  slot->lastUsed = ++useTick;
+  return slot;
+}
+
+void StationProberClass::store(const String& url, const ProbeResult& result) {
+  xSemaphoreTake(lock, portMAX_DELAY);
+  ProbeEntry* entry = findEntry(url);
+  if (entry == nullptr) {
+    entry = addEntry(url);
+  }
+  entry->result = result;
+  entry->queued = false;
+  changes = changes + 1;
+  xSemaphoreGive(lock);
+}
+
+uint32_t StationProberClass::uptimeSeconds() {
+  return (uint32_t)(esp_timer_get_time() / 1000000);
+}
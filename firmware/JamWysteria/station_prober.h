@@ -0,0 +1,77 @@
+/**
+ * Station Prober for Jam Wysteria
+ *
+ * Checks catalogue stations in the background so the folder view can
+ * mark dead ones and preview what is playing without a tune-in. A
+ * few low-priority workers each open a station, time the response,
+ * note codec and bitrate, and read up to the first ICY metadata block
+ * for the current title. Reads are paced per worker and capped per
+ * check, so probing never competes with the playing stream for long.
+ *
+ * The check itself is in station_probe.h; this class queues checks,
+ * runs them over HttpStream and keeps the results. Results are kept
+ * for PROBE_TTL_S (PROBE_DEAD_TTL_S when the station failed); asking
+ * again within that time queues nothing.
+ */
+
+#ifndef STATION_PROBER_H
+#define STATION_PROBER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "http_stream.h"
+#include "station_probe.h"
+#include "config.h"
+
+struct ProbeResult {
+  ProbeState state;
+  uint32_t latencyMs;         // Request to audio response headers
+  char codec[8];              // "" = not known from the content type
+  int bitrate;                // kbps (icy-br, 0 = unknown)
+  char title[PROBE_TITLE_MAX];  // ICY StreamTitle, UTF-8
+  uint32_t checkedAt;         // Seconds of uptime
+};
+
+struct ProbeEntry {
+  String url;
+  ProbeResult result;
+  bool queued;                // Waiting for (or with) a worker
+  uint32_t lastUsed;
+};
+
+class StationProberClass {
+public:
+  StationProberClass();
+  
+  // Initialization (starts the workers)
+  bool init();
+  
+  // Checks (any task); request() is a no-op while a result is fresh
+  void request(const String& url);
+  void cancelPending();             // Screen changed: drop what is still queued
+  bool getResult(const String& url, ProbeResult& result);
+  std::vector<ProbeEntry> getResults();
+  uint32_t version();               // Changes whenever a result does
+  
+private:
+  QueueHandle_t queue;
+  SemaphoreHandle_t lock;
+  std::vector<ProbeEntry> entries;
+  uint32_t useTick;
+  volatile uint32_t changes;
+  
+  static void taskEntry(void* param);
+  void workerLoop();
+  
+  // Helper functions
+  void probe(HttpStream& http, const char* url, ProbeResult& result);
+  ProbeEntry* findEntry(const String& url);
+  ProbeEntry* addEntry(const String& url);
+  void store(const String& url, const ProbeResult& result);
+  uint32_t uptimeSeconds();
+};
+
+// Global instance
+extern StationProberClass StationProber;
+
+#endif // STATION_PROBER_H
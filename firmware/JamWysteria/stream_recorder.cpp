@@ -0,0 +1,298 @@
+/**
+ * Stream Recorder Implementation
+ */
+
+#include "stream_recorder.h"
+#include "sd_manager.h"
+
+// Global instance
+StreamRecorderClass StreamRecorder;
+
+StreamRecorderClass::StreamRecorderClass() :
+  splitQueue(nullptr),
+  task(nullptr),
+  startRequested(false),
+  stopRequested(false),
+  recording(false),
+  splitTracks(false),
+  active(false),
+  teed(0),
+  dropped(0),
+  teeUs(0),
+  consumed(0),
+  nextNumber(1),
+  files(0),
+  written(0),
+  writeUs(0),
+  startedAt(0) {
+  name[0] = '\0';
+  extension[0] = '\0';
+  lastTitle[0] = '\0';
+  currentPath[0] = '\0';
+}
+
+bool StreamRecorderClass::init() {
+  // The write-behind ring needs PSRAM; without it there is no recording
+  if (!ring.init(RECORD_RING_SIZE, true) || !ring.isPsram()) {
+    ring.release();
+    Serial.println("[RECORD] No PSRAM for the write-behind buffer, recording disabled");
+    return false;
+  }
+  
+  splitQueue = xQueueCreate(RECORD_SPLIT_QUEUE_LEN, sizeof(RecordSplit));
+  xTaskCreatePinnedToCore(taskEntry, "record", RECORD_TASK_STACK, this,
+                          RECORD_TASK_PRIORITY, &task, RECORD_TASK_CORE);
+  
+  Serial.printf("[RECORD] ✓ Write-behind buffer: %u KB\n", ring.capacity() / 1024);
+  return true;
+}
+
+bool StreamRecorderClass::isReady() {
+  return task != nullptr;
+}
+
+// ============================================================================
+// Control
+// ============================================================================
+
+bool StreamRecorderClass::start(const String& stationName, const char* codec, bool split) {
+  if (!isReady() || recording || codec == nullptr || codec[0] == '\0') {
+    return false;
+  }
+  
+  strlcpy(name, stationName.length() > 0 ? stationName.c_str() : "Stream", sizeof(name));
+  strlcpy(extension, codec, sizeof(extension));
+  splitTracks = split;
+  dropped = 0;
+  teeUs = 0;
+  
+  // The writer task opens the file and then starts the tee
+  recording = true;
+  startRequested = true;
+  return true;
+}
+
+void StreamRecorderClass::stop() {
+  if (!recording) {
+    return;
+  }
+  
+  active = false;
+  recording = false;
+  stopRequested = true;
+}
+
+bool StreamRecorderClass::isRecording() {
+  return recording;
+}
+
+RecorderStatus StreamRecorderClass::getStatus() {
+  RecorderStatus status;
+  status.recording = recording;
+  status.splitTracks = splitTracks;
+  status.path = currentPath;
+  status.files = files;
+  status.bytesWritten = written;
+  status.bytesDropped = dropped;
+  status.backlog = ring.available();
+  status.elapsedMs = startedAt > 0 ? millis() - startedAt : 0;
+  status.teeUs = teeUs;
+  status.writeUs = writeUs;
+  return status;
+}
+
+// ============================================================================
+// Fetch Task Hooks
+// ============================================================================
+
+void StreamRecorderClass::tee(const uint8_t* data, size_t length) {
+  if (!active) {
+    return;
+  }
+  
+  // One copy into PSRAM; a full ring drops rather than waits
+  unsigned long start = micros();
+  size_t accepted = ring.write(data, length);
+  teed = teed + accepted;
+  if (accepted < length) {
+    dropped = dropped + (length - accepted);
+  }
+  teeUs = teeUs + (micros() - start);
+}
+
+void StreamRecorderClass::markTitle(IcySpan title) {
+  char text[RECORD_TITLE_MAX];
+  icyCopyUtf8(title, text, sizeof(text));
+  if (strcmp(text, lastTitle) == 0) {
+    return;
+  }
+  strlcpy(lastTitle, text, sizeof(lastTitle));
+  
+  if (!active || !splitTracks) {
+    return;
+  }
+  
+  // Queue full: the title stays in the file already being written
+  RecordSplit split;
+  split.position = teed;
+  strlcpy(split.title, text, sizeof(split.title));
+  xQueueSend(splitQueue, &split, 0);
+}
+
+// ============================================================================
+// Writer Task
+// ============================================================================
+
+void StreamRecorderClass::taskEntry(void* param) {
+  ((StreamRecorderClass*)param)->writerLoop();
+}
+
+void StreamRecorderClass::writerLoop() {
+  while (true) {
+    if (stopRequested) {
+      stopRequested = false;
+      
+      // Everything teed before the stop belongs to the recording
+      if (writer.isOpen()) {
+        writeOut(ring.available());
+      }
+      closeFile();
+      ring.skip(ring.available());
+      xQueueReset(splitQueue);
+      continue;
+    }
+    
+    if (startRequested) {
+      startRequested = false;
+      if (!recording) {
+        continue;           // Stopped before it began
+      }
+      
+      ring.skip(ring.available());
+      xQueueReset(splitQueue);
+      consumed = teed;
+      files = 0;
+      written = 0;
+      writeUs = 0;
+      startedAt = millis();
+      
+      SDManager.createDir(RECORD_DIR);
+      nextNumber = findNextNumber();
+      if (openFile(name)) {
+        active = true;
+      } else {
+        recording = false;
+      }
+      continue;
+    }
+    
+    if (!writer.isOpen()) {
+      vTaskDelay(pdMS_TO_TICKS(RECORD_POLL_MS));
+      continue;
+    }
+    
+    // A title change at the write position starts the next file
+    size_t limit = ring.available();
+    RecordSplit split;
+    if (xQueuePeek(splitQueue, &split, 0) == pdTRUE) {
+      uint32_t ahead = split.position - consumed;
+      if (ahead == 0) {
+        xQueueReceive(splitQueue, &split, 0);
+        closeFile();
+        if (!openFile(split.title)) {
+          active = false;
+          recording = false;
+        }
+        continue;
+      }
+      writeOut(min(limit, (size_t)ahead));
+      if (limit < ahead) {
+        vTaskDelay(pdMS_TO_TICKS(RECORD_POLL_MS));
+      }
+      continue;
+    }
+    
+    // Whole blocks go to the card straight from the ring
+    if (limit < RECORD_WRITE_BUFFER) {
+      vTaskDelay(pdMS_TO_TICKS(RECORD_POLL_MS));
+      continue;
+    }
+    writeOut(limit);
+  }
+}
+
+// ============================================================================
+// Private Helper Functions
+// ============================================================================
+
+bool StreamRecorderClass::openFile(const char* title) {
+  // Titles become file names: no path or FAT-reserved characters
+  char base[RECORD_TITLE_MAX];
+  size_t length = 0;
+  for (const char* c = title; *c != '\0' && length < RECORD_NAME_MAX; c++) {
+    bool reserved = strchr("\\/:*?\"<>|", *c) != nullptr || (uint8_t)*c < 0x20 || (uint8_t)*c >= 0x80;
+    base[length++] = reserved ? '_' : *c;
+  }
+  base[length] = '\0';
+  
+  snprintf(currentPath, sizeof(currentPath), "%s/%04d %s.%s",
+           RECORD_DIR, nextNumber++, base, extension);
+  if (!writer.open(currentPath, RECORD_WRITE_BUFFER)) {
+    Serial.printf("[RECORD] ✗ Cannot create %s\n", currentPath);
+    currentPath[0] = '\0';
+    return false;
+  }
+  
+  files = files + 1;
+  Serial.printf("[RECORD] ✓ Recording to %s\n", currentPath);
+  return true;
+}
+
+void StreamRecorderClass::closeFile() {
+  if (!writer.isOpen()) {
+    return;
+  }
+  
+  size_t size = writer.getSize();
+  if (writer.close()) {
+    Serial.printf("[RECORD] Saved %s (%u KB)\n", currentPath, size / 1024);
+  }
+}
+
+void StreamRecorderClass::writeOut(size_t limit) {
+  while (limit > 0) {
+    const uint8_t* data;
+    size_t count = min(ring.span(&data), limit);
+    if (count == 0) {
+      return;
+    }
+    
+    unsigned long start = micros();
+    writer.write(data, count);
+    writeUs = writeUs + (micros() - start);
+    
+    ring.skip(count);
+    consumed += count;
+    written = written + count;
+    limit -= count;
+    
+    if (writer.hasError()) {
+      Serial.println("[RECORD] ✗ SD write failed, recording stopped");
+      active = false;
+      recording = false;
+      closeFile();
+      return;
+    }
+  }
+}
+
+int StreamRecorderClass::findNextNumber() {
+  // Files are numbered on from the highest already on the card
+  int highest = 0;
+  SDDirIterator dir = SDManager.openDir(RECORD_DIR);
+  String entry;
+  while (dir.next(entry)) {
+    highest = max(highest, (int)entry.toInt());
+  }
+  return highest + 1;
+}
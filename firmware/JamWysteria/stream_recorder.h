@@ -0,0 +1,106 @@
+/**
+ * Stream Recorder for Jam Wysteria
+ *
+ * Records the station being played to the SD card as it arrives.
+ * The compressed bytes the fetch task reads are teed into a
+ * write-behind ring in PSRAM, and a low-priority task hands whole
+ * blocks from the ring straight to the file. Nothing is decoded or
+ * re-encoded and the decode path is untouched: a slow card only
+ * fills the ring, and what no longer fits is dropped (and counted)
+ * rather than holding up the fetch task.
+ *
+ * With track splitting on, every new ICY StreamTitle starts a new
+ * file at the byte where the title arrived in the stream.
+ */
+
+#ifndef STREAM_RECORDER_H
+#define STREAM_RECORDER_H
+
+#include <Arduino.h>
+#include "buffered_writer.h"
+#include "spsc_ring.h"
+#include "icy_metadata.h"
+#include "config.h"
+
+// Title change, queued by the fetch task at a stream position
+struct RecordSplit {
+  uint32_t position;          // Bytes teed when the title arrived
+  char title[RECORD_TITLE_MAX];
+};
+
+// Recorder status and cost
+struct RecorderStatus {
+  bool recording;
+  bool splitTracks;
+  String path;                // File being written
+  uint32_t files;             // Files started by this recording
+  uint32_t bytesWritten;
+  uint32_t bytesDropped;      // Ring overflowed (card too slow)
+  size_t backlog;             // Bytes waiting in the ring
+  uint32_t elapsedMs;
+  uint32_t teeUs;             // Fetch task time spent teeing
+  uint32_t writeUs;           // Writer task time spent in SD writes
+};
+
+class StreamRecorderClass {
+public:
+  StreamRecorderClass();
+  
+  // Initialization (allocates the ring, starts the writer task)
+  bool init();
+  bool isReady();
+  
+  // Control (UI or web task; codec is the stream's file extension)
+  bool start(const String& name, const char* codec, bool splitTracks);
+  void stop();
+  bool isRecording();
+  RecorderStatus getStatus();
+  
+  // Fetch task hooks (cheap no-ops while not recording)
+  void tee(const uint8_t* data, size_t length);
+  void markTitle(IcySpan title);
+  
+private:
+  SpscRingBuffer ring;                // fetch -> writer
+  QueueHandle_t splitQueue;
+  TaskHandle_t task;
+  BufferedFileWriter writer;          // Writer task only
+  
+  // Requested by start()/stop()
+  volatile bool startRequested;
+  volatile bool stopRequested;
+  volatile bool recording;
+  bool splitTracks;
+  char name[RECORD_TITLE_MAX];
+  char extension[8];
+  
+  // Fetch task side
+  volatile bool active;               // Teeing
+  volatile uint32_t teed;             // Bytes accepted into the ring
+  volatile uint32_t dropped;
+  volatile uint32_t teeUs;
+  char lastTitle[RECORD_TITLE_MAX];   // Servers repeat it every metadata block
+  
+  // Writer task side
+  uint32_t consumed;                  // Stream position written out
+  int nextNumber;
+  volatile uint32_t files;
+  volatile uint32_t written;
+  volatile uint32_t writeUs;
+  unsigned long startedAt;
+  char currentPath[SD_MAX_PATH_LENGTH];
+  
+  static void taskEntry(void* param);
+  void writerLoop();
+  
+  // Helper functions
+  bool openFile(const char* title);
+  void closeFile();
+  void writeOut(size_t limit);
+  int findNextNumber();
+};
+
+// Global instance
+extern StreamRecorderClass StreamRecorder;
+
+#endif // STREAM_RECORDER_H
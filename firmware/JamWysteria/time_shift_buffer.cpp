@@ -0,0 +1,181 @@
+/**
+ * Time-shift Buffer Implementation
+ */
+
+#include "time_shift_buffer.h"
+#include "sd_manager.h"
+#include <esp_heap_caps.h>
+
+TimeShiftBuffer::TimeShiftBuffer() :
+  spillOpen(false),
+  spillFailed(false),
+  spillRead(0),
+  spillWritten(0),
+  writeBlock(nullptr),
+  writeUsed(0),
+  readBlock(nullptr),
+  held(0) {
+}
+
+TimeShiftBuffer::~TimeShiftBuffer() {
+  clear();
+  heap_caps_free(writeBlock);
+}
+
+bool TimeShiftBuffer::init(size_t ramSize) {
+  // Minutes of audio are not worth internal RAM
+  if (!ram.init(ramSize, true) || !ram.isPsram()) {
+    ram.release();
+    return false;
+  }
+  
+  writeBlock = (uint8_t*)heap_caps_malloc(TIMESHIFT_SPILL_BLOCK * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (writeBlock == nullptr) {
+    ram.release();
+    return false;
+  }
+  readBlock = writeBlock + TIMESHIFT_SPILL_BLOCK;
+  
+  clear();
+  return true;
+}
+
+bool TimeShiftBuffer::isReady() {
+  return writeBlock != nullptr;
+}
+
+// ============================================================================
+// Data
+// ============================================================================
+
+size_t TimeShiftBuffer::push(const uint8_t* data, size_t length) {
+  size_t done = 0;
+  
+  // Straight into PSRAM while nothing older waits on the card
+  if (spillWritten == spillRead && writeUsed == 0) {
+    done = ram.write(data, length);
+  }
+  
+  while (done < length) {
+    if (writeUsed == TIMESHIFT_SPILL_BLOCK && !flushBlock()) {
+      break;
+    }
+    
+    size_t count = min(length - done, TIMESHIFT_SPILL_BLOCK - writeUsed);
+    memcpy(writeBlock + writeUsed, data + done, count);
+    writeUsed += count;
+    done += count;
+  }
+  
+  held = held + done;
+  return done;
+}
+
+size_t TimeShiftBuffer::pop(uint8_t* data, size_t length) {
+  refill();
+  
+  size_t count = ram.read(data, length);
+  held = held - count;
+  return count;
+}
+
+void TimeShiftBuffer::clear() {
+  ram.skip(ram.available());
+  writeUsed = 0;
+  spillRead = 0;
+  spillWritten = 0;
+  spillFailed = false;
+  held = 0;
+  
+  if (spillOpen) {
+    spill.close();
+    spillOpen = false;
+    SD.remove(SD_TIMESHIFT_FILE);
+    SDManager.notifyPathChanged(SD_TIMESHIFT_FILE, false);
+  }
+}
+
+size_t TimeShiftBuffer::available() {
+  return held;
+}
+
+size_t TimeShiftBuffer::space() {
+  if (!isReady()) {
+    return 0;
+  }
+  
+  size_t free = TIMESHIFT_SPILL_BLOCK - writeUsed;
+  if (spillWritten == spillRead && writeUsed == 0) {
+    free += ram.space();
+  }
+  
+  size_t spilled = spillWritten - spillRead;
+  if (!spillFailed && spilled < TIMESHIFT_SPILL_MAX) {
+    free += TIMESHIFT_SPILL_MAX - spilled;
+  }
+  return free;
+}
+
+// ============================================================================
+// Spill File
+// ============================================================================
+
+bool TimeShiftBuffer::flushBlock() {
+  if (spillFailed || spillWritten - spillRead >= TIMESHIFT_SPILL_MAX) {
+    return false;
+  }
+  
+  if (!spillOpen) {
+    if (SDManager.isInitialized()) {
+      spill = SD.open(SD_TIMESHIFT_FILE, "w+");
+    }
+    if (!spill) {
+      Serial.println("[TIMESHIFT] ✗ Cannot create spill file, holding PSRAM only");
+      spillFailed = true;
+      return false;
+    }
+    spillOpen = true;
+    SDManager.notifyPathChanged(SD_TIMESHIFT_FILE, true);
+    Serial.println("[TIMESHIFT] PSRAM full, spilling to SD");
+  }
+  
+  if (!spill.seek(spillWritten) || spill.write(writeBlock, writeUsed) != writeUsed) {
+    Serial.println("[TIMESHIFT] ✗ Spill write failed");
+    spillFailed = true;
+    return false;
+  }
+  
+  spillWritten += writeUsed;
+  writeUsed = 0;
+  return true;
+}
+
+void TimeShiftBuffer::refill() {
+  // The card holds what came after PSRAM filled up, the write block
+  // what came after that
+  while (spillRead < spillWritten && ram.space() >= TIMESHIFT_SPILL_BLOCK) {
+    size_t count = min((size_t)TIMESHIFT_SPILL_BLOCK, spillWritten - spillRead);
+    size_t got = spill.seek(spillRead) ? spill.read(readBlock, count) : 0;
+    if (got == 0) {
+      // Unreadable: what is left on the card is lost
+      Serial.println("[TIMESHIFT] ✗ Spill read failed");
+      held = held - (spillWritten - spillRead);
+      spillRead = spillWritten;
+      spillFailed = true;
+      break;
+    }
+    
+    ram.write(readBlock, got);
+    spillRead += got;
+  }
+  
+  if (spillRead == spillWritten) {
+    // Card drained: start the file over
+    spillRead = 0;
+    spillWritten = 0;
+    if (writeUsed > 0 && ram.space() >= writeUsed) {
+      ram.write(writeBlock, writeUsed);
+      writeUsed = 0;
+    }
+  }
+}
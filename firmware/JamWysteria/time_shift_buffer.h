@@ -0,0 +1,58 @@
+/**
+ * Time-shift Buffer for Jam Wysteria
+ *
+ * Holds the compressed stream of a live station that keeps arriving
+ * while the listener is behind it, oldest first: a ring in PSRAM,
+ * and once that is full a spill file on the SD card. The spill is
+ * written and read back in whole blocks staged in PSRAM, so the card
+ * only sees large sequential transfers. Once the spill reaches
+ * TIMESHIFT_SPILL_MAX no more is accepted and the caller stops
+ * reading the network.
+ *
+ * Used by the fetch task alone; available() may be read from any task.
+ */
+
+#ifndef TIME_SHIFT_BUFFER_H
+#define TIME_SHIFT_BUFFER_H
+
+#include <SD.h>
+#include <FS.h>
+#include "spsc_ring.h"
+#include "config.h"
+
+class TimeShiftBuffer {
+public:
+  TimeShiftBuffer();
+  ~TimeShiftBuffer();
+  
+  // Allocation (PSRAM only; without it there is no time-shift)
+  bool init(size_t ramSize);
+  bool isReady();
+  
+  // Data (push returns bytes accepted, pop copies out oldest first)
+  size_t push(const uint8_t* data, size_t length);
+  size_t pop(uint8_t* data, size_t length);
+  void clear();                     // Drops everything, removes the spill file
+  
+  // Levels
+  size_t available();               // Bytes held (any task)
+  size_t space();                   // Bytes push() will still take
+  
+private:
+  SpscRingBuffer ram;               // Oldest part
+  File spill;                       // Then the card
+  bool spillOpen;
+  bool spillFailed;
+  size_t spillRead;                 // Offsets in the spill file
+  size_t spillWritten;
+  uint8_t* writeBlock;              // Newest part, not yet on the card
+  size_t writeUsed;
+  uint8_t* readBlock;
+  volatile size_t held;
+  
+  // Helper functions
+  bool flushBlock();
+  void refill();
+};
+
+#endif // TIME_SHIFT_BUFFER_H
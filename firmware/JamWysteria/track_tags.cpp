@@ -0,0 +1,87 @@
+/**
+ * Track Tags Implementation
+ */
+
+#include "track_tags.h"
+#include "audio_player.h"
+#include "sd_manager.h"
+
+TrackTagReader::TrackTagReader() :
+  parser(this),
+  extension("jpg"),
+  haveArt(false) {
+}
+
+void TrackTagReader::begin() {
+  end();
+  parser.begin();
+  haveArt = false;
+}
+
+void TrackTagReader::feed(const uint8_t* data, size_t length) {
+  parser.feed(data, length);
+}
+
+bool TrackTagReader::isDone() {
+  return parser.isDone();
+}
+
+void TrackTagReader::end() {
+  if (writer.isOpen()) {
+    writer.abort();
+  }
+}
+
+// ============================================================================
+// ID3 Frames
+// ============================================================================
+
+void TrackTagReader::onId3Text(Id3Field field, const char* text) {
+  AudioPlayer.publishTag(field, text);
+}
+
+bool TrackTagReader::onId3ImageStart(const char* mimeType, uint8_t pictureType, size_t size) {
+  if (haveArt || size > ART_MAX_SIZE || !SDManager.isInitialized()) {
+    return false;
+  }
+  
+  // Named once the whole picture (and so its CRC) is known
+  extension = strstr(mimeType, "png") != nullptr ? "png" : "jpg";
+  SDManager.createDir(ART_DIR);
+  return writer.open(ART_TEMP_FILE, ART_WRITE_BUFFER, ART_MAX_SIZE);
+}
+
+void TrackTagReader::onId3ImageData(const uint8_t* data, size_t length) {
+  writer.write(data, length);
+}
+
+void TrackTagReader::onId3ImageEnd(bool complete) {
+  if (!writer.isOpen()) {
+    return;
+  }
+  if (!complete || writer.hasError() || writer.limitExceeded()) {
+    writer.abort();
+    return;
+  }
+  
+  size_t size = writer.getSize();
+  char path[32];
+  snprintf(path, sizeof(path), "%s/%08x.%s", ART_DIR, (unsigned)writer.getCRC32(), extension);
+  if (!writer.close()) {
+    SDManager.remove(ART_TEMP_FILE);
+    return;
+  }
+  
+  if (SDManager.exists(path)) {
+    SDManager.remove(ART_TEMP_FILE);    // Cached by another track of the album
+  } else if (SDManager.rename(ART_TEMP_FILE, path)) {
+    Serial.printf("[ID3] ✓ Cover saved: %s (%u KB)\n", path, (unsigned)(size / 1024));
+  } else {
+    Serial.printf("[ID3] ✗ Cannot store cover as %s\n", path);
+    SDManager.remove(ART_TEMP_FILE);
+    return;
+  }
+  
+  haveArt = true;
+  AudioPlayer.publishAlbumArt(path);
+}
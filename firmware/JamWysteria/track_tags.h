@@ -0,0 +1,44 @@
+/**
+ * Track Tags for Jam Wysteria
+ *
+ * Reads the ID3v2 tag of a file played from the SD card while the
+ * fetch task streams it: title, artist, album and genre go to the
+ * player's metadata, and the cover picture is written to ART_DIR as
+ * it arrives, named by the CRC32 of its bytes. Tracks sharing a cover
+ * share one file, and a picture never has to fit in RAM.
+ *
+ * Used by the fetch task alone.
+ */
+
+#ifndef TRACK_TAGS_H
+#define TRACK_TAGS_H
+
+#include <Arduino.h>
+#include "id3_parser.h"
+#include "buffered_writer.h"
+#include "config.h"
+
+class TrackTagReader : public Id3Listener {
+public:
+  TrackTagReader();
+  
+  // Per file: begin, feed its bytes in order until done, then end
+  void begin();
+  void feed(const uint8_t* data, size_t length);
+  bool isDone();
+  void end();                       // Drops a picture cut short
+  
+  // Id3Listener
+  void onId3Text(Id3Field field, const char* text) override;
+  bool onId3ImageStart(const char* mimeType, uint8_t pictureType, size_t size) override;
+  void onId3ImageData(const uint8_t* data, size_t length) override;
+  void onId3ImageEnd(bool complete) override;
+  
+private:
+  Id3Parser parser;
+  BufferedFileWriter writer;        // Picture being written
+  const char* extension;
+  bool haveArt;                     // First picture of the tag wins
+};
+
+#endif // TRACK_TAGS_H
@@ -9,6 +9,8 @@
 #include "station_manager.h"
 #include "wifi_manager.h"
 #include "audio_player.h"
+#include "sd_manager.h"
+#include "station_prober.h"
 
 // Global instance
 UIManagerClass UIManager;
@@ -17,7 +19,11 @@ UIManagerClass::UIManagerClass() :
   currentSSID(""),
   currentPassword(""),
   scrollPosition(0),
-  selectedIndex(-1) {
+  selectedIndex(-1),
+  drawnMetadataVersion(0),
+  drawnReconnecting(false),
+  drawnBehindS(0),
+  drawnProbeVersion(0) {
 }
 
 void UIManagerClass::init() {
@@ -91,9 +97,10 @@ void UIManagerClass::showHomeScreen() {
   drawAddButton();
   drawSettingsButton();
   
-  // Get folders and stations
+  // Get folders and stations (checks queued for another list are dropped)
   auto folders = StationManager.getCurrentFolders();
   auto stations = StationManager.getCurrentStations();
+  StationProber.cancelPending();
   
   buttons.clear();
   int y = 50;
@@ -108,8 +115,9 @@ void UIManagerClass::showHomeScreen() {
     y += 45;
   }
   
-  // Draw stations
+  // Draw stations, checking the visible ones in the background
   for (size_t i = 0; i < stations.size() && y < 200; i++) {
+    StationProber.request(stations[i]->url);
     drawStationCard(10, y, 300, 40, stations[i]);
     
     Button btn = {10, y, 300, 40, stations[i]->name, (int)(i + 1000), true};
@@ -117,6 +125,7 @@ void UIManagerClass::showHomeScreen() {
     
     y += 45;
   }
+  drawnProbeVersion = StationProber.version();
   
   if (folders.size() == 0 && stations.size() == 0) {
     Display.drawCenteredText("No stations yet", 100, COLOR_TEXT_DIM, 2);
@@ -156,6 +165,8 @@ void UIManagerClass::showPlayerScreen(Station* station) {
   }
   
   // Draw metadata
+  drawnMetadataVersion = AudioPlayer.getMetadataVersion();
+  drawnReconnecting = false;
   if (AudioPlayer.hasMetadata()) {
     drawMetadata(140, AudioPlayer.getTitle(), AudioPlayer.getArtist());
   } else {
@@ -175,6 +186,10 @@ void UIManagerClass::showPlayerScreen(Station* station) {
   // Stop button
   Display.drawButton(startX + btnSize + btnSpacing, btnY, btnSize, btnSize, "⏹", COLOR_ERROR, COLOR_TEXT);
   
+  // Live button (shows how far behind a time-shifted stream is)
+  drawnBehindS = AudioPlayer.getTimeBehindMs() / 1000;
+  drawLiveButton(startX + (btnSize + btnSpacing) * 2, btnY, btnSize, drawnBehindS);
+  
   // Volume control
   drawVolumeControl(10, 235, 300, AudioPlayer.getVolume());
   
@@ -185,8 +200,10 @@ void UIManagerClass::showPlayerScreen(Station* station) {
   buttons.clear();
   Button playBtn = {startX, btnY, btnSize, btnSize, "Play", PLAYER_ACTION_PLAY_PAUSE, true};
   Button stopBtn = {startX + btnSize + btnSpacing, btnY, btnSize, btnSize, "Stop", PLAYER_ACTION_STOP, true};
+  Button liveBtn = {startX + (btnSize + btnSpacing) * 2, btnY, btnSize, btnSize, "Live", PLAYER_ACTION_LIVE, true};
   buttons.push_back(playBtn);
   buttons.push_back(stopBtn);
+  buttons.push_back(liveBtn);
 }
 
 void UIManagerClass::showSettingsScreen() {
@@ -256,6 +273,17 @@ void UIManagerClass::showAudioSettings() {
   Display.drawText("Volume:", 20, 60, COLOR_TEXT, 1);
   int volume = AudioPlayer.getVolume();
   Display.drawProgressBar(20, 80, 280, 20, (volume * 100) / VOLUME_MAX, COLOR_PRIMARY, COLOR_CARD_BG);
+  
+  // Tone control
+  AppConfig& config = SDManager.getConfig();
+  buttons.clear();
+  drawToneRow(110, "Bass", config.eqBass, AUDIO_ACTION_BASS_DOWN, AUDIO_ACTION_BASS_UP);
+  drawToneRow(145, "Mid", config.eqMid, AUDIO_ACTION_MID_DOWN, AUDIO_ACTION_MID_UP);
+  drawToneRow(180, "Treble", config.eqTreble, AUDIO_ACTION_TREBLE_DOWN, AUDIO_ACTION_TREBLE_UP);
+  
+  Display.drawButton(120, 214, 80, 24, "Flat", COLOR_BUTTON, COLOR_TEXT);
+  Button flatBtn = {120, 214, 80, 24, "Flat", AUDIO_ACTION_FLAT, true};
+  buttons.push_back(flatBtn);
 }
 
 void UIManagerClass::showAboutScreen() {
@@ -277,18 +305,44 @@ void UIManagerClass::showAboutScreen() {
 // ============================================================================
 
 void UIManagerClass::updateHomeScreen() {
-  // Refresh if needed
+  refreshStationCards();
 }
 
 void UIManagerClass::updateFolderView() {
-  // Refresh if needed
+  refreshStationCards();
 }
 
 void UIManagerClass::updatePlayerScreen() {
-  // Update metadata display
-  if (AudioPlayer.hasMetadata()) {
+  // Time behind live ticks while paused; redraw its button once a second
+  uint32_t behindS = AudioPlayer.getTimeBehindMs() / 1000;
+  if (behindS != drawnBehindS) {
+    drawnBehindS = behindS;
+    drawLiveButton(200, 180, 50, behindS);
+  }
+  
+  // Cheap poll: nothing to draw unless the metadata or link state moved
+  uint32_t version = AudioPlayer.getMetadataVersion();
+  bool reconnecting = AudioPlayer.isReconnecting();
+  if (version == drawnMetadataVersion && reconnecting == drawnReconnecting) {
+    return;
+  }
+  drawnMetadataVersion = version;
+  drawnReconnecting = reconnecting;
+  
+  // Stream dropped; the audio task is retrying in the background
+  if (reconnecting) {
     Display.fillRect(0, 140, SCREEN_WIDTH, 40, COLOR_BACKGROUND);
-    drawMetadata(140, AudioPlayer.getTitle(), AudioPlayer.getArtist());
+    drawMetadata(140, "Reconnecting...", "");
+    return;
+  }
+  
+  // Update metadata display (one consistent snapshot)
+  StreamMetadata metadata = AudioPlayer.getMetadata();
+  Display.fillRect(0, 140, SCREEN_WIDTH, 40, COLOR_BACKGROUND);
+  if (metadata.title.length() > 0) {
+    drawMetadata(140, metadata.title, metadata.artist);
+  } else {
+    Display.drawCenteredText("Connecting...", 150, COLOR_TEXT_DIM, 1);
   }
 }
 
@@ -374,6 +428,19 @@ int UIManagerClass::checkSettingsTouch(TouchPoint point) {
   return SETTINGS_ACTION_NONE;
 }
 
+int UIManagerClass::checkAudioSettingsTouch(TouchPoint point) {
+  if (isPointInRect(point, 5, 5, 35, 35)) {
+    return AUDIO_ACTION_BACK;
+  }
+  
+  int btnIdx = getTouchedButton(point);
+  if (btnIdx >= 0) {
+    return buttons[btnIdx].action;
+  }
+  
+  return AUDIO_ACTION_NONE;
+}
+
 int UIManagerClass::checkFolderViewTouch(TouchPoint point) {
   return checkHomeScreenTouch(point);
 }
@@ -485,6 +552,38 @@ void UIManagerClass::drawStationCard(int x, int y, int w, int h, Station* statio
   
   // Draw station name
   Display.drawText(station->name, x + 35, y + 12, COLOR_TEXT, 1);
+  
+  // Background check: dead stations flagged, live ones preview their title
+  ProbeResult probe;
+  if (!StationProber.getResult(station->url, probe)) {
+    return;
+  }
+  if (probe.state == PROBE_DEAD) {
+    Display.fillCircle(x + w - 12, y + h / 2, 4, COLOR_ERROR);
+    Display.drawText("Offline", x + 35, y + 25, COLOR_ERROR, 1);
+  } else if (probe.state == PROBE_ALIVE) {
+    Display.fillCircle(x + w - 12, y + h / 2, 4, COLOR_SUCCESS);
+    if (probe.title[0] != '\0') {
+      Display.drawText(probe.title, x + 35, y + 25, COLOR_TEXT_DIM, 1);
+    }
+  }
+}
+
+void UIManagerClass::refreshStationCards() {
+  // Cheap poll: only redraw once a check has finished
+  uint32_t version = StationProber.version();
+  if (version == drawnProbeVersion) {
+    return;
+  }
+  drawnProbeVersion = version;
+  
+  auto stations = StationManager.getCurrentStations();
+  for (const Button& btn : buttons) {
+    int index = btn.action - 1000;
+    if (index >= 0 && index < (int)stations.size()) {
+      drawStationCard(btn.x, btn.y, btn.w, btn.h, stations[index]);
+    }
+  }
 }
 
 void UIManagerClass::drawFolderCard(int x, int y, int w, int h, Folder* folder, bool pressed) {
@@ -533,6 +632,20 @@ void UIManagerClass::drawMetadata(int y, const String& title, const String& arti
   }
 }
 
+void UIManagerClass::drawToneRow(int y, const String& label, int gainDb, int downAction, int upAction) {
+  Display.drawText(label, 20, y + 8, COLOR_TEXT, 1);
+  
+  Display.drawButton(140, y, 40, 30, "-", COLOR_BUTTON, COLOR_TEXT);
+  String value = String(gainDb > 0 ? "+" : "") + String(gainDb) + " dB";
+  Display.drawText(value, 195, y + 8, gainDb == 0 ? COLOR_TEXT_DIM : COLOR_PRIMARY, 1);
+  Display.drawButton(260, y, 40, 30, "+", COLOR_BUTTON, COLOR_TEXT);
+  
+  Button downBtn = {140, y, 40, 30, "-", downAction, true};
+  Button upBtn = {260, y, 40, 30, "+", upAction, true};
+  buttons.push_back(downBtn);
+  buttons.push_back(upBtn);
+}
+
 void UIManagerClass::drawVolumeControl(int x, int y, int w, int volume) {
   // Draw volume icon
   Display.drawIcon(x, y - 20, "🔊", COLOR_TEXT, 1);
@@ -545,6 +658,19 @@ void UIManagerClass::drawVolumeControl(int x, int y, int w, int volume) {
   Display.drawText(volText, x + w + 10, y + 5, COLOR_TEXT, 1);
 }
 
+void UIManagerClass::drawLiveButton(int x, int y, int size, uint32_t behindS) {
+  if (behindS == 0) {
+    Display.drawButton(x, y, size, size, "LIVE", COLOR_BUTTON, COLOR_TEXT_DIM);
+    return;
+  }
+  
+  // "-m:ss" behind live; tapping it jumps back
+  char label[12];
+  snprintf(label, sizeof(label), "-%lu:%02lu", (unsigned long)(behindS / 60),
+           (unsigned long)(behindS % 60));
+  Display.drawButton(x, y, size, size, label, COLOR_SECONDARY, COLOR_TEXT);
+}
+
 bool UIManagerClass::isPointInRect(TouchPoint point, int x, int y, int w, int h) {
   return point.x >= x && point.x < x + w && point.y >= y && point.y < y + h;
 }
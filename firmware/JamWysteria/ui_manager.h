@@ -54,6 +54,7 @@ public:
   int checkHomeScreenTouch(TouchPoint point);
   int checkPlayerTouch(TouchPoint point);
   int checkSettingsTouch(TouchPoint point);
+  int checkAudioSettingsTouch(TouchPoint point);
   int checkFolderViewTouch(TouchPoint point);
   int checkAddMenuTouch(TouchPoint point);
   
@@ -85,6 +86,14 @@ private:
   int scrollPosition;
   int selectedIndex;
   
+  // Player screen (redrawn only when these change)
+  uint32_t drawnMetadataVersion;
+  bool drawnReconnecting;
+  uint32_t drawnBehindS;          // Time-shift shown on the live button
+  
+  // Station list (cards redrawn when a background check finishes)
+  uint32_t drawnProbeVersion;
+  
   // Buttons
   std::vector<Button> buttons;
   
@@ -98,10 +107,13 @@ private:
   void drawAddButton();
   void drawList(std::vector<String> items, std::vector<String> icons, int startY);
   void drawStationCard(int x, int y, int w, int h, Station* station, bool pressed = false);
+  void refreshStationCards();
   void drawFolderCard(int x, int y, int w, int h, Folder* folder, bool pressed = false);
   void drawWiFiNetwork(int x, int y, int w, const String& ssid, int rssi, bool secure);
   void drawMetadata(int y, const String& title, const String& artist);
   void drawVolumeControl(int x, int y, int w, int volume);
+  void drawLiveButton(int x, int y, int size, uint32_t behindS);
+  void drawToneRow(int y, const String& label, int gainDb, int downAction, int upAction);
   
   // Touch helpers
   bool isPointInRect(TouchPoint point, int x, int y, int w, int h);
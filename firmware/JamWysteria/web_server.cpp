@@ -6,7 +6,14 @@
 #include "station_manager.h"
 #include "wifi_manager.h"
 #include "sd_manager.h"
+#include "sd_block_cache.h"
+#include "audio_pipeline.h"
+#include "connection_cache.h"
+#include "audio_player.h"
+#include "stream_recorder.h"
+#include "station_prober.h"
 #include <ArduinoJson.h>
+#include <esp_timer.h>
 
 // Global instance
 WebServerClass WebServer;
@@ -119,10 +126,37 @@ void WebServerClass::setupRoutes() {
     this->handleAPIRestart(request);
   });
   
+  // API endpoints - Audio telemetry
+  server->on("/api/audio/stats", HTTP_GET, [this](AsyncWebServerRequest* request) {
+    this->handleAPIGetAudioStats(request);
+  });
+  
+  server->on("/api/audio/stats/reset", HTTP_POST, [this](AsyncWebServerRequest* request) {
+    this->handleAPIResetAudioStats(request);
+  });
+  
+  // API endpoints - Recording
+  server->on("/api/record", HTTP_GET, [this](AsyncWebServerRequest* request) {
+    this->handleAPIGetRecording(request);
+  });
+  
+  server->on("/api/record/start", HTTP_POST, [this](AsyncWebServerRequest* request) {
+    this->handleAPIStartRecording(request);
+  });
+  
+  server->on("/api/record/stop", HTTP_POST, [this](AsyncWebServerRequest* request) {
+    this->handleAPIStopRecording(request);
+  });
+  
+  // API endpoints - Background station checks
+  server->on("/api/probe", HTTP_GET, [this](AsyncWebServerRequest* request) {
+    this->handleAPIGetProbes(request);
+  });
+  
   // File upload handler
   server->on("/api/upload", HTTP_POST,
-    [](AsyncWebServerRequest* request) {
-      request->send(200, "application/json", "{\"success\":true}");
+    [this](AsyncWebServerRequest* request) {
+      this->handleUploadComplete(request);
     },
     [this](AsyncWebServerRequest* request, String filename, size_t index, 
            uint8_t* data, size_t len, bool final) {
@@ -415,7 +449,7 @@ void WebServerClass::handleAPIExport(AsyncWebServerRequest* request) {
 }
 
 void WebServerClass::handleAPIGetConfig(AsyncWebServerRequest* request) {
-  DynamicJsonDocument doc(1024);
+  DynamicJsonDocument doc(2048);
   
   doc["ipAddress"] = WiFiManager.getIPAddress();
   doc["ssid"] = WiFiManager.getSSID();
@@ -430,6 +464,59 @@ void WebServerClass::handleAPIGetConfig(AsyncWebServerRequest* request) {
   
   doc["volume"] = SDManager.getConfig().volume;
   doc["brightness"] = SDManager.getConfig().brightness;
+  doc["bufferProfile"] = SDManager.getConfig().bufferProfile;
+  doc["eqBass"] = SDManager.getConfig().eqBass;
+  doc["eqMid"] = SDManager.getConfig().eqMid;
+  doc["eqTreble"] = SDManager.getConfig().eqTreble;
+  
+  SDBlockCacheStats cache = SDBlockCache.getStats();
+  JsonObject cacheObj = doc.createNestedObject("sdCache");
+  cacheObj["enabled"] = SDBlockCache.isEnabled();
+  cacheObj["capacity"] = cache.capacity;
+  cacheObj["hits"] = cache.hits;
+  cacheObj["misses"] = cache.misses;
+  cacheObj["readAheads"] = cache.readAheads;
+  cacheObj["bypassed"] = cache.bypassed;
+  cacheObj["writes"] = cache.writes;
+  
+  AudioPipelineLevels levels = AudioPipeline.getLevels();
+  JsonObject jitterObj = doc.createNestedObject("jitterBuffer");
+  jitterObj["profile"] = AudioPipeline.getBufferProfileName(levels.bufferProfile);
+  jitterObj["depthMs"] = levels.depthMs;
+  jitterObj["targetMs"] = levels.targetMs;
+  jitterObj["jitterMs"] = levels.jitterMs;
+  jitterObj["underruns"] = levels.streamUnderruns;
+  jitterObj["rebuffering"] = levels.rebuffering;
+  
+  JsonObject eqObj = doc.createNestedObject("toneControl");
+  eqObj["stages"] = levels.eqStages;
+  eqObj["cpuLoad"] = levels.eqLoad / 10.0f;
+  
+  JsonObject resampleObj = doc.createNestedObject("resampler");
+  resampleObj["streamRate"] = levels.sampleRate;
+  resampleObj["outputRate"] = levels.outputRate;
+  resampleObj["driftPpm"] = levels.driftPpm;
+  resampleObj["cpuLoad"] = levels.resampleLoad / 10.0f;
+  
+  JsonObject loudnessObj = doc.createNestedObject("loudness");
+  loudnessObj["targetLufs"] = LOUDNESS_TARGET_LUFS;
+  loudnessObj["shortTermLufs"] = roundf(levels.loudness * 10.0f) / 10.0f;
+  loudnessObj["gainDb"] = roundf(levels.loudnessGainDb * 10.0f) / 10.0f;
+  loudnessObj["settled"] = levels.loudnessSettled;
+  
+  ConnectionCacheStats cache = ConnectionCache.getStats();
+  uint32_t lookups = cache.dnsHits + cache.dnsMisses;
+  uint32_t tunes = cache.paramHits + cache.paramMisses;
+  JsonObject cacheObj = doc.createNestedObject("connectionCache");
+  cacheObj["hosts"] = cache.hosts;
+  cacheObj["dnsHits"] = cache.dnsHits;
+  cacheObj["dnsMisses"] = cache.dnsMisses;
+  cacheObj["dnsFailures"] = cache.dnsFailures;
+  cacheObj["dnsHitRate"] = lookups > 0 ? (float)cache.dnsHits / lookups : 0.0f;
+  cacheObj["streams"] = cache.params;
+  cacheObj["paramHits"] = cache.paramHits;
+  cacheObj["paramMisses"] = cache.paramMisses;
+  cacheObj["paramHitRate"] = tunes > 0 ? (float)cache.paramHits / tunes : 0.0f;
   
   String json;
   serializeJson(doc, json);
@@ -448,6 +535,31 @@ void WebServerClass::handleAPISetConfig(AsyncWebServerRequest* request) {
     config.brightness = request->getParam("brightness", true)->value().toInt();
   }
   
+  if (request->hasParam("bufferProfile", true)) {
+    int profile = request->getParam("bufferProfile", true)->value().toInt();
+    if (profile >= 0 && profile < BUFFER_PROFILE_COUNT) {
+      config.bufferProfile = profile;
+      AudioPipeline.setBufferProfile(profile);
+    }
+  }
+  
+  bool toneChanged = false;
+  if (request->hasParam("eqBass", true)) {
+    config.eqBass = constrain(request->getParam("eqBass", true)->value().toInt(), EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+    toneChanged = true;
+  }
+  if (request->hasParam("eqMid", true)) {
+    config.eqMid = constrain(request->getParam("eqMid", true)->value().toInt(), EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+    toneChanged = true;
+  }
+  if (request->hasParam("eqTreble", true)) {
+    config.eqTreble = constrain(request->getParam("eqTreble", true)->value().toInt(), EQ_GAIN_MIN_DB, EQ_GAIN_MAX_DB);
+    toneChanged = true;
+  }
+  if (toneChanged) {
+    AudioPipeline.setEqualizer(config.eqBass, config.eqMid, config.eqTreble);
+  }
+  
   SDManager.setConfig(config);
   
   request->send(200, "application/json", "{\"success\":true}");
@@ -498,26 +610,248 @@ void WebServerClass::handleAPIRestart(AsyncWebServerRequest* request) {
   ESP.restart();
 }
 
+void WebServerClass::handleAPIGetAudioStats(AsyncWebServerRequest* request) {
+  AudioTelemetry telemetry = AudioPlayer.getTelemetry();
+  AudioTaskStats task = AudioPlayer.getTaskStats();
+  AudioPipelineLevels levels = AudioPipeline.getLevels();
+  DynamicJsonDocument doc(4096);
+  
+  doc["sinceMs"] = telemetry.sinceMs;
+  doc["playing"] = AudioPlayer.isPlaying();
+  doc["connected"] = AudioPlayer.isConnected();
+  doc["reconnecting"] = AudioPlayer.isReconnecting();
+  doc["error"] = AudioPlayer.getError();
+  
+  JsonObject network = doc.createNestedObject("network");
+  network["bytesReceived"] = telemetry.bytesReceived;
+  network["measuredKbps"] = telemetry.measuredKbps;
+  network["advertisedKbps"] = telemetry.advertisedKbps;
+  network["decoderKbps"] = telemetry.decoderKbps;
+  network["connects"] = telemetry.connects;
+  network["reconnects"] = telemetry.reconnects;
+  network["failures"] = telemetry.failures;
+  
+  JsonObject decoder = doc.createNestedObject("decoder");
+  decoder["cycles"] = telemetry.decodeCycles;
+  decoder["load"] = telemetry.decodeLoad / 10.0f;
+  addHistogram(decoder, "decodeCycleUs", telemetry.decodeCycleUs);
+  decoder["taskOverruns"] = task.overruns;
+  decoder["taskMinSlackUs"] = task.minSlackUs;
+  decoder["taskStackFree"] = task.stackFree;
+  
+  JsonObject buffer = doc.createNestedObject("buffer");
+  buffer["i2sUnderruns"] = telemetry.i2sUnderruns;
+  buffer["streamUnderruns"] = telemetry.streamUnderruns;
+  buffer["depthMs"] = levels.depthMs;
+  buffer["targetMs"] = levels.targetMs;
+  buffer["timeShiftMs"] = levels.timeShiftMs;
+  buffer["timeShiftBytes"] = levels.timeShiftBytes;
+  buffer["pcmFill"] = levels.pcmFill;
+  buffer["pcmSize"] = levels.pcmSize;
+  addHistogram(buffer, "fillMs", telemetry.fillMs);
+  JsonArray history = buffer.createNestedArray("fillHistoryMs");
+  for (int i = 0; i < telemetry.fillHistoryCount; i++) {
+    history.add(telemetry.fillHistory[i]);
+  }
+  
+  String json;
+  serializeJson(doc, json);
+  
+  request->send(200, "application/json", json);
+}
+
+void WebServerClass::handleAPIResetAudioStats(AsyncWebServerRequest* request) {
+  AudioPlayer.resetTelemetry();
+  AudioPlayer.resetTaskStats();
+  request->send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerClass::handleAPIGetRecording(AsyncWebServerRequest* request) {
+  RecorderStatus status = StreamRecorder.getStatus();
+  DynamicJsonDocument doc(512);
+  
+  doc["available"] = StreamRecorder.isReady();
+  doc["recording"] = status.recording;
+  doc["splitTracks"] = status.splitTracks;
+  doc["path"] = status.path;
+  doc["files"] = status.files;
+  doc["bytesWritten"] = status.bytesWritten;
+  doc["bytesDropped"] = status.bytesDropped;
+  doc["backlog"] = status.backlog;
+  doc["elapsedMs"] = status.elapsedMs;
+  
+  // What recording costs: fetch task CPU, SD busy time and bandwidth
+  uint32_t elapsedMs = max(status.elapsedMs, (uint32_t)1);
+  doc["teeLoad"] = status.teeUs / 10.0f / elapsedMs;
+  doc["sdBusy"] = status.writeUs / 10.0f / elapsedMs;
+  doc["sdKbps"] = (uint32_t)((uint64_t)status.bytesWritten * 8 / elapsedMs);
+  
+  String json;
+  serializeJson(doc, json);
+  
+  request->send(200, "application/json", json);
+}
+
+void WebServerClass::handleAPIStartRecording(AsyncWebServerRequest* request) {
+  bool split = request->hasParam("split", true) && request->getParam("split", true)->value() == "true";
+  
+  if (!AudioPlayer.startRecording(split)) {
+    request->send(400, "application/json", "{\"error\":\"Not playing a live stream, or already recording\"}");
+    return;
+  }
+  request->send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerClass::handleAPIStopRecording(AsyncWebServerRequest* request) {
+  AudioPlayer.stopRecording();
+  request->send(200, "application/json", "{\"success\":true}");
+}
+
+void WebServerClass::handleAPIGetProbes(AsyncWebServerRequest* request) {
+  // ?url= also queues a check of that station
+  if (request->hasParam("url")) {
+    StationProber.request(request->getParam("url")->value());
+  }
+  
+  std::vector<ProbeEntry> entries = StationProber.getResults();
+  static const char* const states[] = {"unknown", "pending", "alive", "dead"};
+  uint32_t now = (uint32_t)(esp_timer_get_time() / 1000000);
+  DynamicJsonDocument doc(1024 + entries.size() * 384);
+  
+  JsonArray list = doc.createNestedArray("stations");
+  for (const ProbeEntry& entry : entries) {
+    JsonObject obj = list.createNestedObject();
+    obj["url"] = entry.url;
+    obj["state"] = states[entry.result.state];
+    if (entry.result.state == PROBE_ALIVE || entry.result.state == PROBE_DEAD) {
+      obj["latencyMs"] = entry.result.latencyMs;
+      obj["codec"] = entry.result.codec;
+      obj["bitrate"] = entry.result.bitrate;
+      obj["title"] = entry.result.title;
+      obj["ageS"] = now - entry.result.checkedAt;
+    }
+  }
+  
+  String json;
+  serializeJson(doc, json);
+  
+  request->send(200, "application/json", json);
+}
+
+void WebServerClass::addHistogram(JsonObject parent, const char* name, const TelemetryHistogram& histogram) {
+  // Bucket n counts values below 2^n (and at least 2^(n-1))
+  JsonObject obj = parent.createNestedObject(name);
+  obj["count"] = histogram.count;
+  obj["mean"] = histogram.mean();
+  obj["p50"] = histogram.percentile(50);
+  obj["p95"] = histogram.percentile(95);
+  obj["p99"] = histogram.percentile(99);
+  obj["max"] = histogram.max;
+  
+  JsonArray buckets = obj.createNestedArray("buckets");
+  for (int i = 0; i < TELEMETRY_BUCKETS; i++) {
+    buckets.add(histogram.buckets[i]);
+  }
+}
+
 void WebServerClass::handleFileUpload(AsyncWebServerRequest* request, String filename, 
                                       size_t index, uint8_t* data, size_t len, bool final) {
-  static File uploadFile;
+  UploadContext* ctx = nullptr;
   
   if (index == 0) {
     Serial.printf("[WEB] Upload started: %s\n", filename.c_str());
-    String path = "/logos/" + filename;
-    uploadFile = SD.open(path.c_str(), FILE_WRITE);
+    
+    // A retried first chunk replaces any stale context
+    releaseUpload(request, true);
+    
+    ctx = new UploadContext();
+    ctx->filename = filename;
+    ctx->startTime = millis();
+    ctx->finished = false;
+    ctx->failed = false;
+    uploads[request] = ctx;
+    
+    String path = String(SD_LOGOS_DIR) + "/" + filename;
+    ctx->writer.open(path, UPLOAD_BUFFER_SIZE, UPLOAD_MAX_SIZE);
+    
+    // Drop the partial file if the client goes away mid-upload
+    request->onDisconnect([this, request]() {
+      this->releaseUpload(request, true);
+    });
+  } else {
+    auto it = uploads.find(request);
+    if (it != uploads.end()) {
+      ctx = it->second;
+    }
   }
   
-  if (uploadFile) {
-    uploadFile.write(data, len);
+  if (ctx == nullptr || ctx->finished) {
+    return;
+  }
+  
+  if (ctx->writer.isOpen() && len > 0) {
+    ctx->writer.write(data, len);
   }
   
   if (final) {
-    if (uploadFile) {
-      uploadFile.close();
+    ctx->finished = true;
+    
+    if (ctx->writer.limitExceeded() || ctx->writer.hasError() || !ctx->writer.close()) {
+      ctx->failed = true;
+      ctx->writer.abort();
+      Serial.printf("[WEB] ✗ Upload failed: %s\n", filename.c_str());
+      return;
     }
-    Serial.printf("[WEB] Upload complete: %s (%d bytes)\n", filename.c_str(), index + len);
+    
+    unsigned long elapsed = millis() - ctx->startTime;
+    size_t size = ctx->writer.getSize();
+    float kbps = elapsed > 0 ? (size / 1024.0f) / (elapsed / 1000.0f) : 0.0f;
+    
+    Serial.printf("[WEB] Upload complete: %s (%u bytes, %lu ms, %.1f KB/s, CRC32 %08X)\n",
+                  filename.c_str(), size, elapsed, kbps, ctx->writer.getCRC32());
+  }
+}
+
+void WebServerClass::handleUploadComplete(AsyncWebServerRequest* request) {
+  auto it = uploads.find(request);
+  if (it == uploads.end()) {
+    request->send(400, "application/json", "{\"success\":false,\"error\":\"No file received\"}");
+    return;
   }
+  
+  UploadContext* ctx = it->second;
+  
+  if (!ctx->finished) {
+    request->send(400, "application/json", "{\"success\":false,\"error\":\"Incomplete upload\"}");
+  } else if (ctx->writer.limitExceeded()) {
+    request->send(413, "application/json", "{\"success\":false,\"error\":\"File too large\"}");
+  } else if (ctx->failed) {
+    request->send(500, "application/json", "{\"success\":false,\"error\":\"Write failed\"}");
+  } else {
+    char response[96];
+    snprintf(response, sizeof(response), "{\"success\":true,\"size\":%u,\"crc32\":\"%08X\"}",
+             ctx->writer.getSize(), ctx->writer.getCRC32());
+    request->send(200, "application/json", response);
+  }
+  
+  releaseUpload(request, false);
+}
+
+void WebServerClass::releaseUpload(AsyncWebServerRequest* request, bool discard) {
+  auto it = uploads.find(request);
+  if (it == uploads.end()) {
+    return;
+  }
+  
+  UploadContext* ctx = it->second;
+  uploads.erase(it);
+  
+  if (discard && !ctx->finished) {
+    ctx->writer.abort();
+    Serial.printf("[WEB] Upload aborted: %s\n", ctx->filename.c_str());
+  }
+  
+  delete ctx;
 }
 
 // ============================================================================
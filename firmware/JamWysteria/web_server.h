@@ -9,7 +9,20 @@
 
 #include <ESPAsyncWebServer.h>
 #include <AsyncTCP.h>
+#include <map>
+#include <ArduinoJson.h>
 #include "config.h"
+#include "buffered_writer.h"
+#include "audio_telemetry.h"
+
+// Per-request upload state
+struct UploadContext {
+  BufferedFileWriter writer;
+  String filename;
+  unsigned long startTime;
+  bool finished;
+  bool failed;
+};
 
 class WebServerClass {
 public:
@@ -30,6 +43,9 @@ private:
   AsyncWebServer* server;
   bool running;
   
+  // Active uploads (all callbacks run on the AsyncTCP task)
+  std::map<AsyncWebServerRequest*, UploadContext*> uploads;
+  
   // Route handlers
   void setupRoutes();
   
@@ -53,12 +69,21 @@ private:
   void handleAPIGetWiFiNetworks(AsyncWebServerRequest* request);
   void handleAPISetWiFi(AsyncWebServerRequest* request);
   void handleAPIRestart(AsyncWebServerRequest* request);
+  void handleAPIGetAudioStats(AsyncWebServerRequest* request);
+  void handleAPIResetAudioStats(AsyncWebServerRequest* request);
+  void handleAPIGetRecording(AsyncWebServerRequest* request);
+  void handleAPIStartRecording(AsyncWebServerRequest* request);
+  void handleAPIStopRecording(AsyncWebServerRequest* request);
+  void handleAPIGetProbes(AsyncWebServerRequest* request);
   
-  // File upload handler
+  // File upload handlers
   void handleFileUpload(AsyncWebServerRequest* request, String filename, 
                        size_t index, uint8_t* data, size_t len, bool final);
+  void handleUploadComplete(AsyncWebServerRequest* request);
+  void releaseUpload(AsyncWebServerRequest* request, bool discard);
   
   // Helper functions
+  void addHistogram(JsonObject parent, const char* name, const TelemetryHistogram& histogram);
   String getContentType(const String& filename);
   String generateHTML(const String& title, const String& content);
   String generateStationManagerHTML();
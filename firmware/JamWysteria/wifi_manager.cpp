@@ -15,7 +15,8 @@ WiFiManagerClass::WiFiManagerClass() :
   networkCount(0),
   connected(false),
   lastConnectionAttempt(0),
-  reconnectAttempts(0) {
+  reconnectAttempts(0),
+  connectPending(false) {
 }
 
 void WiFiManagerClass::init() {
@@ -30,6 +31,17 @@ void WiFiManagerClass::init() {
   Serial.println(getMACAddress());
 }
 
+void WiFiManagerClass::begin() {
+  if (!hasCredentials()) {
+    return;
+  }
+  
+  // Start associating now; connect() later waits on this attempt
+  Serial.printf("[WIFI] Starting connection to: %s\n", savedSSID.c_str());
+  WiFi.begin(savedSSID.c_str(), savedPassword.c_str());
+  connectPending = true;
+}
+
 bool WiFiManagerClass::connect() {
   if (!hasCredentials()) {
     Serial.println("[WIFI] No credentials stored");
@@ -42,7 +54,11 @@ bool WiFiManagerClass::connect() {
 bool WiFiManagerClass::connect(const String& ssid, const String& password) {
   Serial.printf("[WIFI] Connecting to: %s\n", ssid.c_str());
   
-  WiFi.begin(ssid.c_str(), password.c_str());
+  // Join an attempt already started by begin() instead of restarting it
+  if (!connectPending || ssid != savedSSID || password != savedPassword) {
+    WiFi.begin(ssid.c_str(), password.c_str());
+  }
+  connectPending = false;
   
   if (waitForConnection(WIFI_CONNECT_TIMEOUT)) {
     connected = true;
@@ -75,7 +91,7 @@ bool WiFiManagerClass::isConnected() {
 
 void WiFiManagerClass::update() {
   // Check connection status
-  if (credentialsStored && !isConnected() && reconnectAttempts < STREAM_MAX_RECONNECTS) {
+  if (credentialsStored && !isConnected() && reconnectAttempts < WIFI_MAX_RECONNECTS) {
     unsigned long now = millis();
     
     if (now - lastConnectionAttempt > WIFI_RECONNECT_DELAY) {
@@ -87,7 +103,7 @@ void WiFiManagerClass::update() {
         Serial.println("[WIFI] Reconnected successfully");
       } else {
         Serial.printf("[WIFI] Reconnect attempt %d/%d failed\n", 
-                     reconnectAttempts, STREAM_MAX_RECONNECTS);
+                     reconnectAttempts, WIFI_MAX_RECONNECTS);
       }
     }
   }
@@ -102,8 +118,12 @@ void WiFiManagerClass::saveCredentials(const String& ssid, const String& passwor
   savedPassword = password;
   credentialsStored = true;
   
-  // Save to SD card config
-  // This will be handled by SDManager
+  // Persist to flash and SD card config
+  AppConfig& config = SDManager.getConfig();
+  config.wifiSSID = ssid;
+  config.wifiPassword = password;
+  SDManager.saveConfig();
+  
   Serial.printf("[WIFI] Credentials saved for: %s\n", ssid.c_str());
 }
 
@@ -112,6 +132,11 @@ void WiFiManagerClass::clearCredentials() {
   savedPassword = "";
   credentialsStored = false;
   
+  AppConfig& config = SDManager.getConfig();
+  config.wifiSSID = "";
+  config.wifiPassword = "";
+  SDManager.saveConfig();
+  
   Serial.println("[WIFI] Credentials cleared");
 }
 
@@ -188,11 +213,31 @@ void WiFiManagerClass::setHostname(const String& hostname) {
   WiFi.setHostname(hostname.c_str());
 }
 
+bool WiFiManagerClass::reloadCredentials() {
+  String oldSSID = savedSSID;
+  String oldPassword = savedPassword;
+  
+  loadCredentials();
+  
+  if (savedSSID == oldSSID && savedPassword == oldPassword) {
+    return false;
+  }
+  
+  // Credentials were edited on the SD card; drop the flash-based attempt
+  Serial.println("[WIFI] Credentials changed on SD card");
+  if (connectPending) {
+    WiFi.disconnect();
+    connectPending = false;
+  }
+  return true;
+}
+
 void WiFiManagerClass::loadCredentials() {
-  // Load credentials from SD card
-  // This will be implemented when SDManager is ready
-  // For now, check if stored in memory
-  credentialsStored = false;
+  // Config comes from flash at boot and from the SD card once mounted
+  AppConfig& config = SDManager.getConfig();
+  savedSSID = config.wifiSSID;
+  savedPassword = config.wifiPassword;
+  credentialsStored = savedSSID.length() > 0;
 }
 
 void WiFiManagerClass::encryptPassword(String& password) {
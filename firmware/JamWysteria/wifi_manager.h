@@ -18,6 +18,7 @@ public:
   void init();
   
   // Connection management
+  void begin();                         // Non-blocking, uses stored credentials
   bool connect();
   bool connect(const String& ssid, const String& password);
   void disconnect();
@@ -28,6 +29,7 @@ public:
   bool hasCredentials();
   void saveCredentials(const String& ssid, const String& password);
   void clearCredentials();
+  bool reloadCredentials();             // Returns true if they changed
   String getSSID();
   String getPassword();
   
@@ -57,6 +59,7 @@ private:
   bool connected;
   unsigned long lastConnectionAttempt;
   int reconnectAttempts;
+  bool connectPending;
   
   // Helper functions
   void loadCredentials();
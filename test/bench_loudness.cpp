@@ -0,0 +1,59 @@
+/**
+ * Loudness meter host benchmark
+ *
+ * Reads sine tones at known levels through LoudnessMeter (100 ms
+ * blocks, 3 s window, as the output task configures it) and prints
+ * the short-term loudness next to the level, then the metering
+ * throughput in stereo frames per second.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "loudness_meter.h"
+
+static std::vector<int16_t> tone(uint32_t rate, double hz, double dbfs, double seconds) {
+  std::vector<int16_t> samples((size_t)(rate * seconds) * 2);
+  double amplitude = 32767 * pow(10.0, dbfs / 20.0);
+  for (size_t n = 0; n < samples.size() / 2; n++) {
+    int16_t value = (int16_t)lround(amplitude * sin(2 * M_PI * hz * n / rate));
+    samples[n * 2] = value;
+    samples[n * 2 + 1] = value;
+  }
+  return samples;
+}
+
+static float measure(const std::vector<int16_t>& samples, uint32_t rate) {
+  LoudnessMeter meter;
+  meter.configure(rate, 100, 30);
+  for (size_t i = 0; i < samples.size() / 2; i += 256) {
+    size_t count = samples.size() / 2 - i < 256 ? samples.size() / 2 - i : 256;
+    meter.process(samples.data() + i * 2, count);
+  }
+  return meter.getShortTerm();
+}
+
+int main() {
+  const uint32_t rate = 44100;
+  
+  // Near 1 kHz the reading tracks the level; K-weighting lifts the
+  // highs and cuts the lows
+  const double levels[] = {-10, -20, -30};
+  const double pitches[] = {100, 997, 5000};
+  for (double hz : pitches) {
+    for (double dbfs : levels) {
+      float lufs = measure(tone(rate, hz, dbfs, 5.0), rate);
+      printf("%5.0f Hz at %5.1f dBFS: %6.2f LUFS\n", hz, dbfs, lufs);
+    }
+  }
+  
+  // Throughput over a long programme
+  std::vector<int16_t> samples = tone(rate, 997, -20, 60.0);
+  auto start = std::chrono::steady_clock::now();
+  float lufs = measure(samples, rate);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("metering: %.1fM frames/s (%.2f LUFS)\n", samples.size() / 2 / seconds / 1e6, lufs);
+  return 0;
+}
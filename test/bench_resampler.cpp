@@ -0,0 +1,140 @@
+/**
+ * Polyphase resampler host benchmark
+ *
+ * Quality: a sine goes through PolyphaseResampler at each rate pair
+ * (and with a drift nudge), a sine of the expected frequency is
+ * least-squares fitted to the output, and the gain and the SNR of
+ * the fit are printed. Throughput: stereo output frames per second
+ * for 44.1 -> 48 kHz.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include "polyphase_resampler.h"
+
+#define TONE_LEVEL 16000.0
+
+// Left channel of a resampled sine (stereo in, left read back)
+static std::vector<double> resample(uint32_t inRate, uint32_t outRate, int32_t ppm, double hz,
+                                    double seconds) {
+  PolyphaseResampler resampler;
+  resampler.configure(inRate, outRate);
+  resampler.setAdjust(ppm);
+  resampler.reset();
+  
+  std::vector<double> out;
+  int16_t frames[256 * 2];
+  size_t total = (size_t)(inRate * seconds);
+  size_t n = 0;
+  while (n < total) {
+    size_t room = resampler.space();
+    int16_t* input = resampler.inputBuffer();
+    size_t count = 0;
+    for (; count < room && n < total; count++, n++) {
+      int16_t value = (int16_t)lround(TONE_LEVEL * sin(2 * M_PI * hz * n / inRate));
+      input[count * 2] = value;
+      input[count * 2 + 1] = value;
+    }
+    resampler.commit(count);
+    
+    size_t produced;
+    while ((produced = resampler.process(frames, 256)) > 0) {
+      for (size_t i = 0; i < produced; i++) {
+        out.push_back(frames[i * 2]);
+      }
+    }
+  }
+  return out;
+}
+
+// Fit a*sin + b*cos + c at a known frequency; gain in dB and SNR
+static void fitSine(const std::vector<double>& x, double hz, uint32_t rate, double& gainDb,
+                    double& snrDb) {
+  // Normal equations over the steady part (filter warm-up skipped)
+  double m[3][4] = {};
+  size_t start = RESAMPLE_TAPS * 4;
+  for (size_t n = start; n < x.size(); n++) {
+    double basis[3] = {sin(2 * M_PI * hz * n / rate), cos(2 * M_PI * hz * n / rate), 1.0};
+    for (int r = 0; r < 3; r++) {
+      for (int c = 0; c < 3; c++) {
+        m[r][c] += basis[r] * basis[c];
+      }
+      m[r][3] += basis[r] * x[n];
+    }
+  }
+  
+  // Gauss-Jordan on the 3x4 system
+  for (int p = 0; p < 3; p++) {
+    for (int r = 0; r < 3; r++) {
+      if (r != p) {
+        double f = m[r][p] / m[p][p];
+        for (int c = 0; c < 4; c++) {
+          m[r][c] -= f * m[p][c];
+        }
+      }
+    }
+  }
+  double a = m[0][3] / m[0][0];
+  double b = m[1][3] / m[1][1];
+  double dc = m[2][3] / m[2][2];
+  
+  double signal = 0;
+  double noise = 0;
+  for (size_t n = start; n < x.size(); n++) {
+    double fit = a * sin(2 * M_PI * hz * n / rate) + b * cos(2 * M_PI * hz * n / rate) + dc;
+    signal += fit * fit;
+    noise += (x[n] - fit) * (x[n] - fit);
+  }
+  gainDb = 20 * log10(sqrt(a * a + b * b) / TONE_LEVEL);
+  snrDb = 10 * log10(signal / noise);
+}
+
+static void quality(uint32_t inRate, uint32_t outRate, int32_t ppm, double hz) {
+  std::vector<double> out = resample(inRate, outRate, ppm, hz, 2.0);
+  
+  // A nudge of +ppm consumes input faster, raising the pitch
+  double heard = hz * (1.0 + ppm * 1e-6);
+  double gainDb, snrDb;
+  fitSine(out, heard, outRate, gainDb, snrDb);
+  printf("%6.0f Hz  %5u -> %5u Hz %+4d ppm: gain %+6.2f dB, SNR %5.1f dB\n",
+         hz, inRate, outRate, ppm, gainDb, snrDb);
+}
+
+int main() {
+  const uint32_t inputs[] = {22050, 32000, 44100, 48000};
+  const uint32_t outputs[] = {44100, 48000};
+  for (uint32_t out : outputs) {
+    for (uint32_t in : inputs) {
+      quality(in, out, 0, 997);
+    }
+  }
+  quality(44100, 44100, 300, 997);
+  quality(48000, 44100, 0, 15000);
+  quality(44100, 44100, 300, 18000);
+  
+  // In the transition band: strongly attenuated, the SNR is meaningless
+  quality(48000, 44100, 0, 23000);
+  
+  // Throughput
+  PolyphaseResampler resampler;
+  resampler.configure(44100, 48000);
+  resampler.reset();
+  int16_t frames[256 * 2];
+  size_t produced = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < 200000; pass++) {
+    size_t room = resampler.space();
+    int16_t* input = resampler.inputBuffer();
+    for (size_t i = 0; i < room * 2; i++) {
+      input[i] = (int16_t)(i * 7919);
+    }
+    resampler.commit(room);
+    produced += resampler.process(frames, 256);
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("throughput 44.1 -> 48 kHz: %.1fM frames/s (%d)\n", produced / seconds / 1e6, frames[0]);
+  return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * Minimal host test helpers for Jam Wysteria
+ *
+ * Each test is a plain executable: CHECK records failures without
+ * stopping, and HOST_TEST_RESULT() is the exit code ctest reads.
+ */
+
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <cstdio>
+#include <cstring>
+
+static int hostTestFailures = 0;
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_STR(actual, expected) \
+  do { \
+    const char* checkActual = (actual); \
+    const char* checkExpected = (expected); \
+    bool checkSame = checkActual == nullptr || checkExpected == nullptr ? \
+                     checkActual == checkExpected : strcmp(checkActual, checkExpected) == 0; \
+    if (!checkSame) { \
+      printf("FAIL %s:%d: %s is \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, \
+             checkActual ? checkActual : "(null)", checkExpected ? checkExpected : "(null)"); \
+      hostTestFailures++; \
+    } \
+  } while (0)
+
+#define HOST_TEST_RESULT() \
+  (printf("%s: %d failure(s)\n", __FILE__, hostTestFailures), hostTestFailures == 0 ? 0 : 1)
+
+#endif // HOST_TEST_H
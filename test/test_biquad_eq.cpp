@@ -0,0 +1,220 @@
+/**
+ * Biquad equalizer host test
+ *
+ * The Q28 coefficients against the float design at DC and Nyquist,
+ * where every cookbook shape has a known gain; headroom on the tone
+ * control chain as the output task builds it, by running full-scale
+ * sines through it and checking the settled result is still linear;
+ * and the error feedback, against a double precision reference.
+ */
+
+#include <cmath>
+#include <vector>
+#include "biquad_eq.h"
+#include "host_test.h"
+
+// The EQ_* settings on the device
+#define HIGHPASS_HZ 60
+#define BASS_HZ     150
+#define MID_HZ      1000
+#define MID_Q       0.9f
+#define TREBLE_HZ   5000
+#define SHELF_Q     0.707f
+
+#define UNIT ((double)(1 << BIQUAD_COEFF_SHIFT))
+
+static double dcGain(const Biquad& stage) {
+  return ((double)stage.b0 + stage.b1 + stage.b2) / (UNIT + stage.a1 + stage.a2);
+}
+
+static double nyquistGain(const Biquad& stage) {
+  return ((double)stage.b0 - stage.b1 + stage.b2) / (UNIT - stage.a1 + stage.a2);
+}
+
+// Within 0.01 dB, or of zero
+static bool near(double gain, double expected) {
+  if (expected == 0.0) {
+    return fabs(gain) < 1e-4;
+  }
+  return fabs(20 * log10(gain / expected)) < 0.01;
+}
+
+static void buildToneControl(BiquadChain& chain, float rate, int bass, int mid, int treble) {
+  chain.clear();
+  chain.add(BIQUAD_HIGHPASS, HIGHPASS_HZ, 0, SHELF_Q, rate);
+  if (bass != 0) {
+    chain.add(BIQUAD_LOW_SHELF, BASS_HZ, bass, SHELF_Q, rate);
+  }
+  if (mid != 0) {
+    chain.add(BIQUAD_PEAKING, MID_HZ, mid, MID_Q, rate);
+  }
+  if (treble != 0) {
+    chain.add(BIQUAD_HIGH_SHELF, TREBLE_HZ, treble, SHELF_Q, rate);
+  }
+}
+
+static std::vector<int16_t> sine(float rate, double hz, double amplitude, double seconds) {
+  std::vector<int16_t> samples((size_t)(rate * seconds) * 2);
+  for (size_t n = 0; n < samples.size() / 2; n++) {
+    int16_t value = (int16_t)lrint(amplitude * sin(2 * M_PI * hz * n / rate));
+    samples[n * 2] = value;
+    samples[n * 2 + 1] = value;
+  }
+  return samples;
+}
+
+// Largest difference between a full-scale sine through the chain and
+// twice a half-scale one, once the onset has died away. Rounding noise
+// (doubled) accounts for up to a hundred or so LSB at the lowest
+// pitches; clipping for thousands.
+static int clipDeviation(BiquadChain& chain, float rate, double hz) {
+  std::vector<int16_t> full = sine(rate, hz, 32767, 0.5);
+  std::vector<int16_t> half = sine(rate, hz, 32767 / 2.0, 0.5);
+  chain.reset();
+  chain.process(full.data(), full.size() / 2);
+  chain.reset();
+  chain.process(half.data(), half.size() / 2);
+  
+  int worst = 0;
+  for (size_t i = full.size() / 2; i < full.size(); i++) {
+    int deviation = abs(full[i] - 2 * half[i]);
+    worst = deviation > worst ? deviation : worst;
+  }
+  return worst;
+}
+
+// Octave fractions across the band, plus the band centres themselves
+static std::vector<double> sweep() {
+  std::vector<double> pitches = {BASS_HZ, MID_HZ, TREBLE_HZ};
+  for (double hz = 25; hz < 20000; hz *= 1.12) {
+    pitches.push_back(hz);
+  }
+  return pitches;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testDesignGains() {
+  const float rates[] = {32000, 44100, 48000};
+  for (float rate : rates) {
+    BiquadChain chain;
+    chain.add(BIQUAD_HIGHPASS, HIGHPASS_HZ, 0, SHELF_Q, rate);
+    chain.add(BIQUAD_LOW_SHELF, BASS_HZ, 12, SHELF_Q, rate);
+    chain.add(BIQUAD_PEAKING, MID_HZ, -8, MID_Q, rate);
+    chain.add(BIQUAD_HIGH_SHELF, TREBLE_HZ, 6, SHELF_Q, rate);
+    chain.add(BIQUAD_LOW_SHELF, BASS_HZ, -12, SHELF_Q, rate, 0.5f);
+    CHECK(chain.getCount() == 5);
+    
+    CHECK(near(dcGain(chain.getStage(0)), 0.0));
+    CHECK(near(nyquistGain(chain.getStage(0)), 1.0));
+    CHECK(near(dcGain(chain.getStage(1)), pow(10, 12 / 20.0)));
+    CHECK(near(nyquistGain(chain.getStage(1)), 1.0));
+    CHECK(near(dcGain(chain.getStage(2)), 1.0));
+    CHECK(near(nyquistGain(chain.getStage(2)), 1.0));
+    CHECK(near(dcGain(chain.getStage(3)), 1.0));
+    CHECK(near(nyquistGain(chain.getStage(3)), pow(10, 6 / 20.0)));
+    CHECK(near(dcGain(chain.getStage(4)), 0.5 * pow(10, -12 / 20.0)));
+    CHECK(near(nyquistGain(chain.getStage(4)), 0.5));
+  }
+  
+  // Out of range
+  BiquadChain chain;
+  CHECK(!chain.add(BIQUAD_PEAKING, 24000, 6, 1.0f, 48000));
+  CHECK(!chain.add(BIQUAD_PEAKING, 1000, 6, 1.0f, 0));
+  for (int i = 0; i < BIQUAD_MAX_STAGES; i++) {
+    CHECK(chain.add(BIQUAD_PEAKING, 1000, 6, 1.0f, 48000));
+  }
+  CHECK(!chain.add(BIQUAD_PEAKING, 1000, 6, 1.0f, 48000));
+}
+
+static void testHeadroom() {
+  const float rates[] = {44100, 48000};
+  const int settings[][3] = {
+    {12, 0, 0}, {0, 12, 0}, {0, 0, 12},
+    {12, 12, 0}, {0, 12, 12}, {12, 12, 12}, {12, -12, 12}, {-12, 12, -12}
+  };
+  std::vector<double> pitches = sweep();
+  
+  for (float rate : rates) {
+    for (const auto& setting : settings) {
+      BiquadChain chain;
+      buildToneControl(chain, rate, setting[0], setting[1], setting[2]);
+      CHECK(chain.peakGain(rate) > 2.0f);
+      chain.limitGain(rate);
+      CHECK(chain.peakGain(rate) <= 1.0f + 1e-4f);
+      
+      int worst = 0;
+      for (double hz : pitches) {
+        int deviation = clipDeviation(chain, rate, hz);
+        worst = deviation > worst ? deviation : worst;
+      }
+      CHECK(worst < 256);
+    }
+  }
+  
+  // Without the scaling, the boost clips
+  BiquadChain unscaled;
+  buildToneControl(unscaled, 44100, 0, 12, 0);
+  CHECK(clipDeviation(unscaled, 44100, MID_HZ) > 10000);
+  
+  // Cuts alone leave the level alone
+  BiquadChain cut;
+  buildToneControl(cut, 44100, -6, -6, -6);
+  int32_t b0 = cut.getStage(0).b0;
+  cut.limitGain(44100);
+  CHECK(cut.getStage(0).b0 == b0);
+}
+
+// A quiet low tone through a deep bass boost: without the error
+// feedback the rounding builds up in the shelf's near-DC poles to
+// thousands of LSB, with it to a few
+static double rmsError(bool shaping) {
+  const float rate = 48000;
+  const double hz = 40;
+  const double amplitude = 20;
+  
+  BiquadChain chain;
+  chain.add(BIQUAD_LOW_SHELF, BASS_HZ, 12, SHELF_Q, rate);
+  chain.setNoiseShaping(shaping);
+  std::vector<int16_t> samples = sine(rate, hz, amplitude, 2.0);
+  std::vector<double> input(samples.size() / 2);
+  for (size_t n = 0; n < input.size(); n++) {
+    input[n] = samples[n * 2];
+  }
+  chain.process(samples.data(), samples.size() / 2);
+  
+  // The same stage in double precision from the same coefficients
+  const Biquad& stage = chain.getStage(0);
+  double x1 = 0, x2 = 0, y1 = 0, y2 = 0;
+  double sum = 0;
+  size_t settled = input.size() / 2;
+  for (size_t n = 0; n < input.size(); n++) {
+    double y0 = (stage.b0 * input[n] + stage.b1 * x1 + stage.b2 * x2 -
+                 stage.a1 * y1 - stage.a2 * y2) / UNIT;
+    x2 = x1;
+    x1 = input[n];
+    y2 = y1;
+    y1 = y0;
+    if (n >= settled) {
+      double error = samples[n * 2] - y0;
+      sum += error * error;
+    }
+  }
+  return sqrt(sum / (input.size() - settled));
+}
+
+static void testNoiseShaping() {
+  double shaped = rmsError(true);
+  double truncated = rmsError(false);
+  CHECK(shaped < 16);
+  CHECK(shaped * 100 < truncated);
+}
+
+int main() {
+  testDesignGains();
+  testHeadroom();
+  testNoiseShaping();
+  return HOST_TEST_RESULT();
+}
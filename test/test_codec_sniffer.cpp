@@ -0,0 +1,161 @@
+/**
+ * Codec sniffer host test
+ *
+ * Stream starts built from real frame headers: raw MP3 and ADTS from
+ * a frame boundary and joined mid-frame, the container signatures,
+ * an ID3v2 tag in front, and every truncated prefix of each (which
+ * may say nothing yet, but never the wrong codec).
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include "codec_sniffer.h"
+#include "host_test.h"
+
+#define SNIFF_BYTES 3072            // CODEC_SNIFF_BYTES on the device
+#define MP3_FRAME 417               // MPEG-1 layer III, 128 kbps, 44.1 kHz
+
+typedef std::vector<uint8_t> Bytes;
+
+static void appendMp3Frame(Bytes& out) {
+  const uint8_t header[] = {0xFF, 0xFB, 0x90, 0x64};
+  out.insert(out.end(), header, header + 4);
+  for (size_t i = 4; i < MP3_FRAME; i++) {
+    out.push_back((uint8_t)((i * 13) & 0x7F));   // No sync bytes inside
+  }
+}
+
+// AAC LC, 44.1 kHz, stereo, `length` bytes including the header
+static void appendAdtsFrame(Bytes& out, size_t length) {
+  out.push_back(0xFF);
+  out.push_back(0xF1);
+  out.push_back(0x50);
+  out.push_back((uint8_t)(0x80 | ((length >> 11) & 0x03)));
+  out.push_back((uint8_t)(length >> 3));
+  out.push_back((uint8_t)(((length & 0x07) << 5) | 0x1F));
+  out.push_back(0xFC);
+  for (size_t i = 7; i < length; i++) {
+    out.push_back((uint8_t)(i * 7 % 0xFF));
+  }
+}
+
+static Bytes mp3Stream(size_t frames) {
+  Bytes out;
+  for (size_t i = 0; i < frames; i++) {
+    appendMp3Frame(out);
+  }
+  return out;
+}
+
+static Bytes adtsStream(size_t frames) {
+  Bytes out;
+  for (size_t i = 0; i < frames; i++) {
+    appendAdtsFrame(out, 300 + i * 11);
+  }
+  return out;
+}
+
+static Bytes container(const char* signature, size_t offset) {
+  Bytes out(offset, 0);
+  out.insert(out.end(), signature, signature + strlen(signature));
+  out.resize(64, 0x11);
+  return out;
+}
+
+static Bytes withId3(const Bytes& stream, size_t tagSize) {
+  Bytes out = {'I', 'D', '3', 4, 0, 0};
+  out.push_back((uint8_t)((tagSize >> 21) & 0x7F));
+  out.push_back((uint8_t)((tagSize >> 14) & 0x7F));
+  out.push_back((uint8_t)((tagSize >> 7) & 0x7F));
+  out.push_back((uint8_t)(tagSize & 0x7F));
+  out.insert(out.end(), tagSize, 0);
+  out.insert(out.end(), stream.begin(), stream.end());
+  return out;
+}
+
+static std::string sniff(const Bytes& data, size_t length) {
+  const char* codec = sniffCodec(data.data(), length);
+  return codec != nullptr ? codec : "(none)";
+}
+
+// The whole buffer tells; no prefix of it tells anything else
+static void checkStream(const Bytes& data, const char* expected) {
+  CHECK(sniff(data, data.size()) == expected);
+  size_t wrong = 0;
+  for (size_t length = 0; length < data.size(); length++) {
+    std::string codec = sniff(data, length);
+    if (codec != "(none)" && codec != expected) {
+      wrong++;
+    }
+  }
+  CHECK(wrong == 0);
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testRawFrames() {
+  Bytes mp3 = mp3Stream(4);
+  checkStream(mp3, "mp3");
+  
+  // Two headers are needed: one frame and a byte of the next is not enough
+  CHECK(sniff(mp3, MP3_FRAME + 5) == "(none)");
+  CHECK(sniff(mp3, MP3_FRAME + 6) == "mp3");
+  
+  // Joined mid-frame: the tail of a frame is skipped
+  Bytes joined(mp3.begin() + 150, mp3.end());
+  checkStream(joined, "mp3");
+  
+  Bytes adts = adtsStream(4);
+  checkStream(adts, "aac");
+  Bytes adtsJoined(adts.begin() + 40, adts.end());
+  checkStream(adtsJoined, "aac");
+}
+
+static void testContainers() {
+  checkStream(container("OggS", 0), "ogg");
+  checkStream(container("fLaC", 0), "flac");
+  checkStream(container("ftypM4A ", 4), "m4a");
+  
+  // Signatures only count at the start
+  CHECK(sniff(container("OggS", 5), 64) == "(none)");
+}
+
+static void testId3Prefix() {
+  checkStream(withId3(mp3Stream(3), 600), "mp3");
+  checkStream(withId3(container("fLaC", 0), 200), "flac");
+  
+  // A tag longer than what has arrived: nothing yet, however it looks
+  Bytes longTag = withId3(mp3Stream(3), 4000);
+  CHECK(sniff(longTag, SNIFF_BYTES) == "(none)");
+}
+
+static void testFalseSync() {
+  // Noise with lone frame headers that lead nowhere
+  Bytes noise(SNIFF_BYTES, 0x20);
+  const uint8_t header[] = {0xFF, 0xFB, 0x90, 0x64};
+  for (size_t at = 100; at + 4 < noise.size(); at += 500) {
+    memcpy(noise.data() + at, header, 4);
+  }
+  CHECK(sniff(noise, noise.size()) == "(none)");
+  
+  // A stray ADTS sync early on whose length runs past the buffer must
+  // not hide the MP3 frames behind it
+  Bytes hidden(32, 0x20);
+  const uint8_t stray[] = {0xFF, 0xF1, 0x50, 0x83, 0xFF, 0xFF, 0xFC};
+  memcpy(hidden.data() + 8, stray, sizeof(stray));
+  Bytes frames = mp3Stream(6);
+  hidden.insert(hidden.end(), frames.begin(), frames.end());
+  hidden.resize(SNIFF_BYTES);
+  CHECK(sniff(hidden, hidden.size()) == "mp3");
+}
+
+int main() {
+  testRawFrames();
+  testContainers();
+  testId3Prefix();
+  testFalseSync();
+  return HOST_TEST_RESULT();
+}
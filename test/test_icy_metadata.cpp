@@ -0,0 +1,109 @@
+/**
+ * ICY metadata parser host test
+ *
+ * Each block shape is fed 1, 3 and 1000 bytes at a time, the way
+ * HttpStream hands over whatever the socket returned, and must split
+ * into the same fields every time. Then the title split and the
+ * UTF-8 / Windows-1252 copy.
+ */
+
+#include <string>
+#include "icy_metadata.h"
+#include "host_test.h"
+
+struct BlockCase {
+  const char* block;
+  size_t length;              // Including NUL padding
+  const char* title;          // nullptr = no StreamTitle
+  const char* url;            // nullptr = no StreamUrl
+};
+
+#define BLOCK(text) text, sizeof(text) - 1
+
+static const BlockCase blocks[] = {
+  // Plain title, padded to a multiple of 16 as servers send it
+  {BLOCK("StreamTitle='Artist - Title';\0\0\0"), "Artist - Title", nullptr},
+  // Two fields, no padding
+  {BLOCK("StreamTitle='A';StreamUrl='http://x/y';"), "A", "http://x/y"},
+  // A space between the fields
+  {BLOCK("StreamTitle='X'; StreamUrl='y';\0"), "X", "y"},
+  // Quotes and "';" inside the title survive
+  {BLOCK("StreamTitle='It's a';b'; StreamUrl='u';"), "It's a';b", "u"},
+  // "'; " followed by something that is not a key stays in the value
+  {BLOCK("StreamTitle='a'; b c';\0\0"), "a'; b c", nullptr},
+  // Unquoted values
+  {BLOCK("StreamTitle=Bare;StreamUrl=u;\0\0"), "Bare", "u"},
+  // Closing quote lost to the padding
+  {BLOCK("StreamTitle='Cut\0\0\0\0\0"), "Cut", nullptr},
+  // Empty title, block ends right after the quote
+  {BLOCK("StreamTitle='';StreamUrl='v'"), "", "v"},
+};
+
+static std::string text(IcySpan span) {
+  return span.found() ? std::string(span.data, span.length) : "(absent)";
+}
+
+static void testBlocks() {
+  const size_t feeds[] = {1, 3, 1000};
+  for (const BlockCase& shape : blocks) {
+    for (size_t feed : feeds) {
+      char buffer[64];
+      IcyMetadataParser parser;
+      parser.begin(buffer);
+      for (size_t pos = 0; pos < shape.length; pos += feed) {
+        size_t count = shape.length - pos < feed ? shape.length - pos : feed;
+        memcpy(buffer + pos, shape.block + pos, count);
+        parser.feed(count);
+      }
+      parser.finish();
+      
+      std::string title = text(parser.find("StreamTitle"));
+      std::string url = text(parser.find("StreamUrl"));
+      CHECK_STR(title.c_str(), shape.title ? shape.title : "(absent)");
+      CHECK_STR(url.c_str(), shape.url ? shape.url : "(absent)");
+    }
+  }
+}
+
+static void testSplitTitle() {
+  IcySpan artist, title;
+  const char* both = "Band - Song - Live";
+  icySplitTitle(IcySpan{both, strlen(both)}, artist, title);
+  CHECK(text(artist) == "Band");
+  CHECK(text(title) == "Song - Live");
+  
+  const char* only = "Station jingle";
+  icySplitTitle(IcySpan{only, strlen(only)}, artist, title);
+  CHECK(artist.length == 0);
+  CHECK(text(title) == "Station jingle");
+}
+
+static void testCopyUtf8() {
+  char out[32];
+  
+  // Valid UTF-8 passes through
+  const char* utf8 = "Caf\xC3\xA9";
+  CHECK(icyCopyUtf8(IcySpan{utf8, strlen(utf8)}, out, sizeof(out)) == 5);
+  CHECK_STR(out, "Caf\xC3\xA9");
+  
+  // Anything else is Windows-1252: e-acute and a curly quote
+  const char* legacy = "Caf\xE9 \x93Hi\x94";
+  icyCopyUtf8(IcySpan{legacy, strlen(legacy)}, out, sizeof(out));
+  CHECK_STR(out, "Caf\xC3\xA9 \xE2\x80\x9CHi\xE2\x80\x9D");
+  
+  // Control characters become spaces
+  const char* control = "a\tb";
+  icyCopyUtf8(IcySpan{control, strlen(control)}, out, sizeof(out));
+  CHECK_STR(out, "a b");
+  
+  // Only whole characters fit: the 2-byte one does not
+  CHECK(icyCopyUtf8(IcySpan{utf8, strlen(utf8)}, out, 5) == 3);
+  CHECK_STR(out, "Caf");
+}
+
+int main() {
+  testBlocks();
+  testSplitTitle();
+  testCopyUtf8();
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,290 @@
+/**
+ * ID3v2 parser host test
+ *
+ * Tags of each version are built byte by byte, followed by audio, and
+ * fed 1, 7 and 4096 bytes at a time; every feed size must report the
+ * same text, the same picture and stop at the end of the tag.
+ */
+
+#include <string>
+#include <vector>
+#include "id3_parser.h"
+#include "host_test.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// ============================================================================
+// Tag Builder
+// ============================================================================
+
+static void append(Bytes& out, const Bytes& bytes) {
+  out.insert(out.end(), bytes.begin(), bytes.end());
+}
+
+static void appendText(Bytes& out, const char* text) {
+  out.insert(out.end(), text, text + strlen(text));
+}
+
+static void appendSyncsafe(Bytes& out, size_t value) {
+  for (int shift = 21; shift >= 0; shift -= 7) {
+    out.push_back((uint8_t)((value >> shift) & 0x7F));
+  }
+}
+
+static void appendBigEndian(Bytes& out, size_t value, int count) {
+  for (int i = count - 1; i >= 0; i--) {
+    out.push_back((uint8_t)(value >> (i * 8)));
+  }
+}
+
+static Bytes frame(int version, const char* id, const Bytes& body, uint8_t flags = 0) {
+  Bytes out;
+  appendText(out, id);
+  if (version == 2) {
+    appendBigEndian(out, body.size(), 3);
+  } else {
+    if (version == 3) {
+      appendBigEndian(out, body.size(), 4);
+    } else {
+      appendSyncsafe(out, body.size());
+    }
+    out.push_back(0);
+    out.push_back(flags);
+  }
+  append(out, body);
+  return out;
+}
+
+// Frames, padding, then some audio that must not reach the listener
+static Bytes tag(int version, uint8_t flags, const Bytes& frames, size_t padding = 16) {
+  Bytes out;
+  appendText(out, "ID3");
+  out.push_back((uint8_t)version);
+  out.push_back(0);
+  out.push_back(flags);
+  appendSyncsafe(out, frames.size() + padding);
+  append(out, frames);
+  out.insert(out.end(), padding, 0);
+  const uint8_t audio[] = {0xFF, 0xFB, 0x90, 0x64, 0xAA, 0xBB, 0xCC, 0xDD};
+  out.insert(out.end(), audio, audio + sizeof(audio));
+  return out;
+}
+
+static Bytes latin1(const char* text) {
+  Bytes out = {0};
+  appendText(out, text);
+  return out;
+}
+
+static Bytes image(size_t size) {
+  Bytes out;
+  for (size_t i = 0; i < size; i++) {
+    out.push_back((uint8_t)(i * 31 + 7));
+  }
+  return out;
+}
+
+// ============================================================================
+// Recording Listener
+// ============================================================================
+
+class Recorder : public Id3Listener {
+public:
+  std::string fields[4];
+  std::string mime;
+  int pictureType = -1;
+  size_t announced = 0;
+  Bytes picture;
+  int ends = 0;
+  bool complete = false;
+  
+  void onId3Text(Id3Field field, const char* text) override {
+    fields[field] = text;
+  }
+  
+  bool onId3ImageStart(const char* mimeType, uint8_t type, size_t size) override {
+    mime = mimeType;
+    pictureType = type;
+    announced = size;
+    return true;
+  }
+  
+  void onId3ImageData(const uint8_t* data, size_t length) override {
+    picture.insert(picture.end(), data, data + length);
+  }
+  
+  void onId3ImageEnd(bool done) override {
+    ends++;
+    complete = done;
+  }
+};
+
+// Feed the whole file in pieces; the parser must be done at the end
+static void run(const Bytes& file, size_t piece, Recorder& recorder) {
+  Id3Parser parser(&recorder);
+  for (size_t pos = 0; pos < file.size(); pos += piece) {
+    size_t count = file.size() - pos < piece ? file.size() - pos : piece;
+    parser.feed(file.data() + pos, count);
+  }
+  CHECK(parser.isDone());
+}
+
+static const size_t pieces[] = {1, 7, 4096};
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testVersion22() {
+  Bytes pic = {0};
+  appendText(pic, "PNG");
+  pic.push_back(3);             // Front cover
+  appendText(pic, "cover");
+  pic.push_back(0);
+  append(pic, image(200));
+  
+  Bytes frames;
+  append(frames, frame(2, "TT2", latin1("Two Two")));
+  append(frames, frame(2, "TP1", latin1("Caf\xE9")));
+  append(frames, frame(2, "TCO", latin1("(17)")));
+  append(frames, frame(2, "PIC", pic));
+  Bytes file = tag(2, 0, frames);
+  
+  for (size_t piece : pieces) {
+    Recorder recorder;
+    run(file, piece, recorder);
+    CHECK(recorder.fields[ID3_TITLE] == "Two Two");
+    CHECK(recorder.fields[ID3_ARTIST] == "Caf\xC3\xA9");
+    CHECK(recorder.fields[ID3_GENRE] == "Rock");
+    CHECK(recorder.mime == "image/png");
+    CHECK(recorder.pictureType == 3);
+    CHECK(recorder.announced == 200);
+    CHECK(recorder.picture == image(200));
+    CHECK(recorder.ends == 1 && recorder.complete);
+  }
+}
+
+static void testVersion23() {
+  // UTF-16 with a little-endian BOM: "A" and U+1F3B5 as a surrogate pair
+  Bytes title = {1, 0xFF, 0xFE, 'A', 0, 0x3C, 0xD8, 0xB5, 0xDF, 0, 0};
+  // Big-endian BOM, then a second value that is not shown
+  Bytes artist = {1, 0xFE, 0xFF, 0, 'B', 0, 0xE9, 0, 0, 0, 'x'};
+  
+  Bytes pic = {1};              // UTF-16 description
+  appendText(pic, "image/jpeg");
+  pic.push_back(0);
+  pic.push_back(0);
+  const uint8_t description[] = {0xFF, 0xFE, 'd', 0, 0, 0};
+  pic.insert(pic.end(), description, description + sizeof(description));
+  append(pic, image(1000));
+  
+  Bytes frames;
+  // Extended header: 6 bytes after its own size field
+  appendBigEndian(frames, 6, 4);
+  frames.insert(frames.end(), 6, 0);
+  append(frames, frame(3, "TIT2", title));
+  append(frames, frame(3, "TPE1", artist));
+  append(frames, frame(3, "TXXX", latin1("skipped")));
+  append(frames, frame(3, "TALB", latin1("Compressed"), 0x80));
+  append(frames, frame(3, "TCON", latin1("(17)Indie")));
+  append(frames, frame(3, "APIC", pic));
+  Bytes file = tag(3, 0x40, frames);
+  
+  for (size_t piece : pieces) {
+    Recorder recorder;
+    run(file, piece, recorder);
+    CHECK(recorder.fields[ID3_TITLE] == "A\xF0\x9F\x8E\xB5");
+    CHECK(recorder.fields[ID3_ARTIST] == "B\xC3\xA9");
+    CHECK(recorder.fields[ID3_ALBUM].empty());
+    CHECK(recorder.fields[ID3_GENRE] == "Indie");
+    CHECK(recorder.mime == "image/jpeg");
+    CHECK(recorder.picture == image(1000));
+    CHECK(recorder.ends == 1 && recorder.complete);
+  }
+}
+
+static void testVersion24() {
+  Bytes title = {3};
+  appendText(title, "\xE2\x99\xAA Nota");
+  
+  // Data length indicator: four syncsafe bytes before the text
+  Bytes artist;
+  appendSyncsafe(artist, 6);
+  append(artist, latin1("Artis"));
+  
+  Bytes album = {2, 0, 'L', 0, 'P'};   // UTF-16BE, no BOM
+  
+  Bytes pic = {0};
+  appendText(pic, "image/png");
+  pic.push_back(0);
+  pic.push_back(0);
+  pic.push_back(0);             // Empty description
+  append(pic, image(300));      // Frame size needs two syncsafe bytes
+  
+  Bytes frames;
+  append(frames, frame(4, "TIT2", title));
+  append(frames, frame(4, "TPE1", artist, 0x01));
+  append(frames, frame(4, "TALB", album));
+  append(frames, frame(4, "TCON", latin1("17")));
+  append(frames, frame(4, "APIC", pic));
+  Bytes file = tag(4, 0, frames);
+  
+  for (size_t piece : pieces) {
+    Recorder recorder;
+    run(file, piece, recorder);
+    CHECK(recorder.fields[ID3_TITLE] == "\xE2\x99\xAA Nota");
+    CHECK(recorder.fields[ID3_ARTIST] == "Artis");
+    CHECK(recorder.fields[ID3_ALBUM] == "LP");
+    CHECK(recorder.fields[ID3_GENRE] == "Rock");
+    CHECK(recorder.mime == "image/png");
+    CHECK(recorder.pictureType == 0);
+    CHECK(recorder.picture == image(300));
+    CHECK(recorder.ends == 1 && recorder.complete);
+  }
+}
+
+static void testTruncated() {
+  // The picture frame claims more than is left of the tag
+  Bytes pic = frame(3, "APIC", image(64));
+  pic[7] = 200;
+  
+  Bytes frames;
+  append(frames, frame(3, "TIT2", latin1("Before")));
+  append(frames, pic);
+  Bytes file = tag(3, 0, frames, 0);
+  
+  for (size_t piece : pieces) {
+    Recorder recorder;
+    run(file, piece, recorder);
+    CHECK(recorder.fields[ID3_TITLE] == "Before");
+    CHECK(recorder.announced == 0 && recorder.ends == 0);
+  }
+  
+  // The file ends inside the tag: not done, nothing half-reported
+  Recorder recorder;
+  Id3Parser parser(&recorder);
+  Bytes whole = tag(4, 0, frame(4, "TIT2", latin1("Never finished")));
+  parser.feed(whole.data(), 20);
+  CHECK(!parser.isDone());
+  CHECK(recorder.fields[ID3_TITLE].empty());
+}
+
+static void testNoTag() {
+  const uint8_t mp3[] = {0xFF, 0xFB, 0x90, 0x64, 0, 0, 0, 0, 0, 0, 0, 0};
+  Recorder recorder;
+  run(Bytes(mp3, mp3 + sizeof(mp3)), 1, recorder);
+  
+  // Unsynchronised as a whole: skipped
+  Recorder skipped;
+  run(tag(3, 0x80, frame(3, "TIT2", latin1("Hidden"))), 4096, skipped);
+  CHECK(skipped.fields[ID3_TITLE].empty());
+}
+
+int main() {
+  testVersion22();
+  testVersion23();
+  testVersion24();
+  testTruncated();
+  testNoTag();
+  return HOST_TEST_RESULT();
+}
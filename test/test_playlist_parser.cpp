@@ -0,0 +1,99 @@
+/**
+ * Playlist parser host test
+ *
+ * Format detection, the three playlist formats, and resolution of
+ * absolute, relative, root-relative and protocol-relative entries.
+ */
+
+#include <string>
+#include <vector>
+#include "playlist_parser.h"
+#include "host_test.h"
+
+static std::string resolve(const char* base, const char* entry) {
+  std::string url;
+  return resolvePlaylistEntry(base, entry, url) ? url : "(rejected)";
+}
+
+static void testDetect() {
+  CHECK(detectPlaylistFormat("audio/x-mpegurl", "http://h/x") == PLAYLIST_M3U);
+  CHECK(detectPlaylistFormat("application/vnd.apple.mpegURL", "http://h/x") == PLAYLIST_M3U);
+  CHECK(detectPlaylistFormat("audio/x-scpls", "http://h/x") == PLAYLIST_PLS);
+  CHECK(detectPlaylistFormat("application/xspf+xml", "http://h/x") == PLAYLIST_XSPF);
+  CHECK(detectPlaylistFormat("audio/mpeg", "http://h/list.m3u") == PLAYLIST_NONE);
+  
+  // Generic types fall back to the extension, ignoring the query
+  CHECK(detectPlaylistFormat("text/plain", "http://h/LIST.PLS?id=3") == PLAYLIST_PLS);
+  CHECK(detectPlaylistFormat("", "http://h/live.m3u8") == PLAYLIST_M3U);
+  CHECK(detectPlaylistFormat("application/octet-stream", "http://h/a.xspf") == PLAYLIST_XSPF);
+  CHECK(detectPlaylistFormat("text/plain", "http://h/stream") == PLAYLIST_NONE);
+}
+
+static void testResolve() {
+  const char* base = "http://h/dir/list.m3u";
+  
+  CHECK(resolve(base, "http://other/live") == "http://other/live");
+  CHECK(resolve(base, "  HTTPS://other/live\r") == "HTTPS://other/live");
+  CHECK(resolve(base, "live.mp3") == "http://h/dir/live.mp3");
+  CHECK(resolve(base, "sub/live.mp3") == "http://h/dir/sub/live.mp3");
+  CHECK(resolve(base, "/live.mp3") == "http://h/live.mp3");
+  CHECK(resolve(base, "//cdn/x") == "http://cdn/x");
+  CHECK(resolve("https://h:8443/a/b.pls", "//cdn/x") == "https://cdn/x");
+  CHECK(resolve("https://h:8443/a/b.pls", "/x") == "https://h:8443/x");
+  
+  // No path on the base: the root is the directory
+  CHECK(resolve("http://host", "live.mp3") == "http://host/live.mp3");
+  CHECK(resolve("http://host", "/live.mp3") == "http://host/live.mp3");
+  CHECK(resolve("http://host?list=1", "live.mp3") == "http://host/live.mp3");
+  
+  // A query on the playlist URL is not part of its directory
+  CHECK(resolve("http://h/dir/list.m3u?u=/x/y", "live.mp3") == "http://h/dir/live.mp3");
+  
+  CHECK(resolve(base, "rtsp://h/live") == "(rejected)");
+  CHECK(resolve(base, "   ") == "(rejected)");
+  CHECK(resolve("list.m3u", "live.mp3") == "(rejected)");
+}
+
+static void testParse() {
+  std::vector<std::string> urls;
+  
+  CHECK(parsePlaylist(PLAYLIST_M3U, "http://h/dir/list.m3u",
+                      "#EXTM3U\r\n#EXTINF:-1,Station\r\nhttp://s1/live\r\n\r\nrelative.aac\r\n",
+                      256, urls));
+  CHECK(urls.size() == 2);
+  CHECK(urls.size() == 2 && urls[0] == "http://s1/live");
+  CHECK(urls.size() == 2 && urls[1] == "http://h/dir/relative.aac");
+  
+  // HLS is left to the decoder
+  CHECK(!parsePlaylist(PLAYLIST_M3U, "http://h/a.m3u8",
+                       "#EXTM3U\n#EXT-X-TARGETDURATION:10\nseg1.ts\n", 256, urls));
+  CHECK(urls.empty());
+  
+  CHECK(parsePlaylist(PLAYLIST_PLS, "http://h/x.pls",
+                      "[playlist]\nNumberOfEntries=2\nFile1=http://a/1\nTitle1=One\n"
+                      "file2=/two\nLength1=-1\n", 256, urls));
+  CHECK(urls.size() == 2);
+  CHECK(urls.size() == 2 && urls[0] == "http://a/1");
+  CHECK(urls.size() == 2 && urls[1] == "http://h/two");
+  
+  CHECK(parsePlaylist(PLAYLIST_XSPF, "http://h/x.xspf",
+                      "<playlist><trackList><track><location>http://a/s?x=1&amp;y=2</location>"
+                      "</track><track><location>//cdn/b</location></track></trackList></playlist>",
+                      256, urls));
+  CHECK(urls.size() == 2);
+  CHECK(urls.size() == 2 && urls[0] == "http://a/s?x=1&y=2");
+  CHECK(urls.size() == 2 && urls[1] == "http://cdn/b");
+  
+  // Entries too long for the player are skipped
+  std::string longURL = "http://h/" + std::string(300, 'a');
+  CHECK(!parsePlaylist(PLAYLIST_M3U, "http://h/l.m3u", longURL + "\n", 256, urls));
+  
+  CHECK(!parsePlaylist(PLAYLIST_NONE, "http://h/l", "http://a/1\n", 256, urls));
+}
+
+int main() {
+  testDetect();
+  testResolve();
+  testParse();
+  return HOST_TEST_RESULT();
+}
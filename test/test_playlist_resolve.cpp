@@ -0,0 +1,338 @@
+/**
+ * Playlist resolution host test
+ *
+ * Runs resolvePlaylist() against a stand-in server: canned playlists
+ * and streams per URL, a RouteCache as the route store and a simulated
+ * clock, so chains, loops, TTL expiry and stale routes are checked
+ * without a network or the wait for a TTL.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "playlist_resolve.h"
+#include "host_test.h"
+
+#define OPEN_MS   40                // Simulated request to response headers
+#define TTL_S     3600
+#define ENTRIES   4
+
+struct Response {
+  std::string contentType;
+  std::string body;                 // Playlist text; streams have none
+  bool stalls = false;              // Headers, then nothing
+};
+
+class StandInServer : public ResolveIo {
+public:
+  std::map<std::string, Response> responses;
+  std::vector<std::string> opened;
+  std::vector<std::string> dropped;
+  RouteCache routes;
+  uint32_t clock = 1000;
+  size_t cancelAfterOpens = 0;      // 0 = never
+  
+  StandInServer() : routes(ENTRIES, TTL_S) {}
+  
+  bool open(const std::string& url) override {
+    clock += OPEN_MS;
+    opened.push_back(url);
+    auto found = responses.find(url);
+    current = found != responses.end() ? &found->second : nullptr;
+    served = 0;
+    return current != nullptr;
+  }
+  
+  int read(uint8_t* buffer, size_t length) override {
+    if (current == nullptr) {
+      return -1;
+    }
+    if (current->stalls) {
+      return 0;
+    }
+    if (served >= current->body.size()) {
+      return -1;
+    }
+    size_t count = std::min(length, current->body.size() - served);
+    memcpy(buffer, current->body.data() + served, count);
+    served += count;
+    return (int)count;
+  }
+  
+  void close() override { current = nullptr; }
+  std::string contentType() override { return current ? current->contentType : ""; }
+  
+  bool lookupRoute(const std::string& url, std::string& target) override {
+    return routes.lookup(url, seconds(), target);
+  }
+  
+  void storeRoute(const std::string& url, const std::string& target) override {
+    routes.store(url, target, seconds());
+  }
+  
+  void dropRoute(const std::string& url) override {
+    dropped.push_back(url);
+    routes.invalidate(url);
+  }
+  
+  uint32_t now() override { return clock; }
+  void wait(uint32_t ms) override { clock += ms; }
+  
+  bool cancelled() override {
+    return cancelAfterOpens > 0 && opened.size() >= cancelAfterOpens;
+  }
+  
+  uint32_t seconds() const { return clock / 1000; }
+  
+private:
+  Response* current = nullptr;
+  size_t served = 0;
+};
+
+// The device settings
+static const ResolveLimits limits = {
+  5000,                             // bodyTimeoutMs
+  8192,                             // maxPlaylistSize
+  3,                                // maxDepth
+  256                               // maxURLLength
+};
+
+static Response stream() {
+  Response response;
+  response.contentType = "audio/mpeg";
+  return response;
+}
+
+static Response playlist(const char* contentType, const char* body) {
+  Response response;
+  response.contentType = contentType;
+  response.body = body;
+  return response;
+}
+
+static std::string route(StandInServer& server, const std::string& url) {
+  std::string target;
+  return server.routes.lookup(url, server.seconds(), target) ? target : "(none)";
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testNestedChain() {
+  StandInServer server;
+  server.responses["http://h/radio.m3u"] =
+    playlist("audio/x-mpegurl", "#EXTM3U\n#EXTINF:-1,Radio\n/pls/main.pls\n");
+  server.responses["http://h/pls/main.pls"] =
+    playlist("audio/x-scpls", "[playlist]\nNumberOfEntries=2\nFile1=http://cdn/live\nFile2=http://cdn/backup\n");
+  server.responses["http://cdn/live"] = stream();
+  
+  ResolveResult result;
+  resolvePlaylist(server, "http://h/radio.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  CHECK(result.target == "http://cdn/live");
+  CHECK(result.playlists == 2);
+  CHECK(!result.staleRoute);
+  CHECK(server.opened.size() == 3);
+  CHECK(route(server, "http://h/radio.m3u") == "http://cdn/live");
+  
+  // The next tune-in goes straight to the stream
+  server.opened.clear();
+  resolvePlaylist(server, "http://h/radio.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  CHECK(result.playlists == 0);
+  CHECK(server.opened.size() == 1 && server.opened[0] == "http://cdn/live");
+  
+  // A plain stream is not a route
+  StandInServer direct;
+  direct.responses["http://cdn/live"] = stream();
+  resolvePlaylist(direct, "http://cdn/live", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  CHECK(direct.routes.size() == 0);
+}
+
+static void testLoopsAndDepth() {
+  // Two playlists pointing at each other stop at the depth limit
+  StandInServer loop;
+  loop.responses["http://h/a.m3u"] = playlist("audio/x-mpegurl", "b.pls\n");
+  loop.responses["http://h/b.pls"] = playlist("audio/x-scpls", "[playlist]\nFile1=a.m3u\n");
+  
+  ResolveResult result;
+  resolvePlaylist(loop, "http://h/a.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_PLAYLIST);
+  CHECK(loop.opened.size() == (size_t)limits.maxDepth + 1);
+  CHECK(result.playlists == limits.maxDepth + 1);
+  CHECK(result.target == "http://h/b.pls");
+  CHECK(loop.routes.size() == 0);
+  
+  // A chain exactly as deep as the limit still resolves
+  StandInServer deep;
+  deep.responses["http://h/1.m3u"] = playlist("audio/x-mpegurl", "2.m3u\n");
+  deep.responses["http://h/2.m3u"] = playlist("audio/x-mpegurl", "3.m3u\n");
+  deep.responses["http://h/3.m3u"] = playlist("audio/x-mpegurl", "live\n");
+  deep.responses["http://h/live"] = stream();
+  resolvePlaylist(deep, "http://h/1.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  CHECK(result.playlists == limits.maxDepth);
+  
+  // One more is too deep
+  deep.responses["http://h/0.m3u"] = playlist("audio/x-mpegurl", "1.m3u\n");
+  resolvePlaylist(deep, "http://h/0.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_PLAYLIST);
+  CHECK(result.target == "http://h/3.m3u");
+  
+  // HLS: nothing to follow, the decoder's client takes over
+  StandInServer hls;
+  hls.responses["http://h/live.m3u8"] =
+    playlist("application/vnd.apple.mpegurl", "#EXTM3U\n#EXT-X-TARGETDURATION:6\nseg1.ts\n");
+  resolvePlaylist(hls, "http://h/live.m3u8", limits, result);
+  CHECK(result.outcome == RESOLVE_PLAYLIST);
+  CHECK(result.target == "http://h/live.m3u8");
+}
+
+static void testExpiry() {
+  StandInServer server;
+  server.responses["http://h/list.pls"] = playlist("audio/x-scpls", "[playlist]\nFile1=http://cdn/one\n");
+  server.responses["http://cdn/one"] = stream();
+  server.responses["http://cdn/two"] = stream();
+  
+  ResolveResult result;
+  resolvePlaylist(server, "http://h/list.pls", limits, result);
+  CHECK(route(server, "http://h/list.pls") == "http://cdn/one");
+  
+  // Still fresh just before the TTL runs out
+  server.clock += (TTL_S - 5) * 1000;
+  server.opened.clear();
+  resolvePlaylist(server, "http://h/list.pls", limits, result);
+  CHECK(server.opened.size() == 1);
+  
+  // Expired: the playlist is read again, and may say something new
+  server.responses["http://h/list.pls"].body = "[playlist]\nFile1=http://cdn/two\n";
+  server.clock += 10 * 1000;
+  CHECK(server.routes.expire(server.seconds()) == 1);
+  server.opened.clear();
+  resolvePlaylist(server, "http://h/list.pls", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  CHECK(result.target == "http://cdn/two");
+  CHECK(server.opened.size() == 2);
+  CHECK(route(server, "http://h/list.pls") == "http://cdn/two");
+  
+  // Lookups alone do not need expire() to skip a stale entry
+  server.clock += (TTL_S + 1) * 1000;
+  std::string target;
+  CHECK(!server.routes.lookup("http://h/list.pls", server.seconds(), target));
+}
+
+static void testStaleRoute() {
+  // The cached stream moved: the route is dropped and replaced
+  StandInServer server;
+  server.routes.store("http://h/list.m3u", "http://gone/live", server.seconds());
+  server.responses["http://h/list.m3u"] = playlist("audio/x-mpegurl", "http://new/live\n");
+  server.responses["http://new/live"] = stream();
+  
+  ResolveResult result;
+  resolvePlaylist(server, "http://h/list.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  CHECK(result.staleRoute);
+  CHECK(result.target == "http://new/live");
+  CHECK(server.dropped.size() == 1 && server.dropped[0] == "http://h/list.m3u");
+  CHECK(server.opened.size() == 3);
+  CHECK(route(server, "http://h/list.m3u") == "http://new/live");
+  
+  // The stale attempt does not use up a level of the depth limit
+  StandInServer deep;
+  deep.routes.store("http://h/1.m3u", "http://gone/live", deep.seconds());
+  deep.responses["http://h/1.m3u"] = playlist("audio/x-mpegurl", "2.m3u\n");
+  deep.responses["http://h/2.m3u"] = playlist("audio/x-mpegurl", "3.m3u\n");
+  deep.responses["http://h/3.m3u"] = playlist("audio/x-mpegurl", "live\n");
+  deep.responses["http://h/live"] = stream();
+  resolvePlaylist(deep, "http://h/1.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_STREAM);
+  
+  // Station gone altogether: the route stays forgotten
+  StandInServer gone;
+  gone.routes.store("http://h/list.m3u", "http://gone/live", gone.seconds());
+  resolvePlaylist(gone, "http://h/list.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_FAILED);
+  CHECK(result.target == "http://h/list.m3u");
+  CHECK(gone.opened.size() == 2);
+  CHECK(gone.routes.size() == 0);
+  
+  // Dead entry in a playlist: no route stored
+  StandInServer dead;
+  dead.responses["http://h/c.m3u"] = playlist("audio/x-mpegurl", "http://nowhere/live\n");
+  resolvePlaylist(dead, "http://h/c.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_FAILED);
+  CHECK(result.target == "http://nowhere/live");
+  CHECK(dead.routes.size() == 0);
+}
+
+static void testStallAndCancel() {
+  // A playlist server that never sends the body gives up after the timeout
+  StandInServer stalled;
+  stalled.responses["http://h/b.pls"] = playlist("audio/x-scpls", "");
+  stalled.responses["http://h/b.pls"].stalls = true;
+  uint32_t start = stalled.clock;
+  ResolveResult result;
+  resolvePlaylist(stalled, "http://h/b.pls", limits, result);
+  CHECK(result.outcome == RESOLVE_PLAYLIST);
+  CHECK(stalled.clock - start > limits.bodyTimeoutMs);
+  CHECK(stalled.clock - start <= limits.bodyTimeoutMs + OPEN_MS + 5);
+  
+  // A newer tune-in while the playlist is read: nothing is stored
+  StandInServer cancelled;
+  cancelled.responses["http://h/a.m3u"] = playlist("audio/x-mpegurl", "b.m3u\n");
+  cancelled.responses["http://h/b.m3u"] = playlist("audio/x-mpegurl", "live\n");
+  cancelled.responses["http://h/live"] = stream();
+  cancelled.cancelAfterOpens = 2;
+  resolvePlaylist(cancelled, "http://h/a.m3u", limits, result);
+  CHECK(result.outcome == RESOLVE_CANCELLED);
+  CHECK(cancelled.opened.size() == 2);
+  CHECK(cancelled.routes.size() == 0);
+}
+
+static void testCacheLimits() {
+  RouteCache cache(ENTRIES, TTL_S);
+  for (uint32_t i = 0; i < ENTRIES; i++) {
+    cache.store("http://h/" + std::to_string(i), "http://cdn/" + std::to_string(i), 100 + i);
+  }
+  CHECK(cache.size() == ENTRIES);
+  
+  // Full: the entry closest to expiry makes room
+  cache.store("http://h/new", "http://cdn/new", 200);
+  CHECK(cache.size() == ENTRIES);
+  std::string target;
+  CHECK(!cache.lookup("http://h/0", 200, target));
+  CHECK(cache.lookup("http://h/1", 200, target) && target == "http://cdn/1");
+  
+  // Storing again refreshes instead of adding
+  cache.store("http://h/1", "http://cdn/moved", 300);
+  CHECK(cache.size() == ENTRIES);
+  CHECK(cache.lookup("http://h/1", 300 + TTL_S - 1, target) && target == "http://cdn/moved");
+  CHECK(cache.expire(300 + TTL_S - 1) == ENTRIES - 1);
+  
+  // Saved entries keep what was left of their TTL, at most a full one
+  RouteCache loaded(ENTRIES, TTL_S);
+  loaded.restore("http://h/a", "http://cdn/a", 60, 0);
+  loaded.restore("http://h/b", "http://cdn/b", 10 * TTL_S, 0);
+  loaded.restore("http://h/c", "http://cdn/c", 0, 0);
+  CHECK(loaded.size() == 2);
+  CHECK(loaded.lookup("http://h/a", 59, target));
+  CHECK(!loaded.lookup("http://h/a", 60, target));
+  CHECK(!loaded.lookup("http://h/b", TTL_S, target));
+  
+  CHECK(loaded.invalidate("http://h/b"));
+  CHECK(!loaded.invalidate("http://h/b"));
+}
+
+int main() {
+  testNestedChain();
+  testLoopsAndDepth();
+  testExpiry();
+  testStaleRoute();
+  testStallAndCancel();
+  testCacheLimits();
+  return HOST_TEST_RESULT();
+}
@@ -0,0 +1,136 @@
+/**
+ * Seqlock mailbox host test
+ *
+ * Two writer threads and a reader hammer one mailbox: every copy the
+ * reader gets must be whole (all fields from the same write) and the
+ * change counter must only move forward. Then the single-threaded
+ * rules: unchanged writes do not count, and an edit sees the current
+ * value, which is how a late write for an older play session is
+ * dropped.
+ */
+
+#include <atomic>
+#include <thread>
+#include "seqlock_mailbox.h"
+#include "host_test.h"
+
+#define WRITES 100000
+
+struct Sample {
+  uint32_t words[64];             // All equal in every write
+};
+
+struct Status {
+  uint32_t session;
+  bool failed;
+  char error[16];
+};
+
+static void testTornReads() {
+  SeqlockMailbox<Sample> box;
+  std::atomic<bool> done(false);
+  
+  auto writer = [&box](uint32_t base) {
+    for (uint32_t i = 1; i <= WRITES; i++) {
+      box.publish([base, i](Sample& next) {
+        for (uint32_t& word : next.words) {
+          word = base + i;
+        }
+      });
+    }
+  };
+  
+  size_t torn = 0;
+  size_t backwards = 0;
+  size_t reads = 0;
+  std::thread reader([&]() {
+    uint32_t lastVersion = 0;
+    Sample copy;
+    while (!done.load()) {
+      uint32_t version = box.read(copy);
+      for (uint32_t word : copy.words) {
+        if (word != copy.words[0]) {
+          torn++;
+          break;
+        }
+      }
+      if (version < lastVersion) {
+        backwards++;
+      }
+      lastVersion = version;
+      reads++;
+    }
+  });
+  
+  std::thread first(writer, 0);
+  std::thread second(writer, 1000000);
+  first.join();
+  second.join();
+  done = true;
+  reader.join();
+  
+  CHECK(torn == 0);
+  CHECK(backwards == 0);
+  CHECK(reads > 0);
+  CHECK(box.version() == 2 * WRITES);
+}
+
+static void testUnchangedWrites() {
+  SeqlockMailbox<Status> box;
+  box.publish([](Status& next) { next.session = 1; });
+  CHECK(box.version() == 1);
+  box.publish([](Status& next) { next.session = 1; });
+  CHECK(box.version() == 1);
+  box.publish([](Status&) {});
+  CHECK(box.version() == 1);
+}
+
+// The AudioPlayer pattern: newer sessions win, older ones are ignored
+static void post(SeqlockMailbox<Status>& box, uint32_t session, const char* error) {
+  box.publish([=](Status& next) {
+    if ((int32_t)(session - next.session) < 0) {
+      return;
+    }
+    if (session != next.session) {
+      memset(&next, 0, sizeof(next));
+      next.session = session;
+    }
+    strncpy(next.error, error, sizeof(next.error) - 1);
+    next.failed = true;
+  });
+}
+
+static void testSessions() {
+  SeqlockMailbox<Status> box;
+  Status status;
+  
+  post(box, 2, "new station");
+  uint32_t version = box.version();
+  post(box, 1, "old station");
+  CHECK(box.version() == version);
+  box.read(status);
+  CHECK(status.session == 2);
+  CHECK_STR(status.error, "new station");
+  
+  // A newer session starts from a clean status
+  post(box, 3, "x");
+  box.read(status);
+  CHECK(status.session == 3);
+  CHECK_STR(status.error, "x");
+  
+  // Ordering holds across the counter wrapping
+  SeqlockMailbox<Status> wrap;
+  post(wrap, 0xFFFFFFFF, "before wrap");
+  post(wrap, 0, "after wrap");
+  post(wrap, 0xFFFFFFFE, "late");
+  wrap.read(status);
+  CHECK(status.session == 0);
+  CHECK_STR(status.error, "after wrap");
+}
+
+int main() {
+  testTornReads();
+  testUnchangedWrites();
+  testSessions();
+  return HOST_TEST_RESULT();
+}
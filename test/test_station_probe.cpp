@@ -0,0 +1,298 @@
+/**
+ * Station probe host test
+ *
+ * Runs probeStation() against a stand-in server: canned responses per
+ * URL (streams, playlists, stalls), a route cache and a simulated
+ * clock, so pacing and timeouts are checked without waiting for them.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+#include "station_probe.h"
+#include "host_test.h"
+
+#define OPEN_MS 40                  // Simulated request to response headers
+
+struct Response {
+  std::string contentType;
+  bool stream = false;              // Endless audio instead of `body`
+  std::string body;                 // Playlist text
+  size_t metaInterval = 0;          // Audio bytes before the first ICY block
+  std::string metadata;             // That block
+  int bitrate = 0;
+  bool chunked = false;
+  size_t trickle = 700;             // Bytes per read, 0 = the server stalls
+};
+
+class StandInServer : public ProbeIo {
+public:
+  std::map<std::string, Response> responses;
+  std::map<std::string, std::string> routes;
+  std::vector<std::string> opened;
+  uint32_t clock = 1000;
+  size_t audioRead = 0;
+  
+  bool open(const std::string& url) override {
+    clock += OPEN_MS;
+    opened.push_back(url);
+    auto found = responses.find(url);
+    current = found != responses.end() ? &found->second : nullptr;
+    served = 0;
+    blockSeen = false;
+    return current != nullptr;
+  }
+  
+  int read(uint8_t* buffer, size_t length) override {
+    if (current == nullptr) {
+      return -1;
+    }
+    if (current->trickle == 0) {
+      return 0;
+    }
+    
+    size_t count = current->trickle < length ? current->trickle : length;
+    if (!current->stream) {
+      if (served >= current->body.size()) {
+        return -1;
+      }
+      count = std::min(count, current->body.size() - served);
+      memcpy(buffer, current->body.data() + served, count);
+      served += count;
+      return (int)count;
+    }
+    
+    // The demux strips the block at metaint and parses it
+    if (current->metaInterval > 0 && !blockSeen) {
+      count = std::min(count, current->metaInterval - served);
+    }
+    memset(buffer, 0x55, count);
+    served += count;
+    audioRead += count;
+    if (current->metaInterval > 0 && served == current->metaInterval && !blockSeen) {
+      blockSeen = true;
+      memcpy(block, current->metadata.data(), current->metadata.size());
+      parser.begin(block);
+      parser.feed(current->metadata.size());
+      parser.finish();
+    }
+    return (int)count;
+  }
+  
+  void close() override { current = nullptr; }
+  std::string contentType() override { return current ? current->contentType : ""; }
+  bool isChunked() override { return current && current->chunked; }
+  int bitrate() override { return current ? current->bitrate : 0; }
+  size_t metaInterval() override { return current ? current->metaInterval : 0; }
+  const IcyMetadataParser* metadata() override { return blockSeen ? &parser : nullptr; }
+  
+  bool lookupRoute(const std::string& url, std::string& target) override {
+    auto found = routes.find(url);
+    if (found == routes.end()) {
+      return false;
+    }
+    target = found->second;
+    return true;
+  }
+  
+  void storeRoute(const std::string& url, const std::string& target) override {
+    routes[url] = target;
+  }
+  
+  void dropRoute(const std::string& url) override { routes.erase(url); }
+  
+  uint32_t now() override { return clock; }
+  void wait(uint32_t ms) override { clock += ms; }
+  bool cancelled() override { return false; }
+  
+private:
+  Response* current = nullptr;
+  size_t served = 0;
+  bool blockSeen = false;
+  char block[256];
+  IcyMetadataParser parser;
+};
+
+// The device settings, but a small title buffer to check the cut
+static const ProbeLimits limits = {
+  5000,                             // connectTimeoutMs
+  5000,                             // titleTimeoutMs
+  24 * 1024,                        // maxBytes
+  8 * 1024,                         // bytesPerSecond
+  8192,                             // maxPlaylistSize
+  3,                                // maxDepth
+  256,                              // maxURLLength
+  16                                // titleSize
+};
+
+static Response stream(size_t metaInterval, const char* title) {
+  Response response;
+  response.contentType = "audio/mpeg";
+  response.stream = true;
+  response.bitrate = 128;
+  response.metaInterval = metaInterval;
+  response.metadata = std::string("StreamTitle='") + title + "';";
+  return response;
+}
+
+static Response playlist(const char* contentType, const char* body) {
+  Response response;
+  response.contentType = contentType;
+  response.body = body;
+  return response;
+}
+
+// ============================================================================
+// Tests
+// ============================================================================
+
+static void testDirectStream() {
+  StandInServer server;
+  server.responses["http://radio/live"] = stream(8192, "Band - Song");
+  
+  ProbeReport report;
+  uint32_t start = server.clock;
+  probeStation(server, "http://radio/live", limits, report);
+  
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(report.latencyMs == OPEN_MS);
+  CHECK(report.contentType == "audio/mpeg");
+  CHECK(report.bitrate == 128);
+  CHECK(report.title == "Band - Song");
+  CHECK(server.routes.empty());
+  
+  // 8 KiB of audio at 8 KiB/s: about a second, not a burst
+  CHECK(server.audioRead == 8192);
+  CHECK(server.clock - start >= OPEN_MS + 990);
+  CHECK(server.clock - start <= OPEN_MS + 1100);
+}
+
+static void testPlaylistChain() {
+  StandInServer server;
+  server.responses["http://h/dir/list.pls"] =
+    playlist("audio/x-scpls", "[playlist]\nNumberOfEntries=1\nFile1=/m3u/next.m3u\n");
+  server.responses["http://h/m3u/next.m3u"] =
+    playlist("audio/x-mpegurl", "#EXTM3U\n#EXTINF:-1,Live\nlive.mp3\n");
+  server.responses["http://h/m3u/live.mp3"] = stream(1024, "Now");
+  
+  ProbeReport report;
+  probeStation(server, "http://h/dir/list.pls", limits, report);
+  
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(report.title == "Now");
+  CHECK(server.opened.size() == 3);
+  CHECK(report.latencyMs >= 3 * OPEN_MS);
+  CHECK(server.routes["http://h/dir/list.pls"] == "http://h/m3u/live.mp3");
+}
+
+static void testCachedRoute() {
+  StandInServer server;
+  server.routes["http://h/list.m3u"] = "http://cdn/live";
+  server.responses["http://cdn/live"] = stream(0, "");
+  
+  ProbeReport report;
+  probeStation(server, "http://h/list.m3u", limits, report);
+  
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(server.opened.size() == 1 && server.opened[0] == "http://cdn/live");
+  CHECK(report.title.empty());
+  CHECK(server.audioRead == 0);             // No metadata: nothing to wait for
+}
+
+static void testStaleRoute() {
+  StandInServer server;
+  server.routes["http://h/list.m3u"] = "http://gone/live";
+  server.responses["http://h/list.m3u"] = playlist("audio/x-mpegurl", "http://new/live\n");
+  server.responses["http://new/live"] = stream(0, "");
+  
+  ProbeReport report;
+  probeStation(server, "http://h/list.m3u", limits, report);
+  
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(server.opened.size() == 3);
+  CHECK(server.routes["http://h/list.m3u"] == "http://new/live");
+}
+
+static void testPlaylistOnly() {
+  // HLS: the playlist answers, the decoder would take it from there
+  StandInServer server;
+  server.responses["http://h/live.m3u8"] =
+    playlist("application/vnd.apple.mpegurl", "#EXTM3U\n#EXT-X-TARGETDURATION:6\nseg1.ts\n");
+  
+  ProbeReport report;
+  probeStation(server, "http://h/live.m3u8", limits, report);
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(report.contentType.empty());
+  CHECK(server.routes.empty());
+  
+  // A playlist pointing at itself stops at the depth limit
+  StandInServer loop;
+  loop.responses["http://h/a.m3u"] = playlist("audio/x-mpegurl", "a.m3u\n");
+  probeStation(loop, "http://h/a.m3u", limits, report);
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(loop.opened.size() == (size_t)limits.maxDepth + 1);
+  
+  // A playlist server that never sends the body
+  StandInServer stalled;
+  stalled.responses["http://h/b.pls"] = playlist("audio/x-scpls", "");
+  stalled.responses["http://h/b.pls"].trickle = 0;
+  uint32_t start = stalled.clock;
+  probeStation(stalled, "http://h/b.pls", limits, report);
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(stalled.clock - start > limits.connectTimeoutMs);
+  CHECK(stalled.opened.size() == 1);
+}
+
+static void testDead() {
+  StandInServer server;
+  ProbeReport report;
+  probeStation(server, "http://nowhere/live", limits, report);
+  CHECK(report.state == PROBE_DEAD);
+  CHECK(server.opened.size() == 1);
+  
+  // Dead entry in a playlist
+  server.responses["http://h/c.m3u"] = playlist("audio/x-mpegurl", "http://nowhere/live\n");
+  probeStation(server, "http://h/c.m3u", limits, report);
+  CHECK(report.state == PROBE_DEAD);
+}
+
+static void testTitleLimits() {
+  // First title beyond the byte budget: not read at all
+  StandInServer far;
+  far.responses["http://h/live"] = stream(64 * 1024, "Far");
+  ProbeReport report;
+  probeStation(far, "http://h/live", limits, report);
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(report.title.empty());
+  CHECK(far.audioRead == 0);
+  
+  // A stream that stalls gives up after the title timeout
+  StandInServer stalled;
+  stalled.responses["http://h/live"] = stream(4096, "Never");
+  stalled.responses["http://h/live"].trickle = 0;
+  uint32_t start = stalled.clock;
+  probeStation(stalled, "http://h/live", limits, report);
+  CHECK(report.state == PROBE_ALIVE);
+  CHECK(report.title.empty());
+  CHECK(stalled.clock - start >= limits.titleTimeoutMs);
+  CHECK(stalled.clock - start <= limits.titleTimeoutMs + OPEN_MS + 20);
+  
+  // Cut to the title buffer on a character boundary
+  StandInServer cut;
+  cut.responses["http://h/live"] = stream(512, "Jam Session Caf\xC3\xA9");
+  probeStation(cut, "http://h/live", limits, report);
+  CHECK(report.title == "Jam Session Caf");
+}
+
+int main() {
+  testDirectStream();
+  testPlaylistChain();
+  testCachedRoute();
+  testStaleRoute();
+  testPlaylistOnly();
+  testDead();
+  testTitleLimits();
+  return HOST_TEST_RESULT();
+}